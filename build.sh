@@ -15,6 +15,7 @@ SRC="${DIR}src/main.c\
  ${DIR}src/WindowInterface.c\
  ${DIR}src/Vulkan/VulkanLayer.c\
  ${DIR}src/LuaLayer.c\
+ ${DIR}src/LuaJson.c\
  ${DIR}src/tlsf.c\
  ${DIR}src/ProcessIO.c"
 OBJ="${DIR}bin/main.o\
@@ -22,11 +23,19 @@ OBJ="${DIR}bin/main.o\
  ${DIR}bin/VulkanLayer.o\
  ${DIR}bin/ProcessIO.o\
  ${DIR}bin/LuaLayer.o\
+ ${DIR}bin/LuaJson.o\
  ${DIR}bin/tlsf.o"
 
 SRCPP="${DIR}src/Gui/GuiLayer.cpp\
  ${DIR}src/Gui/ImguiToLua.cpp\
- ${DIR}src/Frontend/GdbFE.cpp"
+ ${DIR}src/Gui/LuaProfiler.cpp\
+ ${DIR}src/Frontend/GdbFE.cpp\
+ ${DIR}src/Frontend/MiParser.cpp\
+ ${DIR}src/Frontend/SessionJournal.cpp\
+ ${DIR}src/Frontend/SourceView.cpp\
+ ${DIR}src/Frontend/SourceLexer.cpp\
+ ${DIR}src/Frontend/SourceSearch.cpp\
+ ${DIR}src/Frontend/FuzzyFinder.cpp"
 SRCPP2="${DIR}imgui/imgui_impl_vulkan.cpp\
  ${DIR}imgui/imgui_widgets.cpp\
  ${DIR}imgui/imgui_tables.cpp\
@@ -37,9 +46,16 @@ SRCPP2="${DIR}imgui/imgui_impl_vulkan.cpp\
  ${DIR}src/Frontend/TextEditor.cpp"
 OBJPP="${DIR}bin/GuiLayer.o\
  ${DIR}bin/ImguiToLua.o\
+ ${DIR}bin/LuaProfiler.o\
  ${DIR}bin/TextEditor.o\
  ${DIR}bin/ImGuiFileBrowser.o\
  ${DIR}bin/GdbFE.o\
+ ${DIR}bin/MiParser.o\
+ ${DIR}bin/SessionJournal.o\
+ ${DIR}bin/SourceView.o\
+ ${DIR}bin/SourceLexer.o\
+ ${DIR}bin/SourceSearch.o\
+ ${DIR}bin/FuzzyFinder.o\
  ${DIR}bin/imgui_impl_vulkan.o\
  ${DIR}bin/imgui_widgets.o\
  ${DIR}bin/imgui_tables.o\
@@ -48,7 +64,7 @@ OBJPP="${DIR}bin/GuiLayer.o\
  ${DIR}bin/imgui.o"
 
 ILIB="-L${DIR}lua-5.4.2/src/"
-LIB="-lm -ldl -lX11 -lxcb -lxcb-icccm -lxcb-keysyms -lxcb-xinput -llua"
+LIB="-lm -ldl -lX11 -lxcb -lxcb-icccm -lxcb-keysyms -lxcb-xinput -llua -lpthread"
 DEF="-DVK_NO_PROTOTYPES"
 
 # build lua if necessary
@@ -80,9 +96,12 @@ echo "ld -r -b binary /tmp/imguisettings.ini -o /tmp/imguisettings.o"
 
 # create luac program and generate linkable object file
 "${DIR}lua-5.4.2/install/bin/luac" -o ${DIR}/src/ProgramLayer/prog.luac\
- ${DIR}src/ProgramLayer/JSON.lua\
+ ${DIR}src/ProgramLayer/JsonLua.lua\
+ ${DIR}src/ProgramLayer/Session.lua\
  ${DIR}src/ProgramLayer/GdbData.lua\
  ${DIR}src/ProgramLayer/GuiRender.lua\
+ ${DIR}src/ProgramLayer/Benchmarks.lua\
+ ${DIR}src/ProgramLayer/BenchScenario.lua\
  ${DIR}src/ProgramLayer/AppMain.lua
 
 cp ${DIR}src/ProgramLayer/prog.luac /tmp/prog.luac
@@ -92,6 +111,19 @@ echo "ld -r -b binary /tmp/prog.luac -o prog.o"
 # PROG=$(<${DIR}/src/ProgramLayer/prog.luac)
 g++ ${OBJ} ${OBJPP} /tmp/prog.o /tmp/imguisettings.o ${ILIB} ${LIB} -o${OUT}
 
+# stand-in gdb serving recorded MI sessions (--record)
+echo "gcc ${INC} ${WRN} ${DBG} MiReplay.c -o${DIR}bin/MiReplay"
+gcc ${INC} ${WRN} ${DBG} ${DIR}src/Tools/MiReplay.c\
+ ${DIR}bin/ProcessIO.o ${DIR}bin/tlsf.o -o${DIR}bin/MiReplay
+
+# colours of the source viewer's lexers, run bin/SourceLexerTest
+echo "g++ ${INC} ${WRN} ${DBG} ${DEF} SourceLexerTest.cpp -o${DIR}bin/SourceLexerTest"
+g++ ${INC} ${WRN} ${DBG} ${DEF} ${DIR}src/Tools/SourceLexerTest.cpp\
+ ${DIR}bin/SourceView.o ${DIR}bin/SourceLexer.o ${DIR}bin/TextEditor.o\
+ ${DIR}bin/imgui.o ${DIR}bin/imgui_draw.o ${DIR}bin/imgui_widgets.o\
+ ${DIR}bin/imgui_tables.o ${DIR}bin/ProcessIO.o ${DIR}bin/tlsf.o\
+ -lpthread -o${DIR}bin/SourceLexerTest
+
 
 cd ${DIR}
 
@@ -0,0 +1,28 @@
+#!/usr/bin/env bash
+
+# Runs a benchmark scenario headless against /usr/bin/gdb & the sample
+# inferior, then prints the JSON report.
+#   ./bench.sh [scenario.json] [report.json]
+
+DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" >/dev/null 2>&1 && pwd )/"
+APP="${DIR}../../bin/GdbVkGui"
+
+SCENARIO="${1:-${DIR}step.json}"
+REPORT="${2:-${DIR}bench.json}"
+
+if [[ ! -x "${APP}" ]]; then
+	echo "Build the app first (build.sh): ${APP} not found"
+	exit 1
+fi
+
+# the inferior is built w/o optimizations so every line can be stepped
+gcc -g -O0 -o "${DIR}sample" "${DIR}sample.c" || exit 1
+
+# keep sessions & settings of the benchmark away from the user's
+BENCH_HOME=$(mktemp -d)
+trap 'rm -rf "${BENCH_HOME}"' EXIT
+
+HOME="${BENCH_HOME}" "${APP}" --bench "${SCENARIO}" --bench-out "${REPORT}" \
+	|| exit 1
+
+cat "${REPORT}"
@@ -0,0 +1,88 @@
+// Sample inferior for bench.sh : a loop w/ a few locals, nested calls to step
+// into and a global buffer for the memory view
+
+#include <stdio.h>
+#include <string.h>
+
+typedef struct Particle
+{
+    float pos[2];
+    float vel[2];
+    int   id;
+} Particle;
+
+#define PARTICLE_COUNT 64
+#define GRID_SZ 16
+
+static Particle      particles[PARTICLE_COUNT];
+static unsigned char grid[GRID_SZ * GRID_SZ];
+
+static float
+Clamp(float v, float lo, float hi)
+{
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static void
+Integrate(Particle* p, float dt)
+{
+    p->pos[0] = Clamp(p->pos[0] + p->vel[0] * dt, 0.f, GRID_SZ - 1);
+    p->pos[1] = Clamp(p->pos[1] + p->vel[1] * dt, 0.f, GRID_SZ - 1);
+    if (p->pos[0] <= 0.f || p->pos[0] >= GRID_SZ - 1) {
+        p->vel[0] = -p->vel[0];
+    }
+    if (p->pos[1] <= 0.f || p->pos[1] >= GRID_SZ - 1) {
+        p->vel[1] = -p->vel[1];
+    }
+}
+
+static int
+Rasterize(void)
+{
+    int hits = 0;
+    memset(grid, 0, sizeof(grid));
+    for (int i = 0; i < PARTICLE_COUNT; i++) {
+        int x = (int)particles[i].pos[0];
+        int y = (int)particles[i].pos[1];
+        hits += grid[y * GRID_SZ + x]++ > 0;
+    }
+    return hits;
+}
+
+// only runs once the loop is done, breakpoints here don't interrupt stepping
+static void
+Summary(int collisions)
+{
+    int occupied = 0;
+    for (int i = 0; i < GRID_SZ * GRID_SZ; i++) {
+        occupied += grid[i] != 0;
+    }
+    printf("collisions %d\n", collisions);
+    printf("occupied cells %d / %d\n", occupied, GRID_SZ * GRID_SZ);
+}
+
+int
+main(void)
+{
+    for (int i = 0; i < PARTICLE_COUNT; i++) {
+        particles[i].id     = i;
+        particles[i].pos[0] = (float)(i % GRID_SZ);
+        particles[i].pos[1] = (float)(i / GRID_SZ);
+        particles[i].vel[0] = 0.5f + (i % 3);
+        particles[i].vel[1] = 1.5f - (i % 5);
+    }
+
+    int   collisions = 0;
+    float dt         = 1.f / 60.f;
+    for (int frame = 0; frame < 100000; frame++) {
+        for (int i = 0; i < PARTICLE_COUNT; i++) {
+            Integrate(&particles[i], dt);
+        }
+        collisions += Rasterize();
+        if (frame % 1000 == 0) {
+            printf("frame %d collisions %d\n", frame, collisions);
+        }
+    }
+    Summary(collisions);
+    return collisions > 0 ? 0 : 1;
+}
@@ -0,0 +1,905 @@
+#include "Frontend/FuzzyFinder.h"
+#include "Frontend/MiParser.h"
+#include "ProcessIO.h"
+#include "lua.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <ctype.h>
+#include <deque>
+#include <elf.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+// Ctrl-P finder. Entries are the source files (-file-list-exec-source-files)
+// & functions (-symbol-info-functions) of the inferior. Each name is lowered
+// & cut in trigrams over a 38 letter alphabet, along w/ the trigrams of its
+// initials (GetSourceView : gsv) & a key for its first two letters. Every key
+// has the ids of the entries holding it in ascending order. A query counts
+// how many of its trigrams each entry shares, then only the entries w/ the
+// most are scored as a fuzzy subsequence match. Queries shorter than a
+// trigram only look at the entries starting w/ them. Replies are parsed &
+// indexed by the worker in chunks so queries can run (under the lock) while
+// the index grows. The finished index is written as is, loading it back
+// needs no parsing
+
+#define FINDER_ALPHABET  38 // 0 : anything else, a-z, 0-9, '_'
+#define FINDER_TRIGRAMS  (FINDER_ALPHABET * FINDER_ALPHABET * FINDER_ALPHABET)
+#define FINDER_KEYS      (FINDER_TRIGRAMS + FINDER_ALPHABET * FINDER_ALPHABET)
+#define FINDER_CHUNK     4096 // entries added per lock
+#define FINDER_QUERY_MAX 50
+#define FINDER_SCORE_MIN 256 // results wanted before lower trigram counts
+#define FINDER_MAGIC     "GdbVkGuiFinder1"
+
+enum FinderKind : uint16_t
+{
+    FINDER_FILE = 0,
+    FINDER_FUNCTION,
+};
+
+struct FinderEntry
+{
+    uint32_t m_Name; // offsets in m_Strings, null terminated
+    uint32_t m_Path;
+    uint32_t m_Line;
+    uint16_t m_NameSz;
+    uint16_t m_Kind;
+};
+
+struct FinderIndex
+{
+    std::vector<FinderEntry> m_Entries;
+    std::vector<uint64_t>    m_Letters; // per entry, a bit per letter in it
+    std::vector<char>        m_Strings;
+
+    // per trigram, then per first two letters
+    std::vector<std::vector<uint32_t>> m_Postings;
+};
+
+// written by the worker under s_lock, read by queries under s_lock
+static FinderIndex s_index;
+
+static std::thread             s_worker;
+static std::mutex              s_lock;
+static std::condition_variable s_work_cv;
+static std::deque<std::string> s_queue; // replies
+static bool                    s_commit; // save once the queue is empty
+static bool                    s_busy;
+static bool                    s_worker_exit;
+static std::string             s_index_file;
+
+// worker only : paths are stored once
+static std::unordered_map<std::string, uint32_t> s_paths;
+
+// query only
+static std::vector<uint8_t>  s_counts;
+static std::vector<uint32_t> s_touched;
+
+//------------------------------------------------------------------------------
+
+static uint8_t
+LetterOf(char c)
+{
+    c = (char)tolower((uint8_t)c);
+    if (c >= 'a' && c <= 'z') {
+        return (uint8_t)(c - 'a' + 1);
+    }
+    if (c >= '0' && c <= '9') {
+        return (uint8_t)(c - '0' + 27);
+    }
+    return c == '_' ? 37 : 0;
+}
+
+static uint32_t
+HeadKey(uint8_t first, uint8_t second)
+{
+    return FINDER_TRIGRAMS + first * FINDER_ALPHABET + second;
+}
+
+static uint64_t
+GetLetters(const char* text, size_t sz)
+{
+    uint64_t letters = 0;
+    for (size_t i = 0; i < sz; i++) {
+        letters |= 1ull << LetterOf(text[i]);
+    }
+    return letters;
+}
+
+static void
+GetTrigrams(const char* text, size_t sz, std::vector<uint32_t>& keys)
+{
+    for (size_t i = 0; i + 2 < sz; i++) {
+        uint32_t key = (LetterOf(text[i]) * FINDER_ALPHABET +
+                        LetterOf(text[i + 1])) *
+                         FINDER_ALPHABET +
+                       LetterOf(text[i + 2]);
+        keys.push_back(key);
+    }
+}
+
+static bool
+IsWordStart(const char* name, size_t i)
+{
+    uint8_t c    = (uint8_t)name[i];
+    uint8_t prev = i ? (uint8_t)name[i - 1] : 0;
+    return isalnum(c) && (i == 0 || isalnum(prev) == 0 ||
+                          (isupper(c) && islower(prev)) ||
+                          (isdigit(c) && isdigit(prev) == 0));
+}
+
+// Distinct keys of an entry's name
+static void
+GetNameKeys(const char* name, size_t sz, std::vector<uint32_t>& keys)
+{
+    GetTrigrams(name, sz, keys);
+
+    char   initials[64];
+    size_t initials_sz = 0;
+    for (size_t i = 0; i < sz && initials_sz < sizeof(initials); i++) {
+        if (IsWordStart(name, i)) {
+            initials[initials_sz++] = name[i];
+        }
+    }
+    GetTrigrams(initials, initials_sz, keys);
+
+    if (sz) {
+        uint8_t second = sz > 1 ? LetterOf(name[1]) : 0;
+        keys.push_back(HeadKey(LetterOf(name[0]), second));
+    }
+
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+}
+
+// Fuzzy subsequence score of query (lowered) in name, -1 : no match.
+// Prefixes, matches in a row & at the start of words count more, shorter
+// names win
+static int32_t
+FuzzyScore(const char* name, uint32_t name_sz, const char* query, uint32_t q_sz)
+{
+    int32_t  score   = 0;
+    uint32_t q_idx   = 0;
+    bool     in_a_row = false;
+
+    for (uint32_t i = 0; i < name_sz && q_idx < q_sz; i++) {
+        char c = (char)tolower((uint8_t)name[i]);
+        if (c != query[q_idx]) {
+            in_a_row = false;
+            continue;
+        }
+
+        score += q_idx == 0 && i == 0 ? 30 : 10; // a prefix
+        if (in_a_row) {
+            score += 15;
+        }
+        if (i == 0 || isalnum((uint8_t)name[i - 1]) == 0 ||
+            (isupper((uint8_t)name[i]) && islower((uint8_t)name[i - 1]))) {
+            score += 20;
+        }
+        in_a_row = true;
+        q_idx++;
+    }
+    if (q_idx < q_sz) {
+        return -1;
+    }
+
+    if (name_sz == q_sz) {
+        score += 1000; // same letters, the case aside
+    }
+    return score - (int32_t)name_sz;
+}
+
+//------------------------------------------------------------------------------
+
+static const MiNode*
+MiChild(const MiTree* tree, const MiNode* node, const char* name)
+{
+    size_t name_sz = strlen(name);
+    for (uint32_t i = 0; i < node->m_Count; i++) {
+        const MiNode* child = &tree->m_Nodes[node->m_First + i];
+        if (child->m_NameSz == name_sz &&
+            memcmp(tree->m_Strings + child->m_Name, name, name_sz) == 0) {
+            return child;
+        }
+    }
+    return nullptr;
+}
+
+static const char*
+MiChildValue(const MiTree* tree, const MiNode* node, const char* name)
+{
+    const MiNode* child = MiChild(tree, node, name);
+    return child && child->m_Type == MI_CONST ? tree->m_Strings + child->m_Value
+                                              : nullptr;
+}
+
+struct FinderBatch
+{
+    std::vector<FinderEntry> m_Entries; // offsets in m_Strings of the batch
+    std::vector<char>        m_Strings;
+
+    std::unordered_map<std::string, uint32_t> m_Paths; // new ones
+};
+
+#define FINDER_IN_INDEX 0x80000000 // path offset is in the index already
+
+static uint32_t
+AddBatchString(FinderBatch& batch, const char* str, size_t sz)
+{
+    uint32_t offset = (uint32_t)batch.m_Strings.size();
+    batch.m_Strings.insert(batch.m_Strings.end(), str, str + sz);
+    batch.m_Strings.push_back(0);
+    return offset;
+}
+
+static uint32_t
+AddBatchPath(FinderBatch& batch, const char* path)
+{
+    auto found = s_paths.find(path);
+    if (found != s_paths.end()) {
+        return found->second | FINDER_IN_INDEX;
+    }
+    found = batch.m_Paths.find(path);
+    if (found != batch.m_Paths.end()) {
+        return found->second;
+    }
+
+    uint32_t offset = AddBatchString(batch, path, strlen(path));
+    batch.m_Paths.emplace(path, offset);
+    return offset;
+}
+
+static void
+AddBatchEntry(FinderBatch& batch,
+              const char*  name,
+              const char*  path,
+              uint32_t     line,
+              FinderKind   kind)
+{
+    size_t name_sz = std::min(strlen(name), (size_t)UINT16_MAX);
+
+    FinderEntry entry;
+    entry.m_Name   = AddBatchString(batch, name, name_sz);
+    entry.m_Path   = AddBatchPath(batch, path);
+    entry.m_Line   = line;
+    entry.m_NameSz = (uint16_t)name_sz;
+    entry.m_Kind   = kind;
+    batch.m_Entries.push_back(entry);
+}
+
+// Moves the batch into the index, FINDER_CHUNK entries per lock
+static void
+CommitBatch(FinderBatch& batch)
+{
+    std::unordered_map<uint32_t, uint32_t> moved; // batch path -> index
+    std::vector<uint32_t>                  keys;
+    for (size_t first = 0; first < batch.m_Entries.size();
+         first += FINDER_CHUNK) {
+        size_t last = std::min(first + FINDER_CHUNK, batch.m_Entries.size());
+
+        std::lock_guard<std::mutex> lock(s_lock);
+        for (size_t i = first; i < last; i++) {
+            FinderEntry entry = batch.m_Entries[i];
+            const char* name  = &batch.m_Strings[entry.m_Name];
+            uint32_t    id    = (uint32_t)s_index.m_Entries.size();
+
+            entry.m_Name = (uint32_t)s_index.m_Strings.size();
+            s_index.m_Strings.insert(
+              s_index.m_Strings.end(), name, name + entry.m_NameSz + 1);
+
+            if (entry.m_Path & FINDER_IN_INDEX) {
+                entry.m_Path &= ~FINDER_IN_INDEX;
+            } else if (moved.count(entry.m_Path)) {
+                entry.m_Path = moved[entry.m_Path];
+            } else {
+                const char* path   = &batch.m_Strings[entry.m_Path];
+                uint32_t    offset = (uint32_t)s_index.m_Strings.size();
+                s_index.m_Strings.insert(
+                  s_index.m_Strings.end(), path, path + strlen(path) + 1);
+
+                moved[entry.m_Path] = offset;
+                s_paths.emplace(path, offset);
+                entry.m_Path = offset;
+            }
+            s_index.m_Entries.push_back(entry);
+            s_index.m_Letters.push_back(GetLetters(name, entry.m_NameSz));
+
+            keys.clear();
+            GetNameKeys(name, entry.m_NameSz, keys);
+            for (uint32_t key : keys) {
+                s_index.m_Postings[key].push_back(id);
+            }
+        }
+    }
+}
+
+// Source files & functions of one reply. The result record is the last
+// line, what comes before may hold records of other commands
+static void
+IndexReply(const std::string& reply)
+{
+    size_t start = 0;
+    for (size_t line = 0; line < reply.size();) {
+        size_t mark = line;
+        while (mark < reply.size() && isdigit((uint8_t)reply[mark])) {
+            mark++;
+        }
+        if (mark < reply.size() && reply[mark] == '^') {
+            start = line;
+        }
+        size_t line_end = reply.find('\n', line);
+        line = line_end == std::string::npos ? reply.size() : line_end + 1;
+    }
+
+    MiTree* tree =
+      MiParse(reply.data() + start, (uint32_t)(reply.size() - start));
+    if (tree == nullptr) {
+        return;
+    }
+
+    FinderBatch   batch;
+    const MiNode* root  = &tree->m_Nodes[tree->m_Root];
+    const MiNode* files = MiChild(tree, root, "files");
+    if (files) {
+        for (uint32_t i = 0; i < files->m_Count; i++) {
+            const MiNode* file = &tree->m_Nodes[files->m_First + i];
+            const char*   path = MiChildValue(tree, file, "fullname");
+            if (path) {
+                const char* slash = strrchr(path, '/');
+                AddBatchEntry(
+                  batch, slash ? slash + 1 : path, path, 1, FINDER_FILE);
+            }
+        }
+    }
+
+    const MiNode* symbols = MiChild(tree, root, "symbols");
+    const MiNode* debug   = symbols ? MiChild(tree, symbols, "debug") : nullptr;
+    if (debug) {
+        for (uint32_t i = 0; i < debug->m_Count; i++) {
+            const MiNode* file  = &tree->m_Nodes[debug->m_First + i];
+            const char*   path  = MiChildValue(tree, file, "fullname");
+            const MiNode* funcs = MiChild(tree, file, "symbols");
+            if (path == nullptr || funcs == nullptr) {
+                continue;
+            }
+            for (uint32_t j = 0; j < funcs->m_Count; j++) {
+                const MiNode* func = &tree->m_Nodes[funcs->m_First + j];
+                const char*   name = MiChildValue(tree, func, "name");
+                const char*   line = MiChildValue(tree, func, "line");
+                if (name) {
+                    AddBatchEntry(batch,
+                                  name,
+                                  path,
+                                  line ? (uint32_t)atoi(line) : 1,
+                                  FINDER_FUNCTION);
+                }
+            }
+        }
+    }
+    MiRelease(tree);
+
+    CommitBatch(batch);
+}
+
+//------------------------------------------------------------------------------
+
+struct FinderFileHeader
+{
+    char     m_Magic[16];
+    uint32_t m_EntryCount;
+    uint32_t m_StringsSz;
+    uint32_t m_KeyCount;
+    uint32_t m_PostingCount;
+};
+
+static bool
+WriteAll(FILE* file, const void* data, size_t sz)
+{
+    return sz == 0 || fwrite(data, 1, sz, file) == sz;
+}
+
+// Only the worker changes the index, it reads it w/o the lock
+static bool
+SaveIndex(const std::string& fname)
+{
+    FinderFileHeader header = {};
+    memcpy(header.m_Magic, FINDER_MAGIC, sizeof(FINDER_MAGIC));
+    header.m_EntryCount   = (uint32_t)s_index.m_Entries.size();
+    header.m_StringsSz    = (uint32_t)s_index.m_Strings.size();
+    header.m_KeyCount     = FINDER_KEYS;
+
+    std::vector<uint32_t> sizes(FINDER_KEYS);
+    for (uint32_t i = 0; i < FINDER_KEYS; i++) {
+        sizes[i] = (uint32_t)s_index.m_Postings[i].size();
+        header.m_PostingCount += sizes[i];
+    }
+
+    std::string tmp  = fname + ".tmp";
+    FILE*       file = fopen(tmp.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool ok = WriteAll(file, &header, sizeof(header)) &&
+              WriteAll(file,
+                       s_index.m_Entries.data(),
+                       s_index.m_Entries.size() * sizeof(FinderEntry)) &&
+              WriteAll(file,
+                       s_index.m_Letters.data(),
+                       s_index.m_Letters.size() * sizeof(uint64_t)) &&
+              WriteAll(file, s_index.m_Strings.data(), header.m_StringsSz) &&
+              WriteAll(file, sizes.data(), sizes.size() * sizeof(uint32_t));
+    for (uint32_t i = 0; ok && i < FINDER_KEYS; i++) {
+        ok = WriteAll(
+          file, s_index.m_Postings[i].data(), sizes[i] * sizeof(uint32_t));
+    }
+    ok = fclose(file) == 0 && ok;
+
+    if (ok == false || rename(tmp.c_str(), fname.c_str())) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// What's past the header points in range : names & paths are terminated
+// strings in the file's, the key sizes add up & every id is an entry
+static bool
+CheckIndexFile(const FinderFileHeader& header,
+               const FinderEntry*      entries,
+               const char*             strings,
+               const uint32_t*         sizes)
+{
+    const uint32_t strings_sz = header.m_StringsSz;
+    for (uint32_t i = 0; i < header.m_EntryCount; i++) {
+        const FinderEntry& entry = entries[i];
+        if ((uint64_t)entry.m_Name + entry.m_NameSz >= strings_sz ||
+            strings[entry.m_Name + entry.m_NameSz] != 0 ||
+            entry.m_Path >= strings_sz) {
+            return false;
+        }
+    }
+    if (strings_sz && strings[strings_sz - 1] != 0) {
+        return false; // a path would run past the end
+    }
+
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < FINDER_KEYS; i++) {
+        total += sizes[i];
+    }
+    if (total != header.m_PostingCount) {
+        return false;
+    }
+
+    const uint32_t* postings = sizes + FINDER_KEYS;
+    for (uint32_t i = 0; i < header.m_PostingCount; i++) {
+        if (postings[i] >= header.m_EntryCount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool
+LoadIndex(const std::string& fname)
+{
+    MappedFile file;
+    if (MapFile(fname.c_str(), &file) == false) {
+        return false;
+    }
+
+    FinderFileHeader header;
+    const char*      data = file.m_Data;
+    const char*      end  = data + file.m_Sz;
+    bool             ok   = file.m_Sz >= sizeof(header);
+    if (ok) {
+        memcpy(&header, data, sizeof(header));
+        data += sizeof(header);
+
+        size_t body_sz = (size_t)header.m_EntryCount *
+                           (sizeof(FinderEntry) + sizeof(uint64_t)) +
+                         header.m_StringsSz +
+                         (size_t)FINDER_KEYS * sizeof(uint32_t) +
+                         (size_t)header.m_PostingCount * sizeof(uint32_t);
+        ok = memcmp(header.m_Magic, FINDER_MAGIC, sizeof(FINDER_MAGIC)) == 0 &&
+             header.m_KeyCount == FINDER_KEYS &&
+             (size_t)(end - data) == body_sz;
+    }
+    if (ok == false) {
+        UnmapFile(&file);
+        return false;
+    }
+
+    const uint32_t     count      = header.m_EntryCount;
+    const uint32_t     strings_sz = header.m_StringsSz;
+    const FinderEntry* entries    = (const FinderEntry*)data;
+    const uint64_t*    letters    = (const uint64_t*)(entries + count);
+    const char*        strings    = (const char*)(letters + count);
+    const uint32_t*    sizes      = (const uint32_t*)(strings + strings_sz);
+    if (CheckIndexFile(header, entries, strings, sizes) == false) {
+        UnmapFile(&file);
+        return false;
+    }
+
+    s_index.m_Entries.assign(entries, entries + count);
+    s_index.m_Letters.assign(letters, letters + count);
+    s_index.m_Strings.assign(strings, strings + strings_sz);
+
+    const uint32_t* postings = sizes + FINDER_KEYS;
+    for (uint32_t i = 0; i < FINDER_KEYS; i++) {
+        s_index.m_Postings[i].assign(postings, postings + sizes[i]);
+        postings += sizes[i];
+    }
+
+    UnmapFile(&file);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+static void
+FinderWorker(void)
+{
+    std::unique_lock<std::mutex> lock(s_lock);
+    while (true) {
+        s_work_cv.wait(lock, [] {
+            return s_worker_exit || s_queue.size() || s_commit;
+        });
+        if (s_worker_exit) {
+            break;
+        }
+
+        if (s_queue.size()) {
+            std::string reply = std::move(s_queue.front());
+            s_queue.pop_front();
+
+            lock.unlock();
+            IndexReply(reply);
+            lock.lock();
+        } else {
+            s_commit = false;
+
+            lock.unlock();
+            if (s_index_file.size() && SaveIndex(s_index_file) == false) {
+                fprintf(stderr,
+                        "Finder index not saved (%s): %s\n",
+                        s_index_file.c_str(),
+                        strerror(errno));
+            }
+            lock.lock();
+        }
+        s_busy = s_queue.size() || s_commit;
+    }
+}
+
+void
+FuzzyFinderShutdown(void)
+{
+    if (s_worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(s_lock);
+            s_worker_exit = true;
+            s_work_cv.notify_one();
+        }
+        s_worker.join();
+    }
+    s_queue.clear();
+    s_commit      = false;
+    s_busy        = false;
+    s_worker_exit = false;
+}
+
+//------------------------------------------------------------------------------
+
+template<typename Ehdr, typename Phdr>
+static bool
+ReadBuildId(const MappedFile& file, std::string& build_id)
+{
+    if (file.m_Sz < sizeof(Ehdr)) {
+        return false;
+    }
+    const Ehdr* ehdr = (const Ehdr*)file.m_Data;
+    if (ehdr->e_phoff + (size_t)ehdr->e_phnum * sizeof(Phdr) > file.m_Sz) {
+        return false;
+    }
+
+    const Phdr* phdrs = (const Phdr*)(file.m_Data + ehdr->e_phoff);
+    for (uint32_t i = 0; i < ehdr->e_phnum; i++) {
+        if (phdrs[i].p_type != PT_NOTE ||
+            phdrs[i].p_offset + phdrs[i].p_filesz > file.m_Sz) {
+            continue;
+        }
+
+        const char* note = file.m_Data + phdrs[i].p_offset;
+        const char* end  = note + phdrs[i].p_filesz;
+        while (note + sizeof(Elf64_Nhdr) <= end) {
+            const Elf64_Nhdr* nhdr = (const Elf64_Nhdr*)note;
+            const char*       name = note + sizeof(Elf64_Nhdr);
+            const char*       desc = name + ((nhdr->n_namesz + 3) & ~3u);
+            if (desc + nhdr->n_descsz > end) {
+                break;
+            }
+
+            if (nhdr->n_type == NT_GNU_BUILD_ID && nhdr->n_namesz == 4 &&
+                memcmp(name, "GNU", 4) == 0) {
+                char hex[3];
+                for (uint32_t j = 0; j < nhdr->n_descsz; j++) {
+                    snprintf(hex, sizeof(hex), "%02x", (uint8_t)desc[j]);
+                    build_id += hex;
+                }
+                return true;
+            }
+            note = desc + ((nhdr->n_descsz + 3) & ~3u);
+        }
+    }
+    return false;
+}
+
+// Build-id of the binary, or a key made from its path, size & time of the
+// last change when it has none
+static std::string
+GetIndexKey(const char* exe)
+{
+    std::string key;
+
+    MappedFile file;
+    if (MapFile(exe, &file)) {
+        if (file.m_Sz > EI_CLASS && memcmp(file.m_Data, ELFMAG, SELFMAG) == 0) {
+            if (file.m_Data[EI_CLASS] == ELFCLASS64) {
+                ReadBuildId<Elf64_Ehdr, Elf64_Phdr>(file, key);
+            } else {
+                ReadBuildId<Elf32_Ehdr, Elf32_Phdr>(file, key);
+            }
+        }
+        UnmapFile(&file);
+    }
+
+    if (key.empty()) {
+        FileInfo info = {};
+        if (GetFileInfo(exe, &info) == false) {
+            return key;
+        }
+
+        // FNV-1a
+        uint64_t hash = 14695981039346656037ull;
+        for (const char* c = exe; *c; c++) {
+            hash = (hash ^ (uint8_t)*c) * 1099511628211ull;
+        }
+        char buff[64];
+        snprintf(buff,
+                 sizeof(buff),
+                 "path-%016" PRIx64 "-%x-%x",
+                 hash,
+                 info.m_LastEdit,
+                 info.m_Sz);
+        key = buff;
+    }
+    return key;
+}
+
+// Open(exe) -> true when the index saved for it was loaded. Starts a new,
+// empty, index otherwise
+static int
+FinderOpen(lua_State* L)
+{
+    const char* exe = luaL_checkstring(L, 1);
+
+    FuzzyFinderShutdown();
+
+    s_index.m_Entries.clear();
+    s_index.m_Letters.clear();
+    s_index.m_Strings.clear();
+    s_index.m_Postings.assign(FINDER_KEYS, std::vector<uint32_t>());
+    s_paths.clear();
+    s_index_file.clear();
+
+    std::string key  = GetIndexKey(exe);
+    const char* home = getenv("HOME");
+    if (key.size() && home) {
+        std::string dir = std::string(home) + "/.gdbvkgui/finder";
+        mkdir(dir.c_str(), 0755);
+        s_index_file = dir + "/" + key + ".idx";
+    }
+
+    lua_pushboolean(L, s_index_file.size() && LoadIndex(s_index_file));
+    return 1;
+}
+
+// Add(reply) : indexes the files or functions gdb replied w/ on the worker
+static int
+FinderAdd(lua_State* L)
+{
+    size_t      sz    = 0;
+    const char* reply = luaL_checklstring(L, 1, &sz);
+
+    std::lock_guard<std::mutex> lock(s_lock);
+    if (s_index.m_Postings.empty()) {
+        return 0; // not open
+    }
+    if (s_worker.joinable() == false) {
+        s_worker = std::thread(FinderWorker);
+    }
+    s_queue.emplace_back(reply, sz);
+    s_busy = true;
+    s_work_cv.notify_one();
+    return 0;
+}
+
+// Commit() : saves the index once what was added is in
+static int
+FinderCommit(lua_State* L)
+{
+    std::lock_guard<std::mutex> lock(s_lock);
+    if (s_worker.joinable()) {
+        s_commit = true;
+        s_busy   = true;
+        s_work_cv.notify_one();
+    }
+    return 0;
+}
+
+struct FinderResult
+{
+    int32_t  m_Score;
+    uint32_t m_Entry;
+};
+
+static void
+ScoreEntry(uint32_t                   id,
+           int32_t                    bonus,
+           const std::string&         query,
+           std::vector<FinderResult>& results)
+{
+    const FinderEntry& entry = s_index.m_Entries[id];
+    int32_t            score = FuzzyScore(&s_index.m_Strings[entry.m_Name],
+                                          entry.m_NameSz,
+                                          query.data(),
+                                          (uint32_t)query.size());
+    if (score >= 0) {
+        results.push_back({ score + bonus, id });
+    }
+}
+
+// Query(text [, max]) -> { { name, file, short, line, kind }, ... } best
+// first
+static int
+FinderQuery(lua_State* L)
+{
+    size_t      text_sz = 0;
+    const char* text    = luaL_checklstring(L, 1, &text_sz);
+    size_t      max     = (size_t)luaL_optinteger(L, 2, FINDER_QUERY_MAX);
+
+    std::string query;
+    for (size_t i = 0; i < text_sz; i++) {
+        if (isspace((uint8_t)text[i]) == 0) {
+            query += (char)tolower((uint8_t)text[i]);
+        }
+    }
+
+    std::vector<uint32_t> keys;
+    GetTrigrams(query.data(), query.size(), keys);
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    std::lock_guard<std::mutex> lock(s_lock);
+
+    std::vector<FinderResult> results;
+    uint32_t entry_count = (uint32_t)s_index.m_Entries.size();
+    uint8_t  best        = 0;
+
+    if (keys.size()) {
+        // entries sharing trigrams w/ the query, bucketed by how many
+        s_counts.resize(entry_count);
+        s_touched.clear();
+        for (uint32_t key : keys) {
+            for (uint32_t id : s_index.m_Postings[key]) {
+                if (s_counts[id] == 0) {
+                    s_touched.push_back(id);
+                }
+                if (s_counts[id] < UINT8_MAX) {
+                    s_counts[id]++;
+                }
+                best = std::max(best, s_counts[id]);
+            }
+        }
+
+        // the most shared first, down to half of the best
+        std::vector<std::vector<uint32_t>> by_count(best + 1);
+        for (uint32_t id : s_touched) {
+            by_count[s_counts[id]].push_back(id);
+            s_counts[id] = 0;
+        }
+        for (uint32_t count = best; count > 0 && count * 2 >= best; count--) {
+            for (uint32_t id : by_count[count]) {
+                ScoreEntry(id, count * 10, query, results);
+            }
+            if (results.size() >= FINDER_SCORE_MIN) {
+                break;
+            }
+        }
+
+        // shares none : the letters must all be there at least
+        if (best == 0) {
+            uint64_t letters = GetLetters(query.data(), query.size());
+            for (uint32_t id = 0; id < entry_count; id++) {
+                if ((s_index.m_Letters[id] & letters) == letters) {
+                    ScoreEntry(id, 0, query, results);
+                }
+            }
+        }
+    } else if (query.size()) {
+        // by the first letter or two
+        uint8_t first = LetterOf(query[0]);
+        for (uint8_t second = 0; second < FINDER_ALPHABET; second++) {
+            if (query.size() > 1 && second != LetterOf(query[1])) {
+                continue;
+            }
+            for (uint32_t id : s_index.m_Postings[HeadKey(first, second)]) {
+                ScoreEntry(id, 0, query, results);
+            }
+        }
+    }
+
+    size_t count = std::min(max, results.size());
+    std::partial_sort(results.begin(),
+                      results.begin() + count,
+                      results.end(),
+                      [](const FinderResult& a, const FinderResult& b) {
+                          return a.m_Score != b.m_Score ? a.m_Score > b.m_Score
+                                                        : a.m_Entry < b.m_Entry;
+                      });
+
+    lua_createtable(L, (int)count, 0);
+    for (size_t i = 0; i < count; i++) {
+        const FinderEntry& entry = s_index.m_Entries[results[i].m_Entry];
+        const char*        path  = &s_index.m_Strings[entry.m_Path];
+        const char*        slash = strrchr(path, '/');
+
+        lua_createtable(L, 0, 5);
+        lua_pushlstring(L, &s_index.m_Strings[entry.m_Name], entry.m_NameSz);
+        lua_setfield(L, -2, "name");
+        lua_pushstring(L, path);
+        lua_setfield(L, -2, "file");
+        lua_pushstring(L, slash ? slash + 1 : path);
+        lua_setfield(L, -2, "short");
+        lua_pushinteger(L, entry.m_Line);
+        lua_setfield(L, -2, "line");
+        lua_pushstring(L, entry.m_Kind == FINDER_FILE ? "file" : "function");
+        lua_setfield(L, -2, "kind");
+
+        lua_rawseti(L, -2, (lua_Integer)i + 1);
+    }
+    return 1;
+}
+
+// Progress() -> entries indexed, busy
+static int
+FinderProgress(lua_State* L)
+{
+    std::lock_guard<std::mutex> lock(s_lock);
+    lua_pushinteger(L, (lua_Integer)s_index.m_Entries.size());
+    lua_pushboolean(L, s_busy);
+    return 2;
+}
+
+static const luaL_Reg s_finder_lib[] = {
+    { "Open", FinderOpen },   { "Add", FinderAdd },
+    { "Commit", FinderCommit }, { "Query", FinderQuery },
+    { "Progress", FinderProgress }, { NULL, NULL },
+};
+
+int
+luaopen_FuzzyFinder(lua_State* L)
+{
+    luaL_newlib(L, s_finder_lib);
+    return 1;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct lua_State lua_State;
+
+    // Global "FuzzyFinder" : Open(exe), Add(reply), Commit(), Query(text
+    // [, max]), Progress(). The inferior's source files & functions go in a
+    // trigram index built on a worker thread & saved in ~/.gdbvkgui/finder/
+    // under the binary's build-id
+    int luaopen_FuzzyFinder(lua_State* L);
+
+    // Drops what's still queued & waits for the worker
+    void FuzzyFinderShutdown(void);
+
+#ifdef __cplusplus
+}
+#endif
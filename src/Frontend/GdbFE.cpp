@@ -1,13 +1,27 @@
 #include "Frontend/GdbFE.h"
+#include "Frontend/FuzzyFinder.h"
 #include "Frontend/ImGuiFileBrowser.h"
+#include "Frontend/MiParser.h"
+#include "Frontend/SessionJournal.h"
+#include "Frontend/SourceLexer.h"
+#include "Frontend/SourceSearch.h"
+#include "Frontend/SourceView.h"
 #include "Frontend/TextEditor.h"
+#include "Gui/LuaProfiler.h"
 #include "LuaLayer.h"
 #include "ProcessIO.h"
 #include "UtilityMacros.h"
 #include "imgui.h"
 #include "lua.hpp"
+#include <algorithm>
+#include <list>
+#include <memory>
 #include <sstream>
 #include <stdlib.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 extern const char _binary__tmp_prog_luac_start;
 extern const char _binary__tmp_prog_luac_end;
@@ -46,14 +60,49 @@ extern "C"
 #define MAX_RESP_SZ 1024 * 8
 static char s_output_text[MAX_RESP_SZ];
 
-static TextEditor s_editor;
-static FileInfo   s_finfo;
+// Files shown in the editor, the last one opened first. Tabs on the same
+// file share its entry. Going back to a file keeps its colours & scroll, the
+// oldest are dropped once they add up to more than SOURCE_CACHE_SZ (never
+// the ones a tab shows)
+#define SOURCE_CACHE_SZ (256 * 1024 * 1024)
+
+struct CachedSource
+{
+    std::string    m_Path;
+    uint32_t       m_LastEdit; // the file changed when these do
+    uint32_t       m_Sz;
+    MappedFile     m_File;
+    SourceDocument m_Doc;
+    float          m_ScrollX, m_ScrollY;
+    uint32_t       m_Refs; // tabs showing it
+
+    std::unordered_set<int> m_Breakpoints;
+    SourceInlineValues      m_InlineValues; // the current frame's locals
+};
+
+static std::list<std::unique_ptr<CachedSource>> s_sources;
+static SourceDocument s_no_source; // until gdb stops somewhere
+
+// The first tab follows gdb, the others stay where they were opened. Only
+// the selected one is drawn
+struct EditorTab
+{
+    CachedSource* m_Source; // NULL : s_no_source
+    SourceView    m_View;
+    bool          m_Select; // bring it to the front on the next frame
+};
+
+static std::vector<std::unique_ptr<EditorTab>> s_tabs;
+static EditorTab*                              s_active_tab;
+static TextEditor::Palette                     s_palette;
 
 static imgui_addons::ImGuiFileBrowser s_FileDlg;
 
 //------------------------------------------------------------------------------
 
-static void
+// Copies gdb's reply into buff (left empty if it doesn't fit) & returns the
+// whole reply
+static GdbMsg
 GetGdbResponse(char buff[] = nullptr, int32_t buff_sz = -1)
 {
     buff_sz = buff_sz > 0 ? buff_sz : MAX_RESP_SZ;
@@ -61,6 +110,8 @@ GetGdbResponse(char buff[] = nullptr, int32_t buff_sz = -1)
         buff = s_output_text;
     }
 
+    buff[0] = 0;
+
     GdbMsg resp = GdbOutput();
     if (resp.m_MsgSz && (resp.m_MsgSz < (uint32_t)buff_sz)) {
         memcpy(buff, resp.m_Msg, resp.m_MsgSz);
@@ -68,6 +119,310 @@ GetGdbResponse(char buff[] = nullptr, int32_t buff_sz = -1)
     } else {
         // TODO : process error when reading gdb reply
     }
+    return resp;
+}
+
+//------------------------------------------------------------------------------
+// Async MI commands
+//
+// A task is a lua thread started w/ GdbTask. It sends a command w/
+// SendToGdbAsync and yields the returned token. Once per frame gdb's output
+// is polled and the task waiting on a token is resumed w/ the reply : the
+// untokenised lines read since the previous result record plus the result
+// record itself. Lines no task is waiting on are handed to the next
+// ReadFromGdb call so synchronous commands still see async records.
+// Replies requested as parsed go through the MI parser thread first and the
+// task is resumed w/ a GdbMi view once the tree is ready.
+// A task may send several commands before yielding their tokens one by one in
+// send order (gdb replies in order), their replies are kept away from the
+// synchronous reads until then : a reply whose token no task waits on yet is
+// stashed & handed over when the token is yielded.
+
+#define MAX_PENDING_TASKS 256
+
+struct PendingTask
+{
+    uint32_t m_Token;
+    int32_t  m_TaskRef;
+    bool     m_Parse;
+};
+
+static PendingTask s_pending[MAX_PENDING_TASKS];
+static uint32_t    s_pending_count;
+static uint32_t    s_next_token = 1;
+static uint32_t    s_parsing_count;
+
+static ImVector<uint32_t> s_parse_tokens; // sent w/ parsed, not yet awaited
+static ImVector<uint32_t> s_outstanding;  // sent async, reply not dispatched
+
+// replies in before their task yielded the token, e.g. while it was resumed
+// w/ a parsed reply
+static std::unordered_map<uint32_t, std::string> s_stashed;
+
+static ImVector<char> s_outbox;     // framed commands the pipe hasn't taken
+static ImVector<char> s_inbox;      // partial line carried between polls
+static ImVector<char> s_routed;     // task replies pulled out by ReadFromGdb
+static ImVector<char> s_reply;      // lines since the last result record
+static ImVector<char> s_unclaimed;  // lines w/ no waiting task
+static ImVector<char> s_sync_reply; // ReadFromGdb output when tasks are live
+
+static void
+AppendText(ImVector<char>& dst, const char* text, uint32_t text_sz)
+{
+    if (text_sz) {
+        uint32_t offset = dst.Size;
+        dst.resize(offset + text_sz);
+        memcpy(dst.Data + offset, text, text_sz);
+    }
+}
+
+static void
+FlushOutbox(void)
+{
+    while (s_outbox.Size) {
+        int32_t wout = GdbWrite(s_outbox.Data, s_outbox.Size);
+        if (wout <= 0) {
+            break;
+        }
+        s_outbox.erase(s_outbox.Data, s_outbox.Data + wout);
+    }
+}
+
+static bool
+QueueCommand(uint32_t token, const char* cmd, uint32_t cmd_sz)
+{
+    if (token) {
+        char    prefix[16];
+        int32_t prefix_sz = snprintf(prefix, sizeof(prefix), "%u", token);
+        AppendText(s_outbox, prefix, prefix_sz);
+    }
+    AppendText(s_outbox, cmd, cmd_sz);
+    if (cmd_sz == 0 || cmd[cmd_sz - 1] != '\n') {
+        s_outbox.push_back('\n');
+    }
+
+    FlushOutbox();
+
+    // the pipe refusing all of it right now is fine, it is retried next frame
+    return true;
+}
+
+// Returns the token of a tokenised result record ("<digits>^..."), else 0
+static uint32_t
+ResultToken(const char* line, uint32_t line_sz)
+{
+    uint32_t token = 0;
+    uint32_t idx   = 0;
+    while (idx < line_sz && line[idx] >= '0' && line[idx] <= '9') {
+        token = token * 10 + (line[idx] - '0');
+        idx++;
+    }
+    return (idx && idx < line_sz && line[idx] == '^') ? token : 0;
+}
+
+static int32_t
+FindPendingTask(uint32_t token)
+{
+    for (uint32_t i = 0; i < s_pending_count; i++) {
+        if (s_pending[i].m_Token == token) {
+            return (int32_t)i;
+        }
+    }
+    return -1;
+}
+
+static bool
+DeliverReply(lua_State*  L,
+             int32_t     task_ref,
+             bool        parse,
+             const char* reply,
+             uint32_t    reply_sz);
+
+// Resumes a task w/ nargs values on its stack. Returns true if the task is
+// now waiting on a reply
+static bool
+ResumeTask(lua_State* L, lua_State* task, int32_t task_ref, int32_t nargs)
+{
+    int32_t nres = 0;
+    int32_t sts  = lua_resume(task, L, nargs, &nres);
+
+    if (sts == LUA_YIELD && nres == 1 && lua_isinteger(task, -1) &&
+        s_pending_count < MAX_PENDING_TASKS) {
+
+        uint32_t token = (uint32_t)lua_tointeger(task, -1);
+        bool     parse = false;
+        lua_pop(task, nres);
+
+        uint32_t* parse_token = s_parse_tokens.find(token);
+        if (parse_token != s_parse_tokens.end()) {
+            parse = true;
+            s_parse_tokens.erase_unsorted(parse_token);
+        }
+
+        auto stashed = s_stashed.find(token);
+        if (stashed != s_stashed.end()) {
+            std::string reply = std::move(stashed->second);
+            s_stashed.erase(stashed);
+            return DeliverReply(
+              L, task_ref, parse, reply.data(), (uint32_t)reply.size());
+        }
+
+        PendingTask& pending = s_pending[s_pending_count++];
+        pending.m_Token      = token;
+        pending.m_TaskRef    = task_ref;
+        pending.m_Parse      = parse;
+        return true;
+    }
+
+    if (sts != LUA_OK) {
+        // yielding anything but a token is a bug in the task, as an error is
+        const char* msg = sts == LUA_YIELD
+                            ? "Gdb task yielded w/o a pending command token"
+                            : lua_tostring(task, -1);
+        luaL_traceback(L, task, msg, 0);
+        fprintf(stderr, "%s\n", lua_tostring(L, -1));
+        lua_pop(L, 1);
+    }
+    luaL_unref(L, LUA_REGISTRYINDEX, task_ref);
+
+    return false;
+}
+
+// Hands a task the reply it yielded the token of : resumed now w/ the text,
+// or once the parser thread is done w/ it. Returns true while the task waits
+static bool
+DeliverReply(lua_State*  L,
+             int32_t     task_ref,
+             bool        parse,
+             const char* reply,
+             uint32_t    reply_sz)
+{
+    if (parse) {
+        MiSubmit(task_ref, reply, reply_sz);
+        s_parsing_count++;
+        return true;
+    }
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, task_ref);
+    lua_State* task = lua_tothread(L, -1);
+    lua_pop(L, 1);
+
+    lua_pushlstring(task, reply, reply_sz);
+
+    return ResumeTask(L, task, task_ref, 1);
+}
+
+static void
+DispatchLine(lua_State* L, const char* line, uint32_t line_sz)
+{
+    if (line_sz == 0 || (line_sz >= 5 && memcmp(line, "(gdb)", 5) == 0)) {
+        return;
+    }
+
+    int32_t  pending_idx = -1;
+    bool     early       = false; // a task's, it hasn't yielded the token yet
+    uint32_t token       = ResultToken(line, line_sz);
+    if (token) {
+        pending_idx = FindPendingTask(token);
+
+        uint32_t* outstanding = s_outstanding.find(token);
+        if (outstanding != s_outstanding.end()) {
+            s_outstanding.erase_unsorted(outstanding);
+            early = pending_idx == -1;
+        }
+    }
+
+    if (early) {
+        std::string& reply = s_stashed[token];
+        reply.assign(s_reply.Data, s_reply.Size);
+        reply.append(line, line_sz);
+        s_reply.resize(0);
+        return;
+    }
+
+    if (pending_idx == -1) {
+        ImVector<char>& dst = s_pending_count ? s_reply : s_unclaimed;
+        AppendText(dst, line, line_sz);
+        dst.push_back('\n');
+        return;
+    }
+
+    // remove before resuming, the task is free to wait on another command
+    int32_t task_ref       = s_pending[pending_idx].m_TaskRef;
+    bool    parse          = s_pending[pending_idx].m_Parse;
+    s_pending[pending_idx] = s_pending[--s_pending_count];
+
+    // s_reply starts over before the task runs
+    ImVector<char> reply;
+    reply.swap(s_reply);
+    AppendText(reply, line, line_sz);
+
+    DeliverReply(L, task_ref, parse, reply.Data, reply.Size);
+}
+
+static void
+ResumeParsedTasks(lua_State* L)
+{
+    int64_t task_ref = 0;
+    MiTree* tree     = nullptr;
+    while (s_parsing_count && MiPollResult(&task_ref, &tree)) {
+        s_parsing_count--;
+
+        lua_rawgeti(L, LUA_REGISTRYINDEX, (int32_t)task_ref);
+        lua_State* task = lua_tothread(L, -1);
+        lua_pop(L, 1);
+
+        MiPushTree(task, tree);
+        MiRelease(tree);
+
+        ResumeTask(L, task, (int32_t)task_ref, 1);
+    }
+}
+
+static void
+PollGdbTasks(void)
+{
+    FlushOutbox();
+
+    ResumeParsedTasks(GetLuaState());
+
+    // w/ nothing waiting, leave gdb's output to the synchronous reads
+    if (s_pending_count == 0 && s_routed.Size == 0) {
+        return;
+    }
+
+    char    buff[4096];
+    int32_t read_bytes = 0;
+    while ((read_bytes = GdbReadAvailable(buff, sizeof(buff))) > 0) {
+        AppendText(s_inbox, buff, read_bytes);
+    }
+
+    // take every complete line, resumed tasks may touch the shared buffers
+    ImVector<char> lines;
+    lines.swap(s_routed);
+
+    int32_t last_nl = s_inbox.Size - 1;
+    while (last_nl >= 0 && s_inbox.Data[last_nl] != '\n') {
+        last_nl--;
+    }
+    if (last_nl >= 0) {
+        AppendText(lines, s_inbox.Data, last_nl + 1);
+        s_inbox.erase(s_inbox.Data, s_inbox.Data + last_nl + 1);
+    }
+
+    lua_State* lstate     = GetLuaState();
+    uint32_t   line_start = 0;
+    for (int32_t i = 0; i < lines.Size; i++) {
+        if (lines.Data[i] == '\n') {
+            DispatchLine(lstate, lines.Data + line_start, i - line_start);
+            line_start = i + 1;
+        }
+    }
+
+    if (s_pending_count == 0 && s_reply.Size) {
+        AppendText(s_unclaimed, s_reply.Data, s_reply.Size);
+        s_reply.resize(0);
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -78,9 +433,27 @@ struct LuaRefs
     int32_t m_FuncRef;
 };
 
-static LuaRefs s_app_init;
-static LuaRefs s_app_upd;
-static LuaRefs s_app_exit;
+static LuaRefs s_app_init = { LUA_NOREF, LUA_NOREF };
+static LuaRefs s_app_upd  = { LUA_NOREF, LUA_NOREF };
+static LuaRefs s_app_exit = { LUA_NOREF, LUA_NOREF };
+
+static void
+FreeSource(CachedSource* source);
+
+static EditorTab*
+AddTab(void);
+
+static void
+SetTabSource(EditorTab* tab, CachedSource* source);
+
+static void
+CloseTab(EditorTab* tab);
+
+static int
+OpenEditorTab(lua_State* L);
+
+static int
+GetEditorFiles(lua_State* L);
 
 static int
 SetEditorTheme(lua_State* L);
@@ -94,6 +467,12 @@ SendToGdb(lua_State* L);
 static int
 ReadFromGdb(lua_State* L);
 
+static int
+SendToGdbAsync(lua_State* L);
+
+static int
+GdbTask(lua_State* L);
+
 static int
 SetEditorFile(lua_State* L);
 
@@ -106,9 +485,24 @@ GetEditorFileLineNum(lua_State* L);
 static int
 SetEditorBkPts(lua_State* L);
 
+static int
+SetEditorInlineValues(lua_State* L);
+
+static int
+GetEditorHover(lua_State* L);
+
 static int
 ShowTextEditor(lua_State* L);
 
+static int
+GetTime(lua_State* L);
+
+static int
+GetFrameStats(lua_State* L);
+
+static int
+GdbTraffic(lua_State* L);
+
 static void
 AddCFunc(lua_State* L, const char* name, lua_CFunction func)
 {
@@ -119,38 +513,79 @@ AddCFunc(lua_State* L, const char* name, lua_CFunction func)
 static const char*
 LuaDataStreamer(lua_State* L, void* data, size_t* sz)
 {
-    LStream* stream_d = (LStream*)data;
-    *sz               = stream_d->m_DataSz;
-    return stream_d->m_Data; // &_binary__tmp_prog_luac_start
+    // whole chunk in one piece, then end of stream
+    LStream* stream_d  = (LStream*)data;
+    *sz                = stream_d->m_DataSz;
+    stream_d->m_DataSz = 0;
+    return *sz ? stream_d->m_Data : nullptr; // &_binary__tmp_prog_luac_start
+}
+
+// An on-disk program replaces the embedded one only if GDBVKGUI_PROG names it,
+// or if ~/.gdbvkgui/prog.luac was written after the executable was built
+static bool
+FindProgramOverride(char path[], size_t path_sz)
+{
+    const char* env_path = getenv("GDBVKGUI_PROG");
+    if (env_path && *env_path) {
+        snprintf(path, path_sz, "%s", env_path);
+        return true;
+    }
+
+    snprintf(path, path_sz, "%s/.gdbvkgui/prog.luac", getenv("HOME"));
+
+    FileInfo exe_info  = {};
+    FileInfo prog_info = {};
+    return GetFileInfo("/proc/self/exe", &exe_info) &&
+           GetFileInfo(path, &prog_info) &&
+           prog_info.m_LastEdit > exe_info.m_LastEdit;
 }
 
 static void
-LoadResources(const LoadSettings* lset)
+LoadAppCallbacks(void)
 {
-    s_finfo.m_Contents     = (char*)WmMalloc(lset->m_MaxFileSz);
-    s_finfo.m_ContentMaxSz = lset->m_MaxFileSz;
+    LuaRefs*    refs[] = { &s_app_init, &s_app_upd, &s_app_exit };
+    const char* func[] = { "Init", "Update", "OnExit" };
 
-    UNUSED_VAR(s_stream_data);
-    UNUSED_VAR(LuaDataStreamer);
+    lua_State* lstate = GetLuaState();
+    for (uint32_t i = 0; i < 3; i++) {
+        luaL_unref(lstate, LUA_REGISTRYINDEX, refs[i]->m_GlobalRef);
+        luaL_unref(lstate, LUA_REGISTRYINDEX, refs[i]->m_FuncRef);
+
+        int32_t g_ref = LUA_NOREF;
+        int32_t f_ref = GetLuaMethodReference("GdbApp", func[i], &g_ref);
+        refs[i]->m_GlobalRef = g_ref;
+        refs[i]->m_FuncRef   = f_ref;
+    }
+}
 
+static void
+LoadResources(const LoadSettings* lset)
+{
     char app[512] = { 0 };
-    snprintf(app, sizeof(app), "%s/.gdbvkgui/prog.luac", getenv("HOME"));
-    ParseLuaFile(app);
+    if (FindProgramOverride(app, sizeof(app))) {
+        ParseLuaFile(app);
+    } else {
+        s_stream_data.m_Data   = &_binary__tmp_prog_luac_start;
+        s_stream_data.m_DataSz = (size_t)(&_binary__tmp_prog_luac_end -
+                                          &_binary__tmp_prog_luac_start);
+        ParseLuaBinary("=prog.luac", &s_stream_data, LuaDataStreamer);
+    }
 
-    int32_t init_g_ref, init_f_ref;
-    init_f_ref = GetLuaMethodReference("GdbApp", "Init", &init_g_ref);
-    s_app_init.m_GlobalRef = init_g_ref;
-    s_app_init.m_FuncRef   = init_f_ref;
+    LoadAppCallbacks();
 
-    int32_t upd_g_ref, upd_f_ref;
-    upd_f_ref = GetLuaMethodReference("GdbApp", "Update", &upd_g_ref);
-    s_app_upd.m_GlobalRef = upd_g_ref;
-    s_app_upd.m_FuncRef   = upd_f_ref;
+    // scripts can be iterated on live from GDBVKGUI_SCRIPTS (default is the
+    // user directory)
+    const char* script_dir = getenv("GDBVKGUI_SCRIPTS");
+    if (script_dir == nullptr) {
+        snprintf(app, sizeof(app), "%s/.gdbvkgui", getenv("HOME"));
+        script_dir = app;
+    }
+    WatchScriptDir(script_dir);
 
-    int32_t exit_g_ref, exit_f_ref;
-    exit_f_ref = GetLuaMethodReference("GdbApp", "OnExit", &exit_g_ref);
-    s_app_exit.m_GlobalRef = exit_g_ref;
-    s_app_exit.m_FuncRef   = exit_f_ref;
+    // empty until gdb stops somewhere
+    SourceLoad(s_no_source, "", 0, nullptr, nullptr);
+    s_palette = TextEditor::GetDarkPalette();
+    s_active_tab = AddTab();
 
     // hook up C-functions
     lua_State* lstate = GetLuaState();
@@ -159,11 +594,35 @@ LoadResources(const LoadSettings* lset)
     AddCFunc(lstate, "FileDialog", OpenFileDialog);
     AddCFunc(lstate, "SendToGdb", SendToGdb);
     AddCFunc(lstate, "ReadFromGdb", ReadFromGdb);
+    AddCFunc(lstate, "SendToGdbAsync", SendToGdbAsync);
+    AddCFunc(lstate, "GdbTask", GdbTask);
+
+    luaL_requiref(lstate, "GdbMi", luaopen_GdbMi, 1);
+    luaL_requiref(lstate, "LuaProfiler", luaopen_LuaProfiler, 1);
+    luaL_requiref(lstate, "SessionJournal", luaopen_SessionJournal, 1);
+    luaL_requiref(lstate, "SourceSearch", luaopen_SourceSearch, 1);
+    luaL_requiref(lstate, "FuzzyFinder", luaopen_FuzzyFinder, 1);
+    lua_pop(lstate, 5);
     AddCFunc(lstate, "SetEditorFile", SetEditorFile);
     AddCFunc(lstate, "SetEditorFileLineNum", SetEditorFileLineNum);
     AddCFunc(lstate, "GetEditorFileLineNum", GetEditorFileLineNum);
     AddCFunc(lstate, "SetEditorBkPts", SetEditorBkPts);
+    AddCFunc(lstate, "SetEditorInlineValues", SetEditorInlineValues);
+    AddCFunc(lstate, "GetEditorHover", GetEditorHover);
+    AddCFunc(lstate, "OpenEditorTab", OpenEditorTab);
+    AddCFunc(lstate, "GetEditorFiles", GetEditorFiles);
     AddCFunc(lstate, "ShowTextEditor", ShowTextEditor);
+    AddCFunc(lstate, "GetTime", GetTime);
+    AddCFunc(lstate, "GetFrameStats", GetFrameStats);
+    AddCFunc(lstate, "GdbTraffic", GdbTraffic);
+
+    // a benchmark scenario is run by the lua side (see BenchScenario.lua)
+    if (lset->m_BenchScript) {
+        lua_pushstring(lstate, lset->m_BenchScript);
+        lua_setglobal(lstate, "BENCH_SCRIPT");
+        lua_pushstring(lstate, lset->m_BenchOut);
+        lua_setglobal(lstate, "BENCH_OUT");
+    }
 
     // initialize any neccessary lua state
     if (EnterLuaCallback(s_app_init.m_GlobalRef, s_app_init.m_FuncRef)) {
@@ -177,6 +636,15 @@ LuaUpdate(void)
     ImGui::DockSpaceOverViewport(ImGui::GetMainViewport());
     ImGuiIO& io = ImGui::GetIO();
 
+    // between frames, nothing of the previous one is on the lua stack
+    if (ReloadChangedModules()) {
+        LoadAppCallbacks();
+    }
+
+    LuaProfilerBeginFrame();
+
+    PollGdbTasks();
+
     if (EnterLuaCallback(s_app_upd.m_GlobalRef, s_app_upd.m_FuncRef)) {
         // push arguments
         lua_State* lstate = GetLuaState();
@@ -190,18 +658,31 @@ LuaUpdate(void)
         ExitLuaCallback();
     }
 
+    LuaProfilerEndFrame();
+
     return 0;
 }
 
 static int
 SaveAndExit(void)
 {
+    MiStopWorker();
+    LuaProfilerShutdown();
+
     if (EnterLuaCallback(s_app_exit.m_GlobalRef, s_app_exit.m_FuncRef)) {
         // push arguments
         // lua_State* lstate = GetLuaState();
 
         ExitLuaCallback();
     }
+    SessionJournalShutdown();
+    SourceSearchShutdown();
+    FuzzyFinderShutdown();
+    s_tabs.clear();
+    while (s_sources.size()) {
+        FreeSource(s_sources.back().get());
+        s_sources.pop_back();
+    }
     return 0;
 }
 
@@ -211,18 +692,21 @@ SetEditorTheme(lua_State* L)
     uint32_t idx = (int32_t)luaL_checkinteger(L, 1);
     switch (idx) {
         case 1:
-            s_editor.SetPalette(TextEditor::GetDarkPalette());
+            s_palette = TextEditor::GetDarkPalette();
             break;
         case 2:
-            s_editor.SetPalette(TextEditor::GetLightPalette());
+            s_palette = TextEditor::GetLightPalette();
             break;
         case 3:
-            s_editor.SetPalette(TextEditor::GetRetroBluePalette());
+            s_palette = TextEditor::GetRetroBluePalette();
             break;
         default:
-            s_editor.SetPalette(TextEditor::GetDarkPalette());
+            s_palette = TextEditor::GetDarkPalette();
             break;
     }
+    for (auto& tab : s_tabs) {
+        tab->m_View.m_Palette = s_palette;
+    }
     return 0;
 }
 
@@ -247,9 +731,10 @@ OpenFileDialog(lua_State* L)
 static int
 SendToGdb(lua_State* L)
 {
-    const char* cmd = (const char*)luaL_checkstring(L, 1);
+    size_t      cmd_sz = 0;
+    const char* cmd    = (const char*)luaL_checklstring(L, 1, &cmd_sz);
 
-    bool sent = SendCommand("%s", cmd);
+    bool sent = QueueCommand(0, cmd, (uint32_t)cmd_sz);
     lua_pushboolean(L, sent);
 
     return 1;
@@ -258,13 +743,249 @@ SendToGdb(lua_State* L)
 static int
 ReadFromGdb(lua_State* L)
 {
-    GetGdbResponse();
+    GdbMsg resp = GetGdbResponse();
+
+    if (s_pending_count == 0 && s_outstanding.Size == 0 &&
+        s_unclaimed.Size == 0 && s_inbox.Size == 0) {
+        lua_pushstring(L, s_output_text);
+        return 1;
+    }
+
+    // earlier lines first, then route replies of waiting tasks back to them
+    ImVector<char>& text = s_unclaimed;
+    AppendText(text, s_inbox.Data, s_inbox.Size);
+    // not the size capped copy, a task's reply may be in there
+    AppendText(text, resp.m_Msg, resp.m_MsgSz);
+    s_inbox.resize(0);
+
+    s_sync_reply.resize(0);
+    int32_t line_start = 0;
+    for (int32_t i = 0; i <= text.Size; i++) {
+        if (i < text.Size && text.Data[i] != '\n') {
+            continue;
+        }
+        const char* line    = text.Data + line_start;
+        uint32_t    line_sz = i - line_start;
+        uint32_t    token   = ResultToken(line, line_sz);
+
+        bool for_task = token && s_outstanding.contains(token);
+        if (line_sz) {
+            ImVector<char>& dst = for_task ? s_routed : s_sync_reply;
+            AppendText(dst, line, line_sz);
+            if (i < text.Size || for_task) {
+                dst.push_back('\n');
+            }
+        }
+        line_start = i + 1;
+    }
+    text.resize(0);
+
+    lua_pushlstring(L, s_sync_reply.Data, s_sync_reply.Size);
+
+    return 1;
+}
+
+// SendToGdbAsync(cmd [, parsed]) : w/ parsed set the reply is decoded off the
+// ui thread & the waiting task receives a GdbMi view instead of text
+static int
+SendToGdbAsync(lua_State* L)
+{
+    size_t      cmd_sz = 0;
+    const char* cmd    = (const char*)luaL_checklstring(L, 1, &cmd_sz);
+
+    uint32_t token = s_next_token++;
+    QueueCommand(token, cmd, (uint32_t)cmd_sz);
+    s_outstanding.push_back(token);
 
-    lua_pushstring(L, s_output_text);
+    if (lua_toboolean(L, 2)) {
+        s_parse_tokens.push_back(token);
+    }
+
+    lua_pushinteger(L, token);
 
     return 1;
 }
 
+static int
+GdbTask(lua_State* L)
+{
+    luaL_checktype(L, 1, LUA_TFUNCTION);
+    int32_t nargs = lua_gettop(L) - 1;
+
+    // move function & arguments onto a new thread, anchored in the registry
+    lua_State* task = lua_newthread(L);
+    lua_insert(L, 1);
+    lua_xmove(L, task, nargs + 1);
+    int32_t task_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+
+    bool waiting = ResumeTask(L, task, task_ref, nargs);
+    lua_pushboolean(L, waiting);
+
+    return 1;
+}
+
+static void
+FreeSource(CachedSource* source)
+{
+    SourceUnload(source->m_Doc);
+    UnmapFile(&source->m_File);
+}
+
+// Moves fname to the front of the cache, loading it when it's not there or
+// changed on disk
+static CachedSource*
+OpenSource(const char* fname)
+{
+    FileInfo info;
+    if (GetFileInfo(fname, &info) == false) {
+        return nullptr;
+    }
+
+    // tabs on a stale entry & where they were, they go to the new one
+    std::vector<std::pair<EditorTab*, ImVec2>> moved;
+
+    for (auto it = s_sources.begin(); it != s_sources.end(); ++it) {
+        CachedSource* source = it->get();
+        if (source->m_Path != fname) {
+            continue;
+        }
+
+        if (source->m_LastEdit == info.m_LastEdit &&
+            source->m_Sz == info.m_Sz && SourceCheckFile(source->m_Doc)) {
+            s_sources.splice(s_sources.begin(), s_sources, it);
+            return source;
+        }
+
+        // stale, the tabs on it show nothing until the new one is loaded
+        for (auto& tab : s_tabs) {
+            if (tab->m_Source == source) {
+                moved.emplace_back(
+                  tab.get(),
+                  ImVec2(tab->m_View.m_ScrollX, tab->m_View.m_ScrollY));
+                SetTabSource(tab.get(), nullptr);
+            }
+        }
+        FreeSource(source);
+        s_sources.erase(it);
+        break;
+    }
+
+    std::unique_ptr<CachedSource> source(new CachedSource()); // zeroed
+    source->m_Path     = fname;
+    source->m_LastEdit = info.m_LastEdit;
+    source->m_Sz       = info.m_Sz;
+    source->m_ScrollX  = 0.0f;
+    source->m_ScrollY  = 0.0f;
+
+    if (MapFile(fname, &source->m_File) == false) {
+        return nullptr;
+    }
+
+    const SourceLanguage* lang = GetSourceLanguage(SourceLexerForFile(fname));
+    if (SourceLoad(source->m_Doc,
+                   source->m_File.m_Data,
+                   source->m_File.m_Sz,
+                   lang,
+                   fname) == false) {
+        FreeSource(source.get());
+        return nullptr;
+    }
+    s_sources.push_front(std::move(source));
+
+    CachedSource* loaded = s_sources.front().get();
+    for (auto& tab : moved) {
+        SourceView& view = tab.first->m_View;
+        SetTabSource(tab.first, loaded);
+        view.m_ScrollX = tab.second.x;
+        view.m_ScrollY = tab.second.y;
+
+        // the file may have lost the lines the cursor was on
+        uint32_t count = SourceLineCount(loaded->m_Doc);
+        if (view.m_CursorLine >= count || view.m_SelStartLine >= count) {
+            SourceSetCursor(view, count ? count - 1 : 0, 0);
+        }
+    }
+
+    // bytes held : the mapped text & what the document built on top of it
+    size_t total = 0;
+    for (auto& cached : s_sources) {
+        total += cached->m_File.m_Sz + SourceMemoryUsage(cached->m_Doc);
+    }
+    // the new one has no tab yet
+    auto it = std::prev(s_sources.end());
+    while (it != s_sources.begin() && total > SOURCE_CACHE_SZ) {
+        CachedSource* oldest = it->get();
+        auto          prev   = std::prev(it);
+        if (oldest->m_Refs == 0) {
+            total -= oldest->m_File.m_Sz + SourceMemoryUsage(oldest->m_Doc);
+            FreeSource(oldest);
+            s_sources.erase(it);
+        }
+        it = prev;
+    }
+
+    return s_sources.front().get();
+}
+
+static EditorTab*
+AddTab(void)
+{
+    EditorTab* tab = new EditorTab;
+    tab->m_Source  = nullptr;
+    tab->m_Select  = false;
+    SourceViewInit(tab->m_View, &s_no_source);
+    tab->m_View.m_Palette = s_palette;
+
+    s_tabs.emplace_back(tab);
+    return tab;
+}
+
+static void
+SetTabSource(EditorTab* tab, CachedSource* source)
+{
+    if (tab->m_Source == source) {
+        return;
+    }
+
+    // the tab keeps its place in the file it leaves
+    if (tab->m_Source) {
+        tab->m_Source->m_ScrollX = tab->m_View.m_ScrollX;
+        tab->m_Source->m_ScrollY = tab->m_View.m_ScrollY;
+        tab->m_Source->m_Refs--;
+    }
+
+    tab->m_Source = source;
+    if (source) {
+        source->m_Refs++;
+        tab->m_View.m_Doc           = &source->m_Doc;
+        tab->m_View.m_Breakpoints   = &source->m_Breakpoints;
+        tab->m_View.m_InlineValues  = &source->m_InlineValues;
+        tab->m_View.m_ScrollX       = source->m_ScrollX;
+        tab->m_View.m_ScrollY       = source->m_ScrollY;
+        tab->m_View.m_RestoreScroll = true;
+    } else {
+        tab->m_View.m_Doc         = &s_no_source;
+        tab->m_View.m_Breakpoints  = nullptr;
+        tab->m_View.m_InlineValues = nullptr;
+    }
+}
+
+static void
+CloseTab(EditorTab* tab)
+{
+    SetTabSource(tab, nullptr);
+    if (s_active_tab == tab) {
+        s_active_tab = s_tabs.front().get();
+    }
+
+    for (auto it = s_tabs.begin(); it != s_tabs.end(); ++it) {
+        if (it->get() == tab) {
+            s_tabs.erase(it);
+            break;
+        }
+    }
+}
+
 static int
 SetEditorFile(lua_State* L)
 {
@@ -274,18 +995,12 @@ SetEditorFile(lua_State* L)
 
     bool success = false;
 
-    if (ReadFile(fname, &s_finfo)) {
-        s_editor.SetText(s_finfo.m_Contents);
-        s_editor.SetReadOnly(true);
-
-        line_num = CLAMP(line_num - 1, 0, (uint32_t)s_editor.GetTotalLines());
-
-        // set cursor to 0,0 then to actual location
-        // this should ensure that the text follows gdb
-        TextEditor::Coordinates cpos(0, 0);
-        s_editor.SetCursorPosition(cpos);
-        cpos.mLine = line_num;
-        s_editor.SetCursorPosition(cpos);
+    EditorTab*    tab    = s_tabs.front().get();
+    CachedSource* source = OpenSource(fname);
+    if (source) {
+        SetTabSource(tab, source);
+        SourceSetCursor(tab->m_View, line_num ? line_num - 1 : 0, 0);
+        tab->m_Select = true;
 
         success = true;
     }
@@ -299,55 +1014,250 @@ SetEditorFileLineNum(lua_State* L)
     uint32_t line_num = (uint32_t)luaL_checkinteger(L, 1);
     uint32_t clmn_num = (uint32_t)luaL_checkinteger(L, 2);
 
-    line_num = CLAMP(line_num - 1, 0, (uint32_t)s_editor.GetTotalLines());
-
-    TextEditor::Coordinates cpos(line_num, clmn_num);
-    s_editor.SetCursorPosition(cpos);
+    EditorTab* tab = s_tabs.front().get();
+    SourceSetCursor(tab->m_View, line_num ? line_num - 1 : 0, clmn_num);
+    tab->m_Select = true;
 
     return 0;
 }
 
+// Cursor line (0 based) & file of the selected tab
 static int
 GetEditorFileLineNum(lua_State* L)
 {
-    TextEditor::Coordinates cpos = s_editor.GetCursorPosition();
+    lua_pushinteger(L, s_active_tab->m_View.m_CursorLine);
+    if (s_active_tab->m_Source) {
+        lua_pushstring(L, s_active_tab->m_Source->m_Path.c_str());
+    } else {
+        lua_pushnil(L);
+    }
+
+    return 2;
+}
+
+// OpenEditorTab(file, line) : a new tab that stays on file, selected
+static int
+OpenEditorTab(lua_State* L)
+{
+    const char* fname    = (const char*)luaL_checkstring(L, 1);
+    uint32_t    line_num = (uint32_t)luaL_checkinteger(L, 2);
+
+    CachedSource* source = OpenSource(fname);
+    if (source) {
+        EditorTab* tab = AddTab();
+        SetTabSource(tab, source);
+        SourceSetCursor(tab->m_View, line_num ? line_num - 1 : 0, 0);
+        tab->m_Select = true;
+    }
+    lua_pushboolean(L, source != nullptr);
+    return 1;
+}
 
-    lua_pushinteger(L, cpos.mLine);
+// Files shown in the tabs, each once
+static int
+GetEditorFiles(lua_State* L)
+{
+    lua_newtable(L);
 
+    int32_t idx = 1;
+    for (auto& source : s_sources) {
+        if (source->m_Refs) {
+            lua_pushstring(L, source->m_Path.c_str());
+            lua_rawseti(L, -2, idx++);
+        }
+    }
     return 1;
 }
 
 static int
 SetEditorBkPts(lua_State* L)
 {
-    uint32_t bkpt_cnt = (uint32_t)luaL_checkinteger(L, 1);
+    uint32_t    bkpt_cnt = (uint32_t)luaL_checkinteger(L, 1);
+    const char* fname    = luaL_optstring(L, 3, nullptr);
+
+    // the file of the first tab by default
+    CachedSource* source = s_tabs.front()->m_Source;
+    if (fname) {
+        source = nullptr;
+        for (auto& cached : s_sources) {
+            if (cached->m_Path == fname) {
+                source = cached.get();
+                break;
+            }
+        }
+    }
+    if (source == nullptr) {
+        return 0;
+    }
+
+    source->m_Breakpoints.clear();
     if (bkpt_cnt) {
         float* fbuff = (float*)WmMalloc(bkpt_cnt * sizeof(float));
         ReadFBufferFromLua(fbuff, bkpt_cnt, 2);
 
-        TextEditor::Breakpoints bkpts;
         for (uint32_t i = 0; i < bkpt_cnt; i++) {
-            bkpts.insert(fbuff[i]);
+            source->m_Breakpoints.insert(fbuff[i]);
         }
-        s_editor.SetBreakpoints(bkpts);
 
         WmFree(fbuff);
-    } else {
-        // clear
-        TextEditor::Breakpoints bkpts;
-        s_editor.SetBreakpoints(bkpts);
     }
     return 0;
 }
 
+// SetEditorInlineValues(file, first, last, { name = value, ... }) : values
+// shown after the lines of file in [first, last] (1 based) that use them, in
+// place of the ones shown before. No arguments only clears them
+static int
+SetEditorInlineValues(lua_State* L)
+{
+    const char* fname = luaL_optstring(L, 1, nullptr);
+
+    for (auto& cached : s_sources) {
+        cached->m_InlineValues.m_Values.clear();
+    }
+    if (fname == nullptr) {
+        return 0;
+    }
+
+    uint32_t first = (uint32_t)luaL_checkinteger(L, 2);
+    uint32_t last  = (uint32_t)luaL_checkinteger(L, 3);
+    luaL_checktype(L, 4, LUA_TTABLE);
+
+    CachedSource* source = nullptr;
+    for (auto& cached : s_sources) {
+        if (cached->m_Path == fname) {
+            source = cached.get();
+            break;
+        }
+    }
+    if (source == nullptr) {
+        return 0;
+    }
+
+    SourceInlineValues& values = source->m_InlineValues;
+    values.m_FirstLine         = first ? first - 1 : 0;
+    values.m_LastLine          = last ? last - 1 : 0;
+
+    lua_pushnil(L);
+    while (lua_next(L, 4)) {
+        if (lua_type(L, -2) == LUA_TSTRING && lua_isstring(L, -1)) {
+            // one line each
+            std::string value = lua_tostring(L, -1);
+            std::replace(value.begin(), value.end(), '\n', ' ');
+            values.m_Values[lua_tostring(L, -2)] = std::move(value);
+        }
+        lua_pop(L, 1);
+    }
+    return 0;
+}
+
+// Expression under the mouse in the selected tab, nil when there's none.
+// Call after ShowTextEditor
+static int
+GetEditorHover(lua_State* L)
+{
+    std::string expr = SourceHoverExpression(s_active_tab->m_View);
+    if (expr.empty()) {
+        lua_pushnil(L);
+    } else {
+        lua_pushlstring(L, expr.data(), expr.size());
+    }
+    return 1;
+}
+
 static int
 ShowTextEditor(lua_State* L)
 {
     UNUSED_VAR(L);
 
-    s_editor.Render("Editor");
+    if (ImGui::BeginTabBar("EditorTabs",
+                           ImGuiTabBarFlags_AutoSelectNewTabs |
+                             ImGuiTabBarFlags_FittingPolicyScroll)) {
+        EditorTab* closed = nullptr;
+
+        for (auto& tab : s_tabs) {
+            const char* title = "(none)";
+            if (tab->m_Source) {
+                const char* slash = strrchr(tab->m_Source->m_Path.c_str(), '/');
+                title = slash ? slash + 1 : tab->m_Source->m_Path.c_str();
+            }
+
+            char label[256];
+            snprintf(label, sizeof(label), "%s###%p", title, (void*)tab.get());
+
+            ImGuiTabItemFlags flags = 0;
+            if (tab->m_Select) {
+                flags |= ImGuiTabItemFlags_SetSelected;
+                tab->m_Select = false;
+            }
+
+            // the first tab can't be closed
+            bool  open = true;
+            bool* p_open = tab == s_tabs.front() ? nullptr : &open;
+            if (ImGui::BeginTabItem(label, p_open, flags)) {
+                s_active_tab = tab.get();
+
+                // cut short on disk, the old mapping can't be read anymore
+                if (tab->m_Source && !SourceCheckFile(tab->m_Source->m_Doc)) {
+                    std::string path = tab->m_Source->m_Path;
+                    OpenSource(path.c_str());
+                }
+                SourceRender(tab->m_View, "Editor");
+                ImGui::EndTabItem();
+            }
+            if (!open) {
+                closed = tab.get();
+            }
+        }
+        ImGui::EndTabBar();
+
+        if (closed) {
+            CloseTab(closed);
+        }
+    }
 
     return 0;
 }
 
+// Monotonic wall clock in seconds
+static int
+GetTime(lua_State* L)
+{
+    lua_pushnumber(L, NanoToSec(GetHighResTime()));
+    return 1;
+}
+
+// Stats of the previous frame : { frames, cpu_ms, vtx, idx, cmds }
+static int
+GetFrameStats(lua_State* L)
+{
+    const GuiFrameStats* stats = GetGuiFrameStats();
+
+    lua_createtable(L, 0, 5);
+    lua_pushinteger(L, (lua_Integer)stats->m_Frames);
+    lua_setfield(L, -2, "frames");
+    lua_pushnumber(L, stats->m_CpuMs);
+    lua_setfield(L, -2, "cpu_ms");
+    lua_pushinteger(L, stats->m_VtxCount);
+    lua_setfield(L, -2, "vtx");
+    lua_pushinteger(L, stats->m_IdxCount);
+    lua_setfield(L, -2, "idx");
+    lua_pushinteger(L, stats->m_CmdCount);
+    lua_setfield(L, -2, "cmds");
+
+    return 1;
+}
+
+// Bytes sent to & received from gdb since startup
+static int
+GdbTraffic(lua_State* L)
+{
+    uint64_t sent = 0, received = 0;
+    GdbTrafficTotals(&sent, &received);
+
+    lua_pushinteger(L, (lua_Integer)sent);
+    lua_pushinteger(L, (lua_Integer)received);
+    return 2;
+}
+
 //-----------------------------------------------------------------------------
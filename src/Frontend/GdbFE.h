@@ -9,7 +9,9 @@ extern "C"
 
     typedef struct LoadSettings
     {
-        int m_MaxFileSz;
+        // --bench : scenario to run & where its JSON report goes
+        const char* m_BenchScript;
+        const char* m_BenchOut;
     } LoadSettings;
 
     void InitFrontend(const LoadSettings* settings);
@@ -0,0 +1,582 @@
+#include "Frontend/MiParser.h"
+#include "lua.hpp"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// NOTE : trees are built on the parser thread so they are allocated w/ malloc,
+// the WmMalloc arena is not thread safe
+
+//------------------------------------------------------------------------------
+
+struct MiParseState
+{
+    const char* m_Curr;
+    const char* m_End;
+
+    std::vector<MiNode> m_Nodes;
+    std::vector<MiNode> m_Stack; // children of the composites being parsed
+    std::vector<char>   m_Strings;
+};
+
+static bool
+ParseValue(MiParseState& ps, MiNode& node);
+
+static uint32_t
+AddString(MiParseState& ps, const char* str, uint32_t str_sz)
+{
+    uint32_t offset = (uint32_t)ps.m_Strings.size();
+    ps.m_Strings.insert(ps.m_Strings.end(), str, str + str_sz);
+    ps.m_Strings.push_back(0);
+    return offset;
+}
+
+static bool
+ParseCString(MiParseState& ps, MiNode& node)
+{
+    // skip opening quote
+    ps.m_Curr++;
+
+    node.m_Value = (uint32_t)ps.m_Strings.size();
+    while (ps.m_Curr < ps.m_End && *ps.m_Curr != '"') {
+        char ch = *ps.m_Curr++;
+        if (ch == '\\' && ps.m_Curr < ps.m_End) {
+            ch = *ps.m_Curr++;
+            switch (ch) {
+                case 'n':
+                    ch = '\n';
+                    break;
+                case 't':
+                    ch = '\t';
+                    break;
+                case 'r':
+                    ch = '\r';
+                    break;
+                case 'e':
+                    ch = '\033';
+                    break;
+                case '0':
+                case '1':
+                case '2':
+                case '3': {
+                    // octal escape (up to 3 digits)
+                    int32_t octal = ch - '0';
+                    for (int32_t i = 0; i < 2 && ps.m_Curr < ps.m_End &&
+                                        *ps.m_Curr >= '0' && *ps.m_Curr <= '7';
+                         i++) {
+                        octal = octal * 8 + (*ps.m_Curr++ - '0');
+                    }
+                    ch = (char)octal;
+                } break;
+                default:
+                    break;
+            }
+        }
+        ps.m_Strings.push_back(ch);
+    }
+    node.m_ValueSz = (uint32_t)ps.m_Strings.size() - node.m_Value;
+    ps.m_Strings.push_back(0);
+
+    if (ps.m_Curr == ps.m_End) {
+        return false;
+    }
+    // skip closing quote
+    ps.m_Curr++;
+    return true;
+}
+
+// result ::= variable "=" value. Values w/o a name are accepted as well
+static bool
+ParseResult(MiParseState& ps, MiNode& node)
+{
+    const char* name = ps.m_Curr;
+    while (ps.m_Curr < ps.m_End && *ps.m_Curr != '=' && *ps.m_Curr != ',' &&
+           *ps.m_Curr != '"' && *ps.m_Curr != '{' && *ps.m_Curr != '[' &&
+           *ps.m_Curr != '}' && *ps.m_Curr != ']') {
+        ps.m_Curr++;
+    }
+
+    if (ps.m_Curr < ps.m_End && *ps.m_Curr == '=') {
+        node.m_NameSz = (uint32_t)(ps.m_Curr - name);
+        node.m_Name   = AddString(ps, name, node.m_NameSz);
+        ps.m_Curr++;
+    } else {
+        ps.m_Curr = name;
+    }
+    return ParseValue(ps, node);
+}
+
+static bool
+ParseComposite(MiParseState& ps, MiNode& node, char close)
+{
+    size_t base = ps.m_Stack.size();
+
+    while (ps.m_Curr < ps.m_End && *ps.m_Curr != close) {
+        MiNode child = {};
+        if (ParseResult(ps, child) == false) {
+            return false;
+        }
+        ps.m_Stack.push_back(child);
+
+        if (ps.m_Curr < ps.m_End && *ps.m_Curr == ',') {
+            ps.m_Curr++;
+        }
+    }
+
+    // children are moved out together once all of their own children are
+    node.m_First = (uint32_t)ps.m_Nodes.size();
+    node.m_Count = (uint32_t)(ps.m_Stack.size() - base);
+    ps.m_Nodes.insert(
+      ps.m_Nodes.end(), ps.m_Stack.begin() + base, ps.m_Stack.end());
+    ps.m_Stack.resize(base);
+
+    if (ps.m_Curr == ps.m_End) {
+        return close == 0;
+    }
+    // skip closing bracket
+    ps.m_Curr++;
+    return true;
+}
+
+static bool
+ParseValue(MiParseState& ps, MiNode& node)
+{
+    if (ps.m_Curr == ps.m_End) {
+        return false;
+    }
+
+    switch (*ps.m_Curr) {
+        case '"':
+            node.m_Type = MI_CONST;
+            return ParseCString(ps, node);
+        case '{':
+            node.m_Type = MI_TUPLE;
+            ps.m_Curr++;
+            return ParseComposite(ps, node, '}');
+        case '[':
+            node.m_Type = MI_LIST;
+            ps.m_Curr++;
+            return ParseComposite(ps, node, ']');
+        default:
+            return false;
+    }
+}
+
+// Finds the line holding the result record ("[token]^class,...") or, failing
+// that, the first exec async record ("*class,...")
+static bool
+FindRecord(const char* text, uint32_t text_sz, const char** rec, uint32_t* sz)
+{
+    const char* async_rec = nullptr;
+    uint32_t    async_sz  = 0;
+
+    const char* end  = text + text_sz;
+    const char* line = text;
+    while (line < end) {
+        const char* line_end = (const char*)memchr(line, '\n', end - line);
+        line_end             = line_end ? line_end : end;
+
+        const char* mark = line;
+        while (mark < line_end && *mark >= '0' && *mark <= '9') {
+            mark++;
+        }
+        if (mark < line_end && *mark == '^') {
+            *rec = mark + 1;
+            *sz  = (uint32_t)(line_end - mark - 1);
+            return true;
+        }
+        if (async_rec == nullptr && mark < line_end && *mark == '*') {
+            async_rec = mark + 1;
+            async_sz  = (uint32_t)(line_end - mark - 1);
+        }
+        line = line_end + 1;
+    }
+
+    *rec = async_rec;
+    *sz  = async_sz;
+    return async_rec != nullptr;
+}
+
+MiTree*
+MiParse(const char* text, uint32_t text_sz)
+{
+    const char* rec    = nullptr;
+    uint32_t    rec_sz = 0;
+    if (FindRecord(text, text_sz, &rec, &rec_sz) == false) {
+        return nullptr;
+    }
+    // strip the carriage return gdb may send before the newline
+    if (rec_sz && rec[rec_sz - 1] == '\r') {
+        rec_sz--;
+    }
+
+    const char* class_end = (const char*)memchr(rec, ',', rec_sz);
+    class_end             = class_end ? class_end : rec + rec_sz;
+
+    MiParseState ps;
+    ps.m_Curr = class_end < rec + rec_sz ? class_end + 1 : class_end;
+    ps.m_End  = rec + rec_sz;
+    ps.m_Strings.reserve(rec_sz);
+
+    MiNode root = {};
+    root.m_Type = MI_TUPLE;
+    if (ParseComposite(ps, root, 0) == false) {
+        return nullptr;
+    }
+    ps.m_Nodes.push_back(root);
+
+    size_t nodes_sz = ps.m_Nodes.size() * sizeof(MiNode);
+    MiTree* tree = (MiTree*)malloc(sizeof(MiTree) + nodes_sz + ps.m_Strings.size());
+    if (tree == nullptr) {
+        return nullptr;
+    }
+
+    tree->m_Nodes     = (MiNode*)(tree + 1);
+    tree->m_Strings   = (char*)tree->m_Nodes + nodes_sz;
+    tree->m_NodeCount = (uint32_t)ps.m_Nodes.size();
+    tree->m_Root      = tree->m_NodeCount - 1;
+    tree->m_RefCount  = 1;
+
+    memcpy(tree->m_Nodes, ps.m_Nodes.data(), nodes_sz);
+    if (ps.m_Strings.size()) {
+        memcpy(tree->m_Strings, ps.m_Strings.data(), ps.m_Strings.size());
+    }
+
+    uint32_t class_sz = (uint32_t)(class_end - rec);
+    class_sz = class_sz < sizeof(tree->m_Class) ? class_sz : sizeof(tree->m_Class) - 1;
+    memcpy(tree->m_Class, rec, class_sz);
+    tree->m_Class[class_sz] = 0;
+
+    return tree;
+}
+
+void
+MiRelease(MiTree* tree)
+{
+    if (tree && --tree->m_RefCount == 0) {
+        free(tree);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Parser thread. Replies go in through s_jobs & come back as trees through
+// s_results, the ui thread never waits on a parse
+
+struct MiJob
+{
+    int64_t     m_UserId;
+    std::string m_Text;
+};
+
+struct MiResult
+{
+    int64_t m_UserId;
+    MiTree* m_Tree;
+};
+
+static std::thread             s_worker;
+static std::mutex              s_queue_lock;
+static std::condition_variable s_queue_cv;
+static std::deque<MiJob>       s_jobs;
+static std::deque<MiResult>    s_results;
+static bool                    s_worker_exit;
+
+static void
+MiWorker(void)
+{
+    std::unique_lock<std::mutex> lock(s_queue_lock);
+    while (true) {
+        s_queue_cv.wait(lock, [] { return s_worker_exit || s_jobs.size(); });
+        if (s_worker_exit) {
+            break;
+        }
+
+        MiJob job = std::move(s_jobs.front());
+        s_jobs.pop_front();
+
+        lock.unlock();
+        MiTree* tree = MiParse(job.m_Text.data(), (uint32_t)job.m_Text.size());
+        lock.lock();
+
+        s_results.push_back({ job.m_UserId, tree });
+    }
+}
+
+bool
+MiSubmit(int64_t user_id, const char* text, uint32_t text_sz)
+{
+    std::lock_guard<std::mutex> lock(s_queue_lock);
+
+    if (s_worker.joinable() == false) {
+        s_worker_exit = false;
+        s_worker      = std::thread(MiWorker);
+    }
+    s_jobs.push_back({ user_id, std::string(text, text_sz) });
+    s_queue_cv.notify_one();
+
+    return true;
+}
+
+bool
+MiPollResult(int64_t* user_id, MiTree** tree)
+{
+    std::lock_guard<std::mutex> lock(s_queue_lock);
+    if (s_results.empty()) {
+        return false;
+    }
+
+    *user_id = s_results.front().m_UserId;
+    *tree    = s_results.front().m_Tree;
+    s_results.pop_front();
+
+    return true;
+}
+
+void
+MiStopWorker(void)
+{
+    if (s_worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(s_queue_lock);
+            s_worker_exit = true;
+            s_queue_cv.notify_one();
+        }
+        s_worker.join();
+    }
+
+    for (MiResult& res : s_results) {
+        MiRelease(res.m_Tree);
+    }
+    s_results.clear();
+    s_jobs.clear();
+}
+
+//------------------------------------------------------------------------------
+// Lua view of a tree. Tuple members are read by name, list entries by index,
+// constants come back as strings. Nothing is copied until it is accessed
+
+#define MI_VALUE_MT "Gdb.MiValue"
+
+struct MiView
+{
+    MiTree*  m_Tree;
+    uint32_t m_Node;
+};
+
+static void
+PushMiNode(lua_State* L, MiTree* tree, uint32_t node_idx)
+{
+    const MiNode& node = tree->m_Nodes[node_idx];
+    if (node.m_Type == MI_CONST) {
+        lua_pushlstring(L, tree->m_Strings + node.m_Value, node.m_ValueSz);
+        return;
+    }
+
+    MiView* view = (MiView*)lua_newuserdatauv(L, sizeof(MiView), 0);
+    view->m_Tree = tree;
+    view->m_Node = node_idx;
+    tree->m_RefCount++;
+
+    luaL_setmetatable(L, MI_VALUE_MT);
+}
+
+void
+MiPushTree(lua_State* L, MiTree* tree)
+{
+    if (tree) {
+        PushMiNode(L, tree, tree->m_Root);
+    } else {
+        lua_pushnil(L);
+    }
+}
+
+static MiView*
+CheckMiView(lua_State* L, int idx)
+{
+    return (MiView*)luaL_checkudata(L, idx, MI_VALUE_MT);
+}
+
+static int
+MiViewIndex(lua_State* L)
+{
+    MiView*       view = CheckMiView(L, 1);
+    const MiNode& node = view->m_Tree->m_Nodes[view->m_Node];
+
+    if (lua_type(L, 2) == LUA_TNUMBER) {
+        lua_Integer idx = lua_tointeger(L, 2);
+        if (idx >= 1 && idx <= (lua_Integer)node.m_Count) {
+            PushMiNode(L, view->m_Tree, node.m_First + (uint32_t)idx - 1);
+            return 1;
+        }
+    } else if (lua_type(L, 2) == LUA_TSTRING) {
+        size_t      key_sz = 0;
+        const char* key    = lua_tolstring(L, 2, &key_sz);
+
+        const char* strings = view->m_Tree->m_Strings;
+        for (uint32_t i = 0; i < node.m_Count; i++) {
+            const MiNode& child = view->m_Tree->m_Nodes[node.m_First + i];
+            if (child.m_NameSz == key_sz &&
+                memcmp(strings + child.m_Name, key, key_sz) == 0) {
+                PushMiNode(L, view->m_Tree, node.m_First + i);
+                return 1;
+            }
+        }
+    }
+    lua_pushnil(L);
+    return 1;
+}
+
+static int
+MiViewLen(lua_State* L)
+{
+    MiView* view = CheckMiView(L, 1);
+    lua_pushinteger(L, view->m_Tree->m_Nodes[view->m_Node].m_Count);
+    return 1;
+}
+
+static int
+MiViewNext(lua_State* L)
+{
+    MiView*       view = CheckMiView(L, lua_upvalueindex(1));
+    const MiNode& node = view->m_Tree->m_Nodes[view->m_Node];
+
+    uint32_t idx = (uint32_t)lua_tointeger(L, lua_upvalueindex(2));
+    if (idx >= node.m_Count) {
+        return 0;
+    }
+    lua_pushinteger(L, idx + 1);
+    lua_replace(L, lua_upvalueindex(2));
+
+    // tuples iterate by member name, lists by position
+    const MiNode& child = view->m_Tree->m_Nodes[node.m_First + idx];
+    if (node.m_Type == MI_TUPLE && child.m_NameSz) {
+        lua_pushlstring(L, view->m_Tree->m_Strings + child.m_Name, child.m_NameSz);
+    } else {
+        lua_pushinteger(L, idx + 1);
+    }
+    PushMiNode(L, view->m_Tree, node.m_First + idx);
+    return 2;
+}
+
+static int
+MiViewPairs(lua_State* L)
+{
+    CheckMiView(L, 1);
+    lua_pushvalue(L, 1);
+    lua_pushinteger(L, 0);
+    lua_pushcclosure(L, MiViewNext, 2);
+    return 1;
+}
+
+static int
+MiViewToString(lua_State* L)
+{
+    MiView*       view = CheckMiView(L, 1);
+    const MiNode& node = view->m_Tree->m_Nodes[view->m_Node];
+    lua_pushfstring(L,
+                    "MiValue(%s, %d)",
+                    node.m_Type == MI_TUPLE ? "tuple" : "list",
+                    (int)node.m_Count);
+    return 1;
+}
+
+static int
+MiViewGc(lua_State* L)
+{
+    MiView* view = CheckMiView(L, 1);
+    MiRelease(view->m_Tree);
+    view->m_Tree = nullptr;
+    return 0;
+}
+
+static const luaL_Reg s_mi_view_meta[] = {
+    { "__index", MiViewIndex },
+    { "__len", MiViewLen },
+    { "__pairs", MiViewPairs },
+    { "__tostring", MiViewToString },
+    { "__gc", MiViewGc },
+    { NULL, NULL },
+};
+
+//------------------------------------------------------------------------------
+
+static void
+PushMiTable(lua_State* L, MiTree* tree, uint32_t node_idx)
+{
+    const MiNode& node = tree->m_Nodes[node_idx];
+    if (node.m_Type == MI_CONST) {
+        lua_pushlstring(L, tree->m_Strings + node.m_Value, node.m_ValueSz);
+        return;
+    }
+
+    bool as_array = node.m_Type == MI_LIST;
+    lua_createtable(L, as_array ? node.m_Count : 0, as_array ? 0 : node.m_Count);
+    for (uint32_t i = 0; i < node.m_Count; i++) {
+        const MiNode& child = tree->m_Nodes[node.m_First + i];
+        PushMiTable(L, tree, node.m_First + i);
+        if (as_array || child.m_NameSz == 0) {
+            lua_rawseti(L, -2, i + 1);
+        } else {
+            lua_setfield(L, -2, tree->m_Strings + child.m_Name);
+        }
+    }
+}
+
+// GdbMi.Parse(text) : parses on the calling thread
+static int
+MiLuaParse(lua_State* L)
+{
+    size_t      text_sz = 0;
+    const char* text    = luaL_checklstring(L, 1, &text_sz);
+
+    MiTree* tree = MiParse(text, (uint32_t)text_sz);
+    MiPushTree(L, tree);
+    MiRelease(tree);
+
+    return 1;
+}
+
+// GdbMi.Class(view) : "done", "error", "running", "stopped", ...
+static int
+MiLuaClass(lua_State* L)
+{
+    MiView* view = CheckMiView(L, 1);
+    lua_pushstring(L, view->m_Tree->m_Class);
+    return 1;
+}
+
+// GdbMi.ToTable(view) : deep copy into plain lua tables (lists -> arrays)
+static int
+MiLuaToTable(lua_State* L)
+{
+    if (lua_type(L, 1) == LUA_TSTRING) {
+        lua_settop(L, 1);
+        return 1;
+    }
+    MiView* view = CheckMiView(L, 1);
+    PushMiTable(L, view->m_Tree, view->m_Node);
+    return 1;
+}
+
+static const luaL_Reg s_mi_lib[] = {
+    { "Parse", MiLuaParse },
+    { "Class", MiLuaClass },
+    { "ToTable", MiLuaToTable },
+    { NULL, NULL },
+};
+
+int
+luaopen_GdbMi(lua_State* L)
+{
+    luaL_newmetatable(L, MI_VALUE_MT);
+    luaL_setfuncs(L, s_mi_view_meta, 0);
+    lua_pop(L, 1);
+
+    luaL_newlib(L, s_mi_lib);
+    return 1;
+}
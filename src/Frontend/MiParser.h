@@ -0,0 +1,69 @@
+#pragma once
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct lua_State lua_State;
+
+    typedef enum MiNodeType
+    {
+        MI_CONST = 0,
+        MI_TUPLE,
+        MI_LIST,
+    } MiNodeType;
+
+    // The children of a tuple/list are stored contiguously in the tree's node
+    // array. Names & (unescaped) values index into the tree's string block
+    typedef struct MiNode
+    {
+        uint32_t m_Type;
+        uint32_t m_Name;
+        uint32_t m_NameSz;
+        uint32_t m_Value;
+        uint32_t m_ValueSz;
+        uint32_t m_First;
+        uint32_t m_Count;
+    } MiNode;
+
+    // Immutable once parsed. Nodes & strings live in the same allocation
+    typedef struct MiTree
+    {
+        MiNode*  m_Nodes;
+        char*    m_Strings;
+        uint32_t m_NodeCount;
+        uint32_t m_Root;
+        int32_t  m_RefCount;
+        char     m_Class[16]; // done, running, error, stopped, ...
+    } MiTree;
+
+    // Parses the result record (or the first async record if there is none)
+    // of a gdb reply. Safe to call from any thread
+    MiTree* MiParse(const char* text, uint32_t text_sz);
+
+    void MiRelease(MiTree* tree);
+
+    //--------------------------------------------------------------------------
+
+    // Queues a reply for the parser thread (started on first use)
+    bool MiSubmit(int64_t user_id, const char* text, uint32_t text_sz);
+
+    // Non-blocking. Hands over one finished tree per call
+    bool MiPollResult(int64_t* user_id, MiTree** tree);
+
+    void MiStopWorker(void);
+
+    //--------------------------------------------------------------------------
+
+    // Pushes a read-only view of the tree's root & takes a reference to it
+    void MiPushTree(lua_State* L, MiTree* tree);
+
+    int luaopen_GdbMi(lua_State* L);
+
+#ifdef __cplusplus
+}
+#endif
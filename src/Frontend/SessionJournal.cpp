@@ -0,0 +1,252 @@
+#include "Frontend/SessionJournal.h"
+#include "lua.hpp"
+#include <condition_variable>
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+// Append-only session journal. The lua side batches a frame's worth of
+// records into one Append, which is a single O_APPEND write so a crash can
+// at worst cut the last line short. Snapshot() rotates the journal to
+// <prefix>.journal.old & hands the encoded state to a worker thread that
+// writes <prefix>.json.tmp, fsyncs it & renames it over the old snapshot.
+// Only once the new snapshot is durable is the rotated journal removed, so
+// at any point snapshot + journal.old + journal covers every change
+
+struct JournalFiles
+{
+    std::string m_Snapshot;
+    std::string m_SnapshotTmp;
+    std::string m_Journal;
+    std::string m_JournalOld;
+    std::string m_Dir;
+};
+
+static JournalFiles s_files;
+static int          s_journal_fd = -1;
+
+static std::thread             s_worker;
+static std::mutex              s_snap_lock;
+static std::condition_variable s_snap_cv;
+static std::string             s_snap_text;
+static bool                    s_snap_queued;
+static bool                    s_snap_busy; // queued or being written
+static bool                    s_worker_exit;
+
+//------------------------------------------------------------------------------
+
+static bool
+WriteAll(int fd, const char* data, size_t sz)
+{
+    while (sz) {
+        ssize_t written = write(fd, data, sz);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        sz -= written;
+    }
+    return true;
+}
+
+static bool
+WriteSnapshot(const std::string& text)
+{
+    int fd = open(s_files.m_SnapshotTmp.c_str(),
+                  O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                  0644);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = WriteAll(fd, text.data(), text.size()) && fsync(fd) == 0;
+    close(fd);
+
+    if (ok == false ||
+        rename(s_files.m_SnapshotTmp.c_str(), s_files.m_Snapshot.c_str())) {
+        unlink(s_files.m_SnapshotTmp.c_str());
+        return false;
+    }
+
+    // make the rename itself durable before dropping the old records
+    int dir_fd = open(s_files.m_Dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+    unlink(s_files.m_JournalOld.c_str());
+
+    return true;
+}
+
+static void
+SnapshotWorker(void)
+{
+    std::unique_lock<std::mutex> lock(s_snap_lock);
+    while (true) {
+        s_snap_cv.wait(lock, [] { return s_worker_exit || s_snap_queued; });
+        if (s_snap_queued == false) {
+            break; // exit only once the queued snapshot is written
+        }
+
+        std::string text = std::move(s_snap_text);
+        s_snap_queued    = false;
+
+        lock.unlock();
+        if (WriteSnapshot(text) == false) {
+            fprintf(stderr,
+                    "Session snapshot failed (%s): %s\n",
+                    s_files.m_Snapshot.c_str(),
+                    strerror(errno));
+        }
+        lock.lock();
+
+        s_snap_busy = false;
+    }
+}
+
+static bool
+OpenJournal(void)
+{
+    if (s_files.m_Journal.empty()) {
+        return false;
+    }
+    s_journal_fd = open(s_files.m_Journal.c_str(),
+                        O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+                        0644);
+    return s_journal_fd >= 0;
+}
+
+static void
+CloseJournal(void)
+{
+    if (s_journal_fd >= 0) {
+        fsync(s_journal_fd);
+        close(s_journal_fd);
+        s_journal_fd = -1;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void
+SessionJournalShutdown(void)
+{
+    if (s_worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(s_snap_lock);
+            s_worker_exit = true;
+            s_snap_cv.notify_one();
+        }
+        s_worker.join();
+    }
+    CloseJournal();
+}
+
+static int
+JournalOpen(lua_State* L)
+{
+    const char* prefix = luaL_checkstring(L, 1);
+
+    SessionJournalShutdown();
+
+    s_files.m_Snapshot    = std::string(prefix) + ".json";
+    s_files.m_SnapshotTmp = s_files.m_Snapshot + ".tmp";
+    s_files.m_Journal     = std::string(prefix) + ".journal";
+    s_files.m_JournalOld  = s_files.m_Journal + ".old";
+
+    std::string dir = s_files.m_Snapshot;
+    s_files.m_Dir   = dirname(&dir[0]);
+
+    // created on the first write, a run that changes nothing leaves no files
+    lua_pushboolean(L, access(s_files.m_Dir.c_str(), W_OK) == 0);
+    return 1;
+}
+
+static int
+JournalAppend(lua_State* L)
+{
+    size_t      sz   = 0;
+    const char* text = luaL_checklstring(L, 1, &sz);
+
+    if (s_journal_fd < 0) {
+        OpenJournal();
+    }
+    lua_pushboolean(L, s_journal_fd >= 0 && WriteAll(s_journal_fd, text, sz));
+    return 1;
+}
+
+static int
+JournalSnapshot(lua_State* L)
+{
+    size_t      sz   = 0;
+    const char* text = luaL_checklstring(L, 1, &sz);
+
+    std::lock_guard<std::mutex> lock(s_snap_lock);
+    if (s_journal_fd < 0) {
+        OpenJournal();
+    }
+    if (s_journal_fd < 0 || s_snap_busy) {
+        lua_pushboolean(L, false);
+        return 1;
+    }
+
+    // records already in journal.old (a snapshot that never made it to disk)
+    // stay there, the new snapshot covers them too
+    if (access(s_files.m_JournalOld.c_str(), F_OK) != 0) {
+        CloseJournal();
+        rename(s_files.m_Journal.c_str(), s_files.m_JournalOld.c_str());
+        if (OpenJournal() == false) {
+            lua_pushboolean(L, false);
+            return 1;
+        }
+    }
+
+    if (s_worker.joinable() == false) {
+        s_worker_exit = false;
+        s_worker      = std::thread(SnapshotWorker);
+    }
+    s_snap_text.assign(text, sz);
+    s_snap_queued = true;
+    s_snap_busy   = true;
+    s_snap_cv.notify_one();
+
+    lua_pushboolean(L, true);
+    return 1;
+}
+
+static int
+JournalBusy(lua_State* L)
+{
+    std::lock_guard<std::mutex> lock(s_snap_lock);
+    lua_pushboolean(L, s_snap_busy);
+    return 1;
+}
+
+static int
+JournalClose(lua_State* L)
+{
+    SessionJournalShutdown();
+    return 0;
+}
+
+static const luaL_Reg s_journal_lib[] = {
+    { "Open", JournalOpen },         { "Append", JournalAppend },
+    { "Snapshot", JournalSnapshot }, { "Busy", JournalBusy },
+    { "Close", JournalClose },       { NULL, NULL },
+};
+
+int
+luaopen_SessionJournal(lua_State* L)
+{
+    luaL_newlib(L, s_journal_lib);
+    return 1;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct lua_State lua_State;
+
+    // Global "SessionJournal" : Open(prefix), Append(text), Snapshot(text),
+    // Busy(), Close(). Files are <prefix>.json (snapshot), <prefix>.journal
+    // & <prefix>.journal.old (records written before the snapshot in flight)
+    int luaopen_SessionJournal(lua_State* L);
+
+    // Waits for a snapshot in flight to be on disk
+    void SessionJournalShutdown(void);
+
+#ifdef __cplusplus
+}
+#endif
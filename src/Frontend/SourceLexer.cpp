@@ -0,0 +1,345 @@
+#include "SourceLexer.h"
+
+#include <string.h>
+#include <strings.h>
+
+using PaletteIndex = TextEditor::PaletteIndex;
+
+// One lookup per character instead of a chain of range checks
+enum CharClass : uint8_t
+{
+    CC_OTHER = 0, // utf-8 bytes, control characters, '\\', '`', '@'
+    CC_BLANK,
+    CC_IDENT, // [A-Za-z_]
+    CC_DIGIT,
+    CC_QUOTE, // '"' & '\''
+    CC_DOT,
+    CC_HASH,
+    CC_DOLLAR,
+    CC_PERCENT,
+    CC_PUNCT,
+};
+
+struct CharClasses
+{
+    uint8_t m_Class[256];
+
+    CharClasses()
+    {
+        memset(m_Class, CC_OTHER, sizeof(m_Class));
+
+        for (int c = 'a'; c <= 'z'; c++)
+            m_Class[c] = CC_IDENT;
+        for (int c = 'A'; c <= 'Z'; c++)
+            m_Class[c] = CC_IDENT;
+        for (int c = '0'; c <= '9'; c++)
+            m_Class[c] = CC_DIGIT;
+        for (const char* c = "[]{}!^&*()-+=~|<>?:/;,"; *c; c++)
+            m_Class[(uint8_t)*c] = CC_PUNCT;
+
+        m_Class['_']  = CC_IDENT;
+        m_Class[' ']  = CC_BLANK;
+        m_Class['\t'] = CC_BLANK;
+        m_Class['\v'] = CC_BLANK;
+        m_Class['\f'] = CC_BLANK;
+        m_Class['"']  = CC_QUOTE;
+        m_Class['\''] = CC_QUOTE;
+        m_Class['.']  = CC_DOT;
+        m_Class['#']  = CC_HASH;
+        m_Class['$']  = CC_DOLLAR;
+        m_Class['%']  = CC_PERCENT;
+    }
+};
+
+static const CharClasses s_classes;
+
+static inline uint8_t
+ClassOf(char c)
+{
+    return s_classes.m_Class[(uint8_t)c];
+}
+
+static inline bool
+IsIdentChar(char c)
+{
+    uint8_t cc = ClassOf(c);
+    return cc == CC_IDENT || cc == CC_DIGIT;
+}
+
+//------------------------------------------------------------------------------
+// Scanners, each returns the end of what it matched
+
+static const char*
+SkipBlanks(const char* p, const char* end)
+{
+    while (p < end && ClassOf(*p) == CC_BLANK)
+        p++;
+    return p;
+}
+
+static const char*
+SkipIdent(const char* p, const char* end)
+{
+    while (p < end && IsIdentChar(*p))
+        p++;
+    return p;
+}
+
+// String or character literal, an unterminated one runs to the end of line
+static const char*
+SkipQuoted(const char* p, const char* end)
+{
+    char quote = *p++;
+    while (p < end) {
+        if (*p == '\\') {
+            p += 2;
+            continue;
+        }
+        if (*p++ == quote)
+            return p;
+    }
+    return end;
+}
+
+// Preprocessing number : covers hex, binary, floats (hex ones too),
+// suffixes & ' digit separators
+static const char*
+SkipNumber(const char* p, const char* end)
+{
+    p++;
+    while (p < end) {
+        char c = *p;
+        if ((c == 'e' || c == 'E' || c == 'p' || c == 'P') && p + 1 < end &&
+            (p[1] == '+' || p[1] == '-'))
+            p += 2;
+        else if (IsIdentChar(c) || c == '.')
+            p++;
+        else if (c == '\'' && p + 1 < end && IsIdentChar(p[1]))
+            p++;
+        else
+            break;
+    }
+    return p;
+}
+
+// L"", u"", U"", u8"" & the same for character literals
+static bool
+IsLiteralPrefix(const char* p, const char* end)
+{
+    size_t sz = end - p;
+    return (sz == 1 && (*p == 'L' || *p == 'u' || *p == 'U')) ||
+           (sz == 2 && p[0] == 'u' && p[1] == '8');
+}
+
+//------------------------------------------------------------------------------
+static bool
+TokenizeC(const char*   in_begin,
+          const char*   in_end,
+          const char*&  out_begin,
+          const char*&  out_end,
+          PaletteIndex& color)
+{
+    // blanks are a token of their own : the colorizer looks for comments &
+    // the preprocessor '#' where each token starts
+    const char* p = SkipBlanks(in_begin, in_end);
+    out_begin     = in_begin;
+    if (p > in_begin || p == in_end) {
+        out_end = p;
+        color   = PaletteIndex::Default;
+        return true;
+    }
+
+    switch (ClassOf(*p)) {
+        case CC_IDENT: {
+            out_end = SkipIdent(p, in_end);
+            color   = PaletteIndex::Identifier;
+
+            if (out_end < in_end && ClassOf(*out_end) == CC_QUOTE &&
+                IsLiteralPrefix(p, out_end)) {
+                color   = *out_end == '"' ? PaletteIndex::String
+                                          : PaletteIndex::CharLiteral;
+                out_end = SkipQuoted(out_end, in_end);
+            }
+            return true;
+        }
+        case CC_DOT:
+            if (p + 1 < in_end && ClassOf(p[1]) == CC_DIGIT) {
+                out_end = SkipNumber(p, in_end);
+                color   = PaletteIndex::Number;
+            } else {
+                out_end = p + 1;
+                color   = PaletteIndex::Punctuation;
+            }
+            return true;
+        case CC_DIGIT:
+            out_end = SkipNumber(p, in_end);
+            color   = PaletteIndex::Number;
+            return true;
+        case CC_QUOTE:
+            out_end = SkipQuoted(p, in_end);
+            color   = *p == '"' ? PaletteIndex::String
+                                : PaletteIndex::CharLiteral;
+            return true;
+        case CC_HASH:
+            out_end = p + 1;
+            color   = PaletteIndex::Preprocessor;
+            return true;
+        case CC_PUNCT:
+        case CC_PERCENT:
+            out_end = p + 1;
+            color   = PaletteIndex::Punctuation;
+            return true;
+        default:
+            // a whole run of anything else (utf-8 text in strings that
+            // weren't closed, stray '\\' ...) in one go
+            out_end = p + 1;
+            while (out_end < in_end && ClassOf(*out_end) == CC_OTHER)
+                out_end++;
+            color = PaletteIndex::Default;
+            return true;
+    }
+}
+
+//------------------------------------------------------------------------------
+static bool
+TokenizeAsm(const char*   in_begin,
+            const char*   in_end,
+            const char*&  out_begin,
+            const char*&  out_end,
+            PaletteIndex& color)
+{
+    // blanks are a token of their own : the colorizer looks for comments &
+    // the preprocessor '#' where each token starts
+    const char* p = SkipBlanks(in_begin, in_end);
+    out_begin     = in_begin;
+    if (p > in_begin || p == in_end) {
+        out_end = p;
+        color   = PaletteIndex::Default;
+        return true;
+    }
+
+    // symbols may hold '.' & '$' as well
+    auto symbol_end = [in_end](const char* s) {
+        while (s < in_end && (IsIdentChar(*s) || *s == '.' || *s == '$'))
+            s++;
+        return s;
+    };
+
+    switch (ClassOf(*p)) {
+        case CC_IDENT:
+            // mnemonics & labels
+            out_end = symbol_end(p + 1);
+            color   = PaletteIndex::Identifier;
+            return true;
+        case CC_DOT:
+            // directives, .L local labels are followed by ':'
+            out_end = symbol_end(p + 1);
+            color   = out_end < in_end && *out_end == ':'
+                        ? PaletteIndex::Identifier
+                        : PaletteIndex::Keyword;
+            return true;
+        case CC_PERCENT:
+            // registers
+            out_end = SkipIdent(p + 1, in_end);
+            color   = out_end > p + 1 ? PaletteIndex::KnownIdentifier
+                                      : PaletteIndex::Punctuation;
+            return true;
+        case CC_DOLLAR:
+            // immediates
+            if (p + 1 < in_end &&
+                (ClassOf(p[1]) == CC_DIGIT || p[1] == '-')) {
+                out_end = SkipNumber(p + 1, in_end);
+                color   = PaletteIndex::Number;
+            } else {
+                out_end = symbol_end(p + 1);
+                color   = PaletteIndex::Identifier;
+            }
+            return true;
+        case CC_DIGIT:
+            out_end = SkipNumber(p, in_end);
+            color   = PaletteIndex::Number;
+            return true;
+        case CC_QUOTE:
+            out_end = SkipQuoted(p, in_end);
+            color   = *p == '"' ? PaletteIndex::String
+                                : PaletteIndex::CharLiteral;
+            return true;
+        case CC_PUNCT:
+        case CC_HASH:
+            out_end = p + 1;
+            color   = PaletteIndex::Punctuation;
+            return true;
+        default:
+            out_end = p + 1;
+            while (out_end < in_end && ClassOf(*out_end) == CC_OTHER)
+                out_end++;
+            color = PaletteIndex::Default;
+            return true;
+    }
+}
+
+//------------------------------------------------------------------------------
+const TextEditor::LanguageDefinition&
+SourceLexerC(void)
+{
+    static TextEditor::LanguageDefinition s_def;
+    if (s_def.mName.empty()) {
+        s_def           = TextEditor::LanguageDefinition::C();
+        s_def.mTokenize = TokenizeC;
+        s_def.mTokenRegexStrings.clear();
+    }
+    return s_def;
+}
+
+const TextEditor::LanguageDefinition&
+SourceLexerCpp(void)
+{
+    static TextEditor::LanguageDefinition s_def;
+    if (s_def.mName.empty()) {
+        s_def           = TextEditor::LanguageDefinition::CPlusPlus();
+        s_def.mTokenize = TokenizeC;
+        s_def.mTokenRegexStrings.clear();
+    }
+    return s_def;
+}
+
+const TextEditor::LanguageDefinition&
+SourceLexerAsm(void)
+{
+    static TextEditor::LanguageDefinition s_def;
+    if (s_def.mName.empty()) {
+        s_def.mTokenize          = TokenizeAsm;
+        s_def.mCommentStart      = "/*";
+        s_def.mCommentEnd        = "*/";
+        s_def.mSingleLineComment = "#";
+        s_def.mName              = "Asm";
+    }
+    return s_def;
+}
+
+//------------------------------------------------------------------------------
+const TextEditor::LanguageDefinition&
+SourceLexerForFile(const char* fname)
+{
+    const char* slash = strrchr(fname, '/');
+    const char* ext   = strrchr(slash ? slash : fname, '.');
+    if (ext == nullptr)
+        return SourceLexerCpp();
+    ext++;
+
+    // .S is assembly run through cpp, '#' lines are comments here
+    if (!strcasecmp(ext, "s") || !strcasecmp(ext, "asm"))
+        return SourceLexerAsm();
+    if (!strcmp(ext, "c"))
+        return SourceLexerC();
+    if (!strcmp(ext, "lua"))
+        return TextEditor::LanguageDefinition::Lua();
+    if (!strcmp(ext, "glsl") || !strcmp(ext, "vert") || !strcmp(ext, "frag") ||
+        !strcmp(ext, "comp"))
+        return TextEditor::LanguageDefinition::GLSL();
+    if (!strcmp(ext, "hlsl"))
+        return TextEditor::LanguageDefinition::HLSL();
+
+    // .h is mostly shared w/ C++, which has the bigger keyword set
+    return SourceLexerCpp();
+}
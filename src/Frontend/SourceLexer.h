@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Frontend/TextEditor.h" // language definitions
+
+// Table driven tokenizers for the source viewer, plugged in through
+// LanguageDefinition::mTokenize so the regex list is never reached. The
+// keyword & identifier sets are the ones of the TextEditor languages
+
+const TextEditor::LanguageDefinition& SourceLexerC(void);
+const TextEditor::LanguageDefinition& SourceLexerCpp(void);
+
+// GNU as (AT&T syntax, '#' comments) : directives, registers & immediates
+const TextEditor::LanguageDefinition& SourceLexerAsm(void);
+
+// Picks the language from the file extension, C++ when it's not known
+const TextEditor::LanguageDefinition& SourceLexerForFile(const char* fname);
@@ -0,0 +1,605 @@
+#include "Frontend/SourceSearch.h"
+#include "ProcessIO.h"
+#include "lua.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <ctype.h>
+#include <dirent.h>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <string.h>
+#include <string>
+#include <strings.h>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+// Project wide search. The files (a given list, or the sources under a root
+// that a walker thread finds) are handed one at a time to a pool of threads
+// that map them & look for a literal w/ memmem/memchr. A regex is only run
+// on the lines holding the longest literal every match of it must contain,
+// or on every line when it has none. Hits are batched per file & wait for
+// Poll under the job's lock
+
+#define SEARCH_MAX_THREADS 16
+#define SEARCH_MAX_HITS    50000 // the search stops there
+#define SEARCH_POLL_MAX    2000  // hits per Poll w/o a max
+#define SEARCH_TEXT_SZ     200   // of a line in a hit
+#define SEARCH_BINARY_SZ   4096  // a NUL in there : not text
+
+struct SearchHit
+{
+    uint32_t    m_File;
+    uint32_t    m_Line; // 1 based
+    std::string m_Text;
+};
+
+struct SearchJob
+{
+    // set before the threads start
+    std::string m_Literal; // every match holds it, empty : none
+    bool        m_IgnoreCase;
+    bool        m_UseRegex;
+    std::regex  m_Regex;
+    std::string m_Root;
+
+    std::mutex               m_Lock;
+    std::condition_variable  m_FilesCv;
+    std::vector<std::string> m_Files;
+    size_t                   m_NextFile;
+    bool                     m_Walking; // more files to come
+    std::vector<SearchHit>   m_Hits;
+    size_t                   m_Polled;
+    bool                     m_Truncated;
+
+    std::atomic<bool>     m_Cancel;
+    std::atomic<uint32_t> m_FilesDone;
+    std::atomic<uint32_t> m_Running; // threads
+
+    std::thread              m_Walker;
+    std::vector<std::thread> m_Workers;
+};
+
+static std::unique_ptr<SearchJob> s_job;
+
+//------------------------------------------------------------------------------
+
+// Longest run of plain characters every match of the (ECMAScript) pattern
+// holds, empty when there is none
+static std::string
+RequiredLiteral(const std::string& pattern)
+{
+    // any run may be in an alternative that doesn't match
+    if (pattern.find('|') != std::string::npos) {
+        return std::string();
+    }
+
+    std::string best, run;
+    int32_t     depth = 0; // runs inside groups may be optional
+
+    auto flush = [&]() {
+        if (depth == 0 && run.size() > best.size()) {
+            best = run;
+        }
+        run.clear();
+    };
+
+    for (size_t i = 0; i < pattern.size(); i++) {
+        char c = pattern[i];
+        switch (c) {
+            case '\\':
+                if (i + 1 < pattern.size() &&
+                    ispunct((uint8_t)pattern[i + 1])) {
+                    run += pattern[++i];
+                } else if (i + 1 < pattern.size()) {
+                    // a class (\d, \w ...), a \b or an escape w/ operands the
+                    // run mustn't pick up (\x41, \u..., \cJ, \0, \1 ...)
+                    flush();
+                    char   e    = pattern[++i];
+                    size_t skip = e == 'x' ? 2 : e == 'u' ? 4 : 0;
+                    if (e == 'c') {
+                        skip = 1;
+                    }
+                    if (isdigit((uint8_t)e)) {
+                        while (i + 1 < pattern.size() &&
+                               isdigit((uint8_t)pattern[i + 1])) {
+                            i++;
+                        }
+                    }
+                    i = std::min(i + skip, pattern.size() - 1);
+                }
+                break;
+            case '*':
+            case '?':
+            case '{':
+                // the character before may not be there
+                if (run.size()) {
+                    run.pop_back();
+                }
+                flush();
+                if (c == '{') {
+                    while (i < pattern.size() && pattern[i] != '}') {
+                        i++;
+                    }
+                }
+                break;
+            case '[':
+                flush();
+                i++;
+                if (i < pattern.size() && pattern[i] == ']') {
+                    i++;
+                }
+                while (i < pattern.size() && pattern[i] != ']') {
+                    i += pattern[i] == '\\' ? 2 : 1;
+                }
+                break;
+            case '(':
+                flush();
+                depth++;
+                break;
+            case ')':
+                flush();
+                depth--;
+                break;
+            case '+':
+            case '.':
+            case '^':
+            case '$':
+                flush();
+                break;
+            default:
+                run += c;
+                break;
+        }
+    }
+    flush();
+
+    return best;
+}
+
+// Next occurrence of the job's literal in [p, end). memchr does the scanning
+// for both cases of the first character when the case is ignored
+static const char*
+FindLiteral(const SearchJob& job, const char* p, const char* end)
+{
+    const std::string& lit = job.m_Literal;
+    if ((size_t)(end - p) < lit.size()) {
+        return nullptr;
+    }
+    if (job.m_IgnoreCase == false) {
+        return (const char*)memmem(p, end - p, lit.data(), lit.size());
+    }
+
+    const char* last  = end - lit.size(); // last place it can start
+    const char  lower = (char)tolower((uint8_t)lit[0]);
+    const char  upper = (char)toupper((uint8_t)lit[0]);
+
+    const char* next_lower = nullptr; // kept while it's ahead of p
+    while (p <= last) {
+        if (next_lower < p) {
+            next_lower = (const char*)memchr(p, lower, last - p + 1);
+            if (next_lower == nullptr) {
+                next_lower = last + 1;
+            }
+        }
+
+        const char* first = next_lower;
+        if (upper != lower) {
+            const char* next_upper =
+              (const char*)memchr(p, upper, next_lower - p);
+            first = next_upper ? next_upper : next_lower;
+        }
+        if (first > last) {
+            return nullptr;
+        }
+        if (strncasecmp(first + 1, lit.data() + 1, lit.size() - 1) == 0) {
+            return first;
+        }
+        p = first + 1;
+    }
+    return nullptr;
+}
+
+static uint32_t
+CountLines(const char* p, const char* end)
+{
+    uint32_t count = 0;
+    while ((p = (const char*)memchr(p, '\n', end - p))) {
+        count++;
+        p++;
+    }
+    return count;
+}
+
+static void
+SearchFile(SearchJob&             job,
+           uint32_t               file_idx,
+           const std::string&     path,
+           std::vector<SearchHit>& hits)
+{
+    MappedFile file;
+    if (MapFile(path.c_str(), &file) == false) {
+        return;
+    }
+
+    const char* text = file.m_Data;
+    const char* end  = text + file.m_Sz;
+    if (memchr(text, 0, std::min(file.m_Sz, (size_t)SEARCH_BINARY_SZ))) {
+        UnmapFile(&file);
+        return;
+    }
+
+    const char* p       = text; // always at the start of a line
+    const char* counted = text;
+    uint32_t    line    = 1;
+
+    while (p < end && job.m_Cancel == false) {
+        const char* line_begin = p;
+        if (job.m_Literal.size()) {
+            const char* found = FindLiteral(job, p, end);
+            if (found == nullptr) {
+                break;
+            }
+            const char* nl = (const char*)memrchr(p, '\n', found - p);
+            line_begin     = nl ? nl + 1 : p;
+        }
+        const char* line_end =
+          (const char*)memchr(line_begin, '\n', end - line_begin);
+        if (line_end == nullptr) {
+            line_end = end;
+        }
+
+        if (job.m_UseRegex == false ||
+            std::regex_search(line_begin, line_end, job.m_Regex)) {
+            line += CountLines(counted, line_begin);
+            counted = line_begin;
+
+            const char* shown_end = line_end;
+            if (shown_end > line_begin && shown_end[-1] == '\r') {
+                shown_end--;
+            }
+            while (line_begin < shown_end &&
+                   (*line_begin == ' ' || *line_begin == '\t')) {
+                line_begin++;
+            }
+            size_t shown_sz = std::min((size_t)(shown_end - line_begin),
+                                       (size_t)SEARCH_TEXT_SZ);
+
+            hits.push_back(
+              { file_idx, line, std::string(line_begin, shown_sz) });
+        }
+        p = line_end + 1;
+    }
+
+    UnmapFile(&file);
+}
+
+//------------------------------------------------------------------------------
+
+static void
+SearchWorker(SearchJob* job)
+{
+    std::vector<SearchHit> hits;
+    while (true) {
+        uint32_t    file_idx = 0;
+        std::string path;
+        {
+            std::unique_lock<std::mutex> lock(job->m_Lock);
+            job->m_FilesCv.wait(lock, [job] {
+                return job->m_Cancel || job->m_Walking == false ||
+                       job->m_NextFile < job->m_Files.size();
+            });
+            if (job->m_Cancel || job->m_NextFile == job->m_Files.size()) {
+                break;
+            }
+            file_idx = (uint32_t)job->m_NextFile++;
+            path     = job->m_Files[file_idx];
+        }
+
+        SearchFile(*job, file_idx, path, hits);
+        job->m_FilesDone++;
+
+        if (hits.size()) {
+            std::lock_guard<std::mutex> lock(job->m_Lock);
+
+            size_t room = SEARCH_MAX_HITS - job->m_Hits.size();
+            if (hits.size() >= room) {
+                hits.resize(room);
+                job->m_Truncated = true;
+                job->m_Cancel    = true;
+                job->m_FilesCv.notify_all();
+            }
+            job->m_Hits.insert(job->m_Hits.end(),
+                               std::make_move_iterator(hits.begin()),
+                               std::make_move_iterator(hits.end()));
+            hits.clear();
+        }
+    }
+    job->m_Running--;
+}
+
+static bool
+IsSourceFile(const char* name)
+{
+    static const char* s_exts[] = {
+        "c",   "h",   "cc",  "cpp", "cxx", "hh",   "hpp",  "hxx", "inl",
+        "ipp", "tcc", "s",   "S",   "asm", "m",    "mm",   "rs",  "go",
+        "lua", "py",  "zig", "d",   "f",   "f90",  "glsl", "hlsl",
+    };
+
+    const char* ext = strrchr(name, '.');
+    if (ext == nullptr) {
+        return false;
+    }
+    ext++;
+    for (const char* known : s_exts) {
+        if (strcmp(ext, known) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Depth first through the root, each directory's files go to the workers at
+// once. Hidden directories (.git ...) & symlinks are skipped
+static void
+SearchWalker(SearchJob* job)
+{
+    std::vector<std::string> dirs = { job->m_Root };
+    std::vector<std::string> found;
+
+    while (dirs.size() && job->m_Cancel == false) {
+        std::string dir = std::move(dirs.back());
+        dirs.pop_back();
+
+        DIR* dir_h = opendir(dir.c_str());
+        if (dir_h == nullptr) {
+            continue;
+        }
+        while (struct dirent* ent = readdir(dir_h)) {
+            if (ent->d_name[0] == '.') {
+                continue;
+            }
+            std::string path = dir + '/' + ent->d_name;
+
+            uint8_t type = ent->d_type;
+            if (type == DT_UNKNOWN) {
+                struct stat inf;
+                if (lstat(path.c_str(), &inf) != 0) {
+                    continue;
+                }
+                type = S_ISDIR(inf.st_mode)   ? DT_DIR
+                       : S_ISREG(inf.st_mode) ? DT_REG
+                                              : DT_UNKNOWN;
+            }
+
+            if (type == DT_DIR) {
+                dirs.push_back(std::move(path));
+            } else if (type == DT_REG && IsSourceFile(ent->d_name)) {
+                found.push_back(std::move(path));
+            }
+        }
+        closedir(dir_h);
+
+        if (found.size()) {
+            std::lock_guard<std::mutex> lock(job->m_Lock);
+            job->m_Files.insert(job->m_Files.end(),
+                                std::make_move_iterator(found.begin()),
+                                std::make_move_iterator(found.end()));
+            job->m_FilesCv.notify_all();
+            found.clear();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(job->m_Lock);
+        job->m_Walking = false;
+        job->m_FilesCv.notify_all();
+    }
+    job->m_Running--;
+}
+
+static void
+StopJob(SearchJob* job)
+{
+    {
+        std::lock_guard<std::mutex> lock(job->m_Lock);
+        job->m_Cancel = true;
+        job->m_FilesCv.notify_all();
+    }
+    if (job->m_Walker.joinable()) {
+        job->m_Walker.join();
+    }
+    for (std::thread& worker : job->m_Workers) {
+        worker.join();
+    }
+    job->m_Workers.clear();
+}
+
+//------------------------------------------------------------------------------
+
+void
+SourceSearchShutdown(void)
+{
+    if (s_job) {
+        StopJob(s_job.get());
+        s_job.reset();
+    }
+}
+
+static bool
+GetBoolOption(lua_State* L, int idx, const char* key)
+{
+    if (lua_istable(L, idx) == false) {
+        return false;
+    }
+    lua_getfield(L, idx, key);
+    bool val = lua_toboolean(L, -1);
+    lua_pop(L, 1);
+    return val;
+}
+
+// Start(pattern, { file, ... } | root [, { regex = bool, ignore_case = bool }])
+// -> true | false, error. Cancels the search in flight
+static int
+SearchStart(lua_State* L)
+{
+    size_t      pattern_sz = 0;
+    const char* pattern    = luaL_checklstring(L, 1, &pattern_sz);
+    if (lua_istable(L, 2) == false) {
+        luaL_checkstring(L, 2);
+    }
+
+    SourceSearchShutdown();
+
+    if (pattern_sz == 0) {
+        lua_pushboolean(L, false);
+        lua_pushstring(L, "empty pattern");
+        return 2;
+    }
+
+    std::unique_ptr<SearchJob> job(new SearchJob());
+    job->m_IgnoreCase = GetBoolOption(L, 3, "ignore_case");
+    job->m_UseRegex   = GetBoolOption(L, 3, "regex");
+    job->m_Cancel     = false;
+    job->m_FilesDone  = 0;
+
+    if (job->m_UseRegex) {
+        auto flags = std::regex::ECMAScript | std::regex::optimize;
+        if (job->m_IgnoreCase) {
+            flags |= std::regex::icase;
+        }
+        try {
+            job->m_Regex = std::regex(pattern, pattern_sz, flags);
+        } catch (const std::regex_error& err) {
+            lua_pushboolean(L, false);
+            lua_pushstring(L, err.what());
+            return 2;
+        }
+        job->m_Literal = RequiredLiteral(std::string(pattern, pattern_sz));
+    } else {
+        job->m_Literal.assign(pattern, pattern_sz);
+    }
+
+    if (lua_istable(L, 2)) {
+        lua_Integer count = luaL_len(L, 2);
+        job->m_Files.reserve(count);
+        for (lua_Integer i = 1; i <= count; i++) {
+            lua_rawgeti(L, 2, i);
+            if (lua_type(L, -1) == LUA_TSTRING) {
+                job->m_Files.emplace_back(lua_tostring(L, -1));
+            }
+            lua_pop(L, 1);
+        }
+    } else {
+        job->m_Root = lua_tostring(L, 2);
+        while (job->m_Root.size() > 1 && job->m_Root.back() == '/') {
+            job->m_Root.pop_back();
+        }
+        job->m_Walking = true;
+    }
+
+    uint32_t thread_count = std::thread::hardware_concurrency();
+    thread_count = std::min(thread_count, (uint32_t)SEARCH_MAX_THREADS);
+    thread_count = std::max(thread_count, 1u);
+    if (job->m_Walking == false) {
+        thread_count =
+          std::max(1u, std::min(thread_count, (uint32_t)job->m_Files.size()));
+    }
+
+    job->m_Running = thread_count + (job->m_Walking ? 1 : 0);
+    if (job->m_Walking) {
+        job->m_Walker = std::thread(SearchWalker, job.get());
+    }
+    for (uint32_t i = 0; i < thread_count; i++) {
+        job->m_Workers.emplace_back(SearchWorker, job.get());
+    }
+    s_job = std::move(job);
+
+    lua_pushboolean(L, true);
+    return 1;
+}
+
+// Poll([max]) -> { { file, short, line, text }, ... } found since the last
+// call
+static int
+SearchPoll(lua_State* L)
+{
+    size_t max = (size_t)luaL_optinteger(L, 1, SEARCH_POLL_MAX);
+
+    lua_newtable(L);
+    if (s_job == nullptr) {
+        return 1;
+    }
+
+    std::lock_guard<std::mutex> lock(s_job->m_Lock);
+
+    size_t count = std::min(max, s_job->m_Hits.size() - s_job->m_Polled);
+    for (size_t i = 0; i < count; i++) {
+        const SearchHit&   hit  = s_job->m_Hits[s_job->m_Polled + i];
+        const std::string& path = s_job->m_Files[hit.m_File];
+
+        lua_createtable(L, 0, 4);
+        lua_pushstring(L, path.c_str());
+        lua_setfield(L, -2, "file");
+        const char* slash = strrchr(path.c_str(), '/');
+        lua_pushstring(L, slash ? slash + 1 : path.c_str());
+        lua_setfield(L, -2, "short");
+        lua_pushinteger(L, hit.m_Line);
+        lua_setfield(L, -2, "line");
+        lua_pushlstring(L, hit.m_Text.data(), hit.m_Text.size());
+        lua_setfield(L, -2, "text");
+
+        lua_rawseti(L, -2, (lua_Integer)i + 1);
+    }
+    s_job->m_Polled += count;
+
+    return 1;
+}
+
+// Progress() -> files done, files found so far, busy, stopped at max hits
+static int
+SearchProgress(lua_State* L)
+{
+    if (s_job == nullptr) {
+        lua_pushinteger(L, 0);
+        lua_pushinteger(L, 0);
+        lua_pushboolean(L, false);
+        lua_pushboolean(L, false);
+        return 4;
+    }
+
+    std::lock_guard<std::mutex> lock(s_job->m_Lock);
+    lua_pushinteger(L, s_job->m_FilesDone);
+    lua_pushinteger(L, (lua_Integer)s_job->m_Files.size());
+    lua_pushboolean(L,
+                    s_job->m_Running > 0 ||
+                      s_job->m_Polled < s_job->m_Hits.size());
+    lua_pushboolean(L, s_job->m_Truncated);
+    return 4;
+}
+
+// Cancel() : the hits found so far can still be polled
+static int
+SearchCancel(lua_State* L)
+{
+    if (s_job) {
+        StopJob(s_job.get());
+    }
+    return 0;
+}
+
+static const luaL_Reg s_search_lib[] = {
+    { "Start", SearchStart },       { "Poll", SearchPoll },
+    { "Progress", SearchProgress }, { "Cancel", SearchCancel },
+    { NULL, NULL },
+};
+
+int
+luaopen_SourceSearch(lua_State* L)
+{
+    luaL_newlib(L, s_search_lib);
+    return 1;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct lua_State lua_State;
+
+    // Global "SourceSearch" : Start(pattern, files | root [, opts]),
+    // Poll([max]), Progress(), Cancel(). Files are scanned on a pool of
+    // threads, the lines that match are handed over by Poll as they're found
+    int luaopen_SourceSearch(lua_State* L);
+
+    // Cancels the search in flight & waits for its threads
+    void SourceSearchShutdown(void);
+
+#ifdef __cplusplus
+}
+#endif
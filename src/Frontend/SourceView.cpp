@@ -0,0 +1,1285 @@
+#include "SourceView.h"
+#include "ProcessIO.h"
+#include "imgui_internal.h" // ImTextCharFromUtf8
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define VISIBLE_WAIT_MS 2.0 // longest a frame waits for the colours on screen
+#define INLINE_VALUE_CHARS 48 // longer values are cut
+#define INLINE_VALUES_MAX 8   // per line
+
+static void
+StartColorizer(SourceDocument& doc);
+
+//------------------------------------------------------------------------------
+// Document
+//------------------------------------------------------------------------------
+
+const SourceLanguage*
+GetSourceLanguage(const TextEditor::LanguageDefinition& def)
+{
+    static std::vector<std::unique_ptr<SourceLanguage>> s_languages;
+
+    for (auto& lang : s_languages) {
+        if (lang->m_Source == &def)
+            return lang.get();
+    }
+
+    SourceLanguage* lang = new SourceLanguage;
+    lang->m_Source       = &def;
+    lang->m_Def          = def;
+    for (auto& r : def.mTokenRegexStrings) {
+        lang->m_Regexes.push_back(std::make_pair(
+          std::regex(r.first, std::regex_constants::optimize), r.second));
+    }
+
+    // same precedence as TextEditor::ColorizeRange
+    using PaletteIndex = TextEditor::PaletteIndex;
+    for (auto& id : def.mPreprocIdentifiers) {
+        lang->m_Words[id.first]        = PaletteIndex::PreprocIdentifier;
+        lang->m_PreprocWords[id.first] = PaletteIndex::PreprocIdentifier;
+    }
+    for (auto& id : def.mIdentifiers)
+        lang->m_Words[id.first] = PaletteIndex::KnownIdentifier;
+    for (auto& k : def.mKeywords)
+        lang->m_Words[k] = PaletteIndex::Keyword;
+
+    s_languages.emplace_back(lang);
+
+    return lang;
+}
+
+//------------------------------------------------------------------------------
+static void
+IndexLines(std::vector<uint32_t>& starts, const char* text, uint32_t sz)
+{
+    uint32_t i = 0;
+
+#ifdef __SSE2__
+    // 16 bytes at a time, one bit per newline
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; i + 16 <= sz; i += 16) {
+        __m128i  chunk = _mm_loadu_si128((const __m128i*)(text + i));
+        uint32_t mask =
+          (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+        while (mask) {
+            starts.push_back(i + __builtin_ctz(mask) + 1);
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for (; i < sz; i++) {
+        if (text[i] == '\n')
+            starts.push_back(i + 1);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool
+SourceLoad(SourceDocument&       doc,
+           const char*           text,
+           size_t                text_sz,
+           const SourceLanguage* lang,
+           const char*           path)
+{
+    SourceUnload(doc);
+
+    doc.m_Text   = "";
+    doc.m_TextSz = 0;
+    doc.m_LineStarts.clear();
+    doc.m_Lang = lang;
+    doc.m_Path = path ? path : "";
+    doc.m_Truncated.store(false);
+
+    if (text_sz >= UINT32_MAX)
+        return false;
+
+    doc.m_Text   = text ? text : "";
+    doc.m_TextSz = (uint32_t)text_sz;
+
+    // about 40 bytes per line in source files, the index is the only
+    // allocation that scales w/ the file
+    doc.m_LineStarts.reserve(text_sz / 32 + 2);
+    doc.m_LineStarts.push_back(0);
+    IndexLines(doc.m_LineStarts, text, doc.m_TextSz);
+
+    // end of the last line, which is empty when the text ends w/ a newline
+    doc.m_LineStarts.push_back(doc.m_TextSz);
+    doc.m_LineStarts.shrink_to_fit();
+
+    StartColorizer(doc);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool
+SourceCheckFile(SourceDocument& doc)
+{
+    if (doc.m_Truncated.load(std::memory_order_relaxed))
+        return false;
+
+    // a file that's gone (or replaced by a new one) leaves the mapping as it
+    // was, only one cut short in place takes pages away from it
+    FileInfo info;
+    if (doc.m_Path.empty() || !GetFileInfo(doc.m_Path.c_str(), &info) ||
+        info.m_Sz >= doc.m_TextSz)
+        return true;
+
+    doc.m_Truncated.store(true);
+    return false;
+}
+
+//------------------------------------------------------------------------------
+const char*
+SourceLine(const SourceDocument& doc, uint32_t line, uint32_t* sz)
+{
+    if (line >= SourceLineCount(doc)) {
+        *sz = 0;
+        return doc.m_Text;
+    }
+
+    uint32_t first = doc.m_LineStarts[line];
+    uint32_t last  = doc.m_LineStarts[line + 1];
+    if (last > first && doc.m_Text[last - 1] == '\n')
+        last--;
+    if (last > first && doc.m_Text[last - 1] == '\r')
+        last--;
+
+    *sz = last - first;
+    return doc.m_Text + first;
+}
+
+//------------------------------------------------------------------------------
+size_t
+SourceMemoryUsage(const SourceDocument& doc)
+{
+    size_t sz = doc.m_LineStarts.capacity() * sizeof(uint32_t) +
+                doc.m_BlockCount * sizeof(doc.m_Blocks[0]);
+
+    for (uint32_t i = 0; i < doc.m_BlockCount; i++) {
+        const ColorBlock* block = doc.m_Blocks[i].load();
+        if (block) {
+            sz += sizeof(ColorBlock) +
+                  block->m_Spans.capacity() * sizeof(ColorSpan) +
+                  block->m_SpanStarts.capacity() * sizeof(uint32_t);
+        }
+    }
+    return sz;
+}
+
+//------------------------------------------------------------------------------
+// Colorizer
+//------------------------------------------------------------------------------
+
+static bool
+MatchAt(const char* curr, const char* end, const std::string& str)
+{
+    return !str.empty() && (size_t)(end - curr) >= str.size() &&
+           memcmp(curr, str.data(), str.size()) == 0;
+}
+
+//------------------------------------------------------------------------------
+static void
+PushSpan(ColorBlock& block, uint32_t first, uint32_t column, uint32_t color)
+{
+    auto& spans = block.m_Spans;
+
+    if (spans.size() > first) {
+        if (spans.back().m_Color == color)
+            return;
+        if (spans.back().m_Column == column) {
+            spans.back().m_Color = color;
+            return;
+        }
+    }
+
+    ColorSpan span;
+    span.m_Column = std::min(column, 0xffffffu);
+    span.m_Color  = color;
+    spans.push_back(span);
+}
+
+//------------------------------------------------------------------------------
+// Same rules as TextEditor::ColorizeRange & ColorizeInternal, one line at a
+// time. Comments are only looked for between tokens, which also keeps
+// comment markers inside strings from being picked up
+static void
+ColorizeLine(const SourceDocument& doc,
+             uint32_t              line,
+             ColorState&           st,
+             ColorBlock&           block)
+{
+    using PaletteIndex = TextEditor::PaletteIndex;
+
+    const TextEditor::LanguageDefinition& def = doc.m_Lang->m_Def;
+
+    uint32_t    sz;
+    const char* begin = SourceLine(doc, line, &sz);
+    const char* end   = begin + sz;
+    uint32_t    first = (uint32_t)block.m_Spans.size();
+
+    if (!st.m_Continued) {
+        st.m_Preproc     = false;
+        st.m_LineComment = false;
+    }
+    st.m_Continued = sz > 0 && end[-1] == '\\';
+
+    if (st.m_LineComment) {
+        PushSpan(block, first, 0, (uint32_t)PaletteIndex::Comment);
+        st.m_LineComment = st.m_Continued;
+        return;
+    }
+
+    std::cmatch results;
+    std::string id;
+    bool        first_char = true;
+
+    for (const char* curr = begin; curr < end;) {
+        uint32_t column = (uint32_t)(curr - begin);
+
+        if (st.m_InComment) {
+            PushSpan(
+              block, first, column, (uint32_t)PaletteIndex::MultiLineComment);
+
+            const std::string& close = def.mCommentEnd;
+            const char*        found =
+              std::search(curr, end, close.begin(), close.end());
+            if (close.empty() || found == end)
+                break;
+
+            st.m_InComment = false;
+            curr           = found + close.size();
+            continue;
+        }
+
+        char c = *curr;
+        if (c != def.mPreprocChar && !isspace((uint8_t)c))
+            first_char = false;
+        if (first_char && c == def.mPreprocChar)
+            st.m_Preproc = true;
+
+        uint32_t flags = st.m_Preproc ? SPAN_PREPROC : 0;
+
+        if (MatchAt(curr, end, def.mSingleLineComment)) {
+            PushSpan(block, first, column, (uint32_t)PaletteIndex::Comment);
+            st.m_LineComment = st.m_Continued;
+            break;
+        }
+        if (MatchAt(curr, end, def.mCommentStart)) {
+            PushSpan(
+              block, first, column, (uint32_t)PaletteIndex::MultiLineComment);
+            st.m_InComment = true;
+            curr += def.mCommentStart.size();
+            continue;
+        }
+
+        const char*  token_begin = nullptr;
+        const char*  token_end   = nullptr;
+        PaletteIndex token_color = PaletteIndex::Default;
+        bool         found       = false;
+
+        if (def.mTokenize != nullptr)
+            found =
+              def.mTokenize(curr, end, token_begin, token_end, token_color);
+
+        if (!found) {
+            for (auto& p : doc.m_Lang->m_Regexes) {
+                if (std::regex_search(curr,
+                                      end,
+                                      results,
+                                      p.first,
+                                      std::regex_constants::match_continuous)) {
+                    found       = true;
+                    token_begin = results[0].first;
+                    token_end   = results[0].second;
+                    token_color = p.second;
+                    break;
+                }
+            }
+        }
+
+        if (!found || token_end <= curr) {
+            PushSpan(
+              block, first, column, (uint32_t)PaletteIndex::Default | flags);
+            curr++;
+            continue;
+        }
+
+        if (token_color == PaletteIndex::Identifier) {
+            id.assign(token_begin, token_end);
+            if (!def.mCaseSensitive)
+                std::transform(id.begin(), id.end(), id.begin(), ::toupper);
+
+            const auto& words = st.m_Preproc ? doc.m_Lang->m_PreprocWords
+                                             : doc.m_Lang->m_Words;
+            auto        word  = words.find(id);
+            if (word != words.end())
+                token_color = word->second;
+        }
+
+        if (token_begin > curr)
+            PushSpan(
+              block, first, column, (uint32_t)PaletteIndex::Default | flags);
+        PushSpan(block,
+                 first,
+                 (uint32_t)(token_begin - begin),
+                 (uint32_t)token_color | flags);
+        curr = token_end;
+    }
+}
+
+static bool
+SameState(const ColorState& a, const ColorState& b)
+{
+    return a.m_InComment == b.m_InComment && a.m_Continued == b.m_Continued &&
+           a.m_Preproc == b.m_Preproc && a.m_LineComment == b.m_LineComment;
+}
+
+//------------------------------------------------------------------------------
+static ColorBlock*
+ColorizeBlock(const SourceDocument& doc, uint32_t idx, ColorState state)
+{
+    uint32_t first = idx * COLOR_BLOCK_LINES;
+    uint32_t last  = std::min(first + COLOR_BLOCK_LINES, SourceLineCount(doc));
+
+    ColorBlock* block   = new ColorBlock;
+    block->m_StartState = state;
+    block->m_SpanStarts.reserve(last - first + 1);
+    block->m_SpanStarts.push_back(0);
+    for (uint32_t line = first; line < last; line++) {
+        ColorizeLine(doc, line, state, *block);
+        block->m_SpanStarts.push_back((uint32_t)block->m_Spans.size());
+    }
+    block->m_EndState = state;
+    block->m_Spans.shrink_to_fit();
+
+    return block;
+}
+
+//------------------------------------------------------------------------------
+// Next block to colorize & the state to start it from, false when there is
+// nothing left
+static bool
+PickBlock(SourceDocument& doc, uint32_t* idx, ColorState* state)
+{
+    // on screen : the state above is a guess until the in order pass is there
+    for (uint32_t i = doc.m_VisibleFirst; i < doc.m_VisibleLast; i++) {
+        if (doc.m_Blocks[i].load(std::memory_order_relaxed) == nullptr) {
+            ColorBlock* above =
+              i ? doc.m_Blocks[i - 1].load(std::memory_order_relaxed) : nullptr;
+            *idx   = i;
+            *state = above ? above->m_EndState : ColorState{};
+            return true;
+        }
+    }
+
+    // in order pass, skips the blocks that were guessed right
+    while (doc.m_NextBlock < doc.m_BlockCount) {
+        ColorBlock* block =
+          doc.m_Blocks[doc.m_NextBlock].load(std::memory_order_relaxed);
+        if (block == nullptr ||
+            !SameState(block->m_StartState, doc.m_NextState)) {
+            *idx   = doc.m_NextBlock;
+            *state = doc.m_NextState;
+            return true;
+        }
+        doc.m_NextState = block->m_EndState;
+        doc.m_NextBlock++;
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+static void
+ColorizerWorker(SourceDocument* doc)
+{
+    // the in order pass always has work until it's done, by then every
+    // block is there & the thread ends (a cached document holds none)
+    std::unique_lock<std::mutex> lock(doc->m_Lock);
+    while (true) {
+        uint32_t   idx;
+        ColorState state;
+        if (doc->m_WorkerExit || !PickBlock(*doc, &idx, &state))
+            break;
+
+        lock.unlock();
+        if (!SourceCheckFile(*doc)) {
+            lock.lock();
+            break;
+        }
+        ColorBlock* block = ColorizeBlock(*doc, idx, state);
+        lock.lock();
+
+        ColorBlock* old = doc->m_Blocks[idx].exchange(block);
+        if (old)
+            doc->m_Retired.push_back(old);
+        if (idx == doc->m_NextBlock && SameState(state, doc->m_NextState)) {
+            doc->m_NextState = block->m_EndState;
+            doc->m_NextBlock++;
+        }
+        doc->m_PublishCv.notify_all();
+    }
+}
+
+//------------------------------------------------------------------------------
+static void
+StartColorizer(SourceDocument& doc)
+{
+    uint32_t lines = SourceLineCount(doc);
+
+    doc.m_BlockCount = (lines + COLOR_BLOCK_LINES - 1) / COLOR_BLOCK_LINES;
+    doc.m_Blocks.reset(new std::atomic<ColorBlock*>[doc.m_BlockCount]);
+    for (uint32_t i = 0; i < doc.m_BlockCount; i++)
+        doc.m_Blocks[i].store(nullptr);
+
+    doc.m_VisibleFirst = 0;
+    doc.m_VisibleLast  = 0;
+    doc.m_NextBlock    = 0;
+    doc.m_NextState    = ColorState{};
+    doc.m_WorkerExit   = false;
+
+    if (doc.m_Lang && doc.m_BlockCount)
+        doc.m_Worker = std::thread(ColorizerWorker, &doc);
+}
+
+//------------------------------------------------------------------------------
+void
+SourceUnload(SourceDocument& doc)
+{
+    if (doc.m_Worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(doc.m_Lock);
+            doc.m_WorkerExit = true;
+        }
+        doc.m_Worker.join();
+    }
+
+    for (uint32_t i = 0; i < doc.m_BlockCount; i++)
+        delete doc.m_Blocks[i].load();
+    for (ColorBlock* block : doc.m_Retired)
+        delete block;
+
+    doc.m_Blocks.reset();
+    doc.m_BlockCount = 0;
+    doc.m_Retired.clear();
+}
+
+//------------------------------------------------------------------------------
+const ColorSpan*
+SourceLineSpans(const SourceDocument& doc, uint32_t line, uint32_t* count)
+{
+    uint32_t idx = line / COLOR_BLOCK_LINES;
+    if (idx >= doc.m_BlockCount)
+        return nullptr;
+
+    const ColorBlock* block = doc.m_Blocks[idx].load(std::memory_order_acquire);
+    if (block == nullptr)
+        return nullptr;
+
+    uint32_t i = line % COLOR_BLOCK_LINES;
+    *count     = block->m_SpanStarts[i + 1] - block->m_SpanStarts[i];
+    return block->m_Spans.data() + block->m_SpanStarts[i];
+}
+
+//------------------------------------------------------------------------------
+void
+SourceRequestLines(SourceDocument& doc,
+                   uint32_t        first,
+                   uint32_t        last,
+                   double          wait_ms)
+{
+    std::unique_lock<std::mutex> lock(doc.m_Lock);
+
+    // nothing from the last frame is still in use
+    for (ColorBlock* block : doc.m_Retired)
+        delete block;
+    doc.m_Retired.clear();
+
+    if (!doc.m_Worker.joinable())
+        return;
+
+    uint32_t first_block =
+      std::min(first / COLOR_BLOCK_LINES, doc.m_BlockCount);
+    uint32_t last_block = std::min(
+      (last + COLOR_BLOCK_LINES - 1) / COLOR_BLOCK_LINES, doc.m_BlockCount);
+
+    // picked up by the worker after the block it's on
+    doc.m_VisibleFirst = first_block;
+    doc.m_VisibleLast  = last_block;
+
+    // a new file or a jump shows up coloured on its first frame
+    auto visible_done = [&] {
+        for (uint32_t i = first_block; i < last_block; i++) {
+            if (doc.m_Blocks[i].load(std::memory_order_relaxed) == nullptr)
+                return false;
+        }
+        return true;
+    };
+    doc.m_PublishCv.wait_for(
+      lock,
+      std::chrono::microseconds((int64_t)(wait_ms * 1000.0)),
+      visible_done);
+}
+
+//------------------------------------------------------------------------------
+// View
+//------------------------------------------------------------------------------
+
+struct LineMetrics
+{
+    ImFont* m_Font;
+    float   m_FontSize;
+    float   m_TabWidth;
+    float   m_Height;
+};
+
+//------------------------------------------------------------------------------
+static float
+NextTabStop(const LineMetrics& lm, float x)
+{
+    return (1.0f + std::floor((1.0f + x) / lm.m_TabWidth)) * lm.m_TabWidth;
+}
+
+//------------------------------------------------------------------------------
+// Advances c over one (utf-8) character & returns its width at x
+static float
+CharWidth(const LineMetrics& lm, const char*& c, const char* end, float x)
+{
+    if (*c == '\t') {
+        c++;
+        return NextTabStop(lm, x) - x;
+    }
+
+    unsigned int ch = (uint8_t)*c;
+    if (ch < 0x80)
+        c++;
+    else
+        c += ImTextCharFromUtf8(&ch, c, end);
+
+    return lm.m_Font->GetCharAdvance((ImWchar)ch) * lm.m_FontSize /
+           lm.m_Font->FontSize;
+}
+
+//------------------------------------------------------------------------------
+static float
+ColumnToX(const LineMetrics& lm, const char* text, uint32_t sz, uint32_t column)
+{
+    const char* end = text + std::min(column, sz);
+    float       x   = 0.0f;
+    for (const char* c = text; c < end;)
+        x += CharWidth(lm, c, end, x);
+    return x;
+}
+
+//------------------------------------------------------------------------------
+static uint32_t
+XToColumn(const LineMetrics& lm, const char* text, uint32_t sz, float x)
+{
+    const char* end  = text + sz;
+    float       curr = 0.0f;
+    for (const char* c = text; c < end;) {
+        const char* start = c;
+        float       w     = CharWidth(lm, c, end, curr);
+        if (curr + w * 0.5f > x)
+            return (uint32_t)(start - text);
+        curr += w;
+    }
+    return sz;
+}
+
+//------------------------------------------------------------------------------
+static ImU32
+SpanColor(const ImU32* palette, uint32_t color)
+{
+    using PaletteIndex = TextEditor::PaletteIndex;
+
+    ImU32 col = palette[color & ~SPAN_PREPROC];
+    if (!(color & SPAN_PREPROC))
+        return col;
+
+    // same blend as TextEditor::GetGlyphColor
+    ImU32 pp = palette[(int)PaletteIndex::Preprocessor];
+    ImU32 c0 = ((pp & 0xff) + (col & 0xff)) / 2;
+    ImU32 c1 = (((pp >> 8) & 0xff) + ((col >> 8) & 0xff)) / 2;
+    ImU32 c2 = (((pp >> 16) & 0xff) + ((col >> 16) & 0xff)) / 2;
+    ImU32 c3 = (((pp >> 24) & 0xff) + ((col >> 24) & 0xff)) / 2;
+    return c0 | (c1 << 8) | (c2 << 16) | (c3 << 24);
+}
+
+//------------------------------------------------------------------------------
+static bool
+HasSelection(const SourceView& view)
+{
+    return view.m_SelStartLine != view.m_CursorLine ||
+           view.m_SelStartColumn != view.m_CursorColumn;
+}
+
+//------------------------------------------------------------------------------
+// Selection as [first, last) line/column pairs
+static void
+GetSelection(const SourceView& view, uint32_t sel[4])
+{
+    bool anchor_first =
+      view.m_SelStartLine < view.m_CursorLine ||
+      (view.m_SelStartLine == view.m_CursorLine &&
+       view.m_SelStartColumn < view.m_CursorColumn);
+
+    sel[0] = anchor_first ? view.m_SelStartLine : view.m_CursorLine;
+    sel[1] = anchor_first ? view.m_SelStartColumn : view.m_CursorColumn;
+    sel[2] = anchor_first ? view.m_CursorLine : view.m_SelStartLine;
+    sel[3] = anchor_first ? view.m_CursorColumn : view.m_SelStartColumn;
+}
+
+//------------------------------------------------------------------------------
+static void
+CopySelection(const SourceView& view)
+{
+    const SourceDocument& doc = *view.m_Doc;
+
+    uint32_t sel[4];
+    GetSelection(view, sel);
+
+    uint32_t sz;
+    if (!HasSelection(view)) {
+        // whole line, as the editor did
+        const char* text = SourceLine(doc, view.m_CursorLine, &sz);
+        ImGui::SetClipboardText(std::string(text, sz).c_str());
+        return;
+    }
+
+    // columns can be past the end of their line (the cursor keeps its
+    // column when it moves to a shorter one)
+    uint32_t first_sz;
+    SourceLine(doc, sel[0], &first_sz);
+    SourceLine(doc, sel[2], &sz);
+    uint32_t first = doc.m_LineStarts[sel[0]] + std::min(sel[1], first_sz);
+    uint32_t last  = doc.m_LineStarts[sel[2]] + std::min(sel[3], sz);
+    ImGui::SetClipboardText(
+      std::string(doc.m_Text + first, doc.m_Text + last).c_str());
+}
+
+//------------------------------------------------------------------------------
+static bool
+IsWordChar(char c)
+{
+    return isalnum((uint8_t)c) || c == '_';
+}
+
+//------------------------------------------------------------------------------
+static void
+SelectWord(SourceView& view)
+{
+    uint32_t    sz;
+    const char* text  = SourceLine(*view.m_Doc, view.m_CursorLine, &sz);
+    uint32_t    first = std::min(view.m_CursorColumn, sz);
+    uint32_t    last  = first;
+
+    while (first > 0 && IsWordChar(text[first - 1]))
+        first--;
+    while (last < sz && IsWordChar(text[last]))
+        last++;
+
+    view.m_SelStartColumn = first;
+    view.m_CursorColumn   = last;
+}
+
+//------------------------------------------------------------------------------
+static void
+MoveCursor(SourceView& view, int64_t line, bool select)
+{
+    uint32_t count = SourceLineCount(*view.m_Doc);
+    line = std::max<int64_t>(0, std::min<int64_t>(line, (int64_t)count - 1));
+
+    view.m_CursorLine     = (uint32_t)std::max<int64_t>(0, line);
+    view.m_ScrollToCursor = true;
+    if (!select) {
+        view.m_SelStartLine   = view.m_CursorLine;
+        view.m_SelStartColumn = view.m_CursorColumn;
+    }
+}
+
+//------------------------------------------------------------------------------
+static void
+HandleKeyboardInputs(SourceView& view, const LineMetrics& lm)
+{
+    ImGuiIO& io    = ImGui::GetIO();
+    bool     shift = io.KeyShift;
+    bool     ctrl  = io.ConfigMacOSXBehaviors ? io.KeySuper : io.KeyCtrl;
+    bool     alt   = io.ConfigMacOSXBehaviors ? io.KeyCtrl : io.KeyAlt;
+
+    if (!ImGui::IsWindowFocused())
+        return;
+
+    int64_t line = view.m_CursorLine;
+    int64_t page =
+      std::max(1, (int)((ImGui::GetWindowHeight() - 20.0f) / lm.m_Height) - 4);
+
+    if (!ctrl && !alt &&
+        ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_UpArrow)))
+        MoveCursor(view, line - 1, shift);
+    else if (!ctrl && !alt &&
+             ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_DownArrow)))
+        MoveCursor(view, line + 1, shift);
+    else if (!alt && ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_PageUp)))
+        MoveCursor(view, line - page, shift);
+    else if (!alt &&
+             ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_PageDown)))
+        MoveCursor(view, line + page, shift);
+    else if (ctrl && !alt &&
+             ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Home)))
+        MoveCursor(view, 0, shift);
+    else if (ctrl && !alt &&
+             ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_End)))
+        MoveCursor(view, SourceLineCount(*view.m_Doc), shift);
+    else if (ctrl && !shift && !alt &&
+             (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_C)) ||
+              ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Insert))))
+        CopySelection(view);
+    else if (ctrl && !shift && !alt &&
+             ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_A))) {
+        uint32_t count        = SourceLineCount(*view.m_Doc);
+        view.m_SelStartLine   = 0;
+        view.m_SelStartColumn = 0;
+        view.m_CursorLine     = count ? count - 1 : 0;
+        SourceLine(*view.m_Doc, view.m_CursorLine, &view.m_CursorColumn);
+    }
+}
+
+//------------------------------------------------------------------------------
+static void
+HandleMouseInputs(SourceView&        view,
+                  const LineMetrics& lm,
+                  ImVec2             origin,
+                  float              text_start)
+{
+    ImGuiIO& io = ImGui::GetIO();
+
+    if (ImGui::IsWindowHovered()) {
+        ImGui::SetMouseCursor(ImGuiMouseCursor_TextInput);
+
+        bool clicked = ImGui::IsMouseClicked(0);
+        bool dbl     = ImGui::IsMouseDoubleClicked(0);
+        if (clicked || dbl || (view.m_Selecting && ImGui::IsMouseDragging(0))) {
+            int64_t line =
+              (int64_t)std::floor((io.MousePos.y - origin.y) / lm.m_Height);
+            int64_t count = SourceLineCount(*view.m_Doc);
+            line = std::max<int64_t>(0, std::min<int64_t>(line, count - 1));
+
+            uint32_t    sz;
+            const char* text = SourceLine(*view.m_Doc, (uint32_t)line, &sz);
+            view.m_CursorLine = (uint32_t)line;
+            view.m_CursorColumn =
+              XToColumn(lm, text, sz, io.MousePos.x - origin.x - text_start);
+
+            if (clicked && !io.KeyShift) {
+                view.m_SelStartLine   = view.m_CursorLine;
+                view.m_SelStartColumn = view.m_CursorColumn;
+            }
+            if (dbl)
+                SelectWord(view);
+            if (clicked)
+                view.m_Selecting = true;
+        }
+    }
+
+    if (!ImGui::IsMouseDown(0))
+        view.m_Selecting = false;
+}
+
+//------------------------------------------------------------------------------
+// Strings, comments, keywords & preprocessor lines are left to the colorizer
+// to tell apart
+bool
+SourceExpressionAt(const SourceDocument& doc,
+                   uint32_t              line,
+                   uint32_t              column,
+                   uint32_t*             first_column,
+                   uint32_t*             last_column)
+{
+    using PaletteIndex = TextEditor::PaletteIndex;
+
+    uint32_t    sz;
+    const char* text = SourceLine(doc, line, &sz);
+    if (column >= sz)
+        return false;
+
+    uint32_t         nspans;
+    const ColorSpan* spans = SourceLineSpans(doc, line, &nspans);
+    if (spans == nullptr)
+        return false;
+
+    uint32_t span = 0;
+    while (span + 1 < nspans && spans[span + 1].m_Column <= column)
+        span++;
+    if (spans[span].m_Color != (uint32_t)PaletteIndex::Identifier ||
+        !IsWordChar(text[column]))
+        return false;
+
+    uint32_t first = column;
+    uint32_t last  = column;
+    while (first > 0 && IsWordChar(text[first - 1]))
+        first--;
+    while (last < sz && IsWordChar(text[last]))
+        last++;
+
+    // back over a.b & a->b, the member alone is no expression gdb knows
+    for (;;) {
+        uint32_t op = 0;
+        if (first >= 1 && text[first - 1] == '.')
+            op = 1;
+        else if (first >= 2 && text[first - 2] == '-' && text[first - 1] == '>')
+            op = 2;
+        if (op == 0 || first - op == 0 || !IsWordChar(text[first - op - 1]))
+            break;
+
+        first -= op;
+        while (first > 0 && IsWordChar(text[first - 1]))
+            first--;
+    }
+
+    *first_column = first;
+    *last_column  = last;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Finds the expression the mouse rests on
+static void
+UpdateHover(SourceView&        view,
+            const LineMetrics& lm,
+            ImVec2             origin,
+            float              text_start)
+{
+    if (!ImGui::IsWindowHovered() || ImGui::IsMouseDown(0))
+        return;
+
+    ImVec2 mouse = ImGui::GetIO().MousePos;
+    float  y     = (mouse.y - origin.y) / lm.m_Height;
+    if (y < 0.0f || y >= (float)SourceLineCount(*view.m_Doc))
+        return;
+
+    uint32_t    line = (uint32_t)y;
+    uint32_t    sz;
+    const char* text = SourceLine(*view.m_Doc, line, &sz);
+
+    // the character the mouse is on, not the nearest boundary
+    float       x    = mouse.x - origin.x - text_start;
+    float       curr = 0.0f;
+    const char* end  = text + sz;
+    const char* c    = text;
+    while (c < end) {
+        const char* start = c;
+        curr += CharWidth(lm, c, end, curr);
+        if (curr > x) {
+            c = start;
+            break;
+        }
+    }
+    if (x < 0.0f || c == end)
+        return;
+
+    uint32_t first, last;
+    if (SourceExpressionAt(
+          *view.m_Doc, line, (uint32_t)(c - text), &first, &last)) {
+        view.m_HoverFrame = ImGui::GetFrameCount();
+        view.m_HoverLine  = line;
+        view.m_HoverFirst = first;
+        view.m_HoverLast  = last;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Draws the visible part of one line, returns its (estimated) width
+static float
+DrawLine(const SourceView&  view,
+         const LineMetrics& lm,
+         const ImU32*       palette,
+         uint32_t           line,
+         ImVec2             pos,
+         float              clip_x)
+{
+    const SourceDocument& doc  = *view.m_Doc;
+    ImDrawList*           draw = ImGui::GetWindowDrawList();
+    uint32_t              sz;
+    const char*           text = SourceLine(doc, line, &sz);
+
+    // lines not colorized yet are drawn in the default colour
+    ColorSpan plain = { 0, (uint32_t)TextEditor::PaletteIndex::Default };
+    uint32_t         nspans;
+    const ColorSpan* spans = SourceLineSpans(doc, line, &nspans);
+    if (spans == nullptr) {
+        spans  = &plain;
+        nspans = 1;
+    }
+
+    float x = 0.0f;
+    for (uint32_t i = 0; i < nspans; i++) {
+        const char* p = text + std::min((uint32_t)spans[i].m_Column, sz);
+        const char* e = text + (i + 1 < nspans ? spans[i + 1].m_Column : sz);
+        ImU32       col = SpanColor(palette, spans[i].m_Color);
+
+        while (p < e) {
+            if (pos.x + x > clip_x) {
+                // the rest is off screen, only its width is needed
+                return x + (text + sz - p) * lm.m_TabWidth / 4.0f;
+            }
+
+            const char* tab = (const char*)memchr(p, '\t', e - p);
+            const char* run = tab ? tab : e;
+            if (run > p) {
+                draw->AddText(lm.m_Font,
+                              lm.m_FontSize,
+                              ImVec2(pos.x + x, pos.y),
+                              col,
+                              p,
+                              run);
+                x += lm.m_Font
+                       ->CalcTextSizeA(lm.m_FontSize, FLT_MAX, -1.0f, p, run)
+                       .x;
+            }
+            if (tab) {
+                x   = NextTabStop(lm, x);
+                run = tab + 1;
+            }
+            p = run;
+        }
+    }
+
+    return x;
+}
+
+//------------------------------------------------------------------------------
+// a in a.b, a->b & a::b is a member or a scope, not a local
+static bool
+IsQualifiedName(const char* text, uint32_t column)
+{
+    if (column > 0 && text[column - 1] == '.')
+        return true;
+    if (column < 2)
+        return false;
+
+    char a = text[column - 2];
+    char b = text[column - 1];
+    return (a == '-' && b == '>') || (a == ':' && b == ':');
+}
+
+//------------------------------------------------------------------------------
+// The identifier runs left by the colorizer are the lookup, so lines that
+// aren't drawn cost nothing
+std::string
+SourceInlineText(const SourceDocument&     doc,
+                 const SourceInlineValues& values,
+                 uint32_t                  line)
+{
+    using PaletteIndex = TextEditor::PaletteIndex;
+
+    std::string annot;
+    if (values.m_Values.empty() || line < values.m_FirstLine ||
+        line > values.m_LastLine)
+        return annot;
+
+    uint32_t         nspans;
+    const ColorSpan* spans = SourceLineSpans(doc, line, &nspans);
+    if (spans == nullptr)
+        return annot;
+
+    uint32_t    sz;
+    const char* text = SourceLine(doc, line, &sz);
+
+    const std::string* shown[INLINE_VALUES_MAX];
+    uint32_t           nshown = 0;
+    std::string        name;
+
+    for (uint32_t i = 0; i < nspans && nshown < INLINE_VALUES_MAX; i++) {
+        // comments, strings & preprocessor lines are left out, macros see
+        // no locals
+        if (spans[i].m_Color != (uint32_t)PaletteIndex::Identifier)
+            continue;
+
+        uint32_t first = spans[i].m_Column;
+        uint32_t last  = first;
+        while (last < sz && IsWordChar(text[last]))
+            last++;
+        if (last == first || IsQualifiedName(text, first))
+            continue;
+
+        name.assign(text + first, last - first);
+        auto value = values.m_Values.find(name);
+        if (value == values.m_Values.end() ||
+            std::find(shown, shown + nshown, &value->first) != shown + nshown)
+            continue;
+        shown[nshown++] = &value->first;
+
+        annot += annot.empty() ? "  " : ", ";
+        annot += value->first;
+        annot += " = ";
+        if (value->second.size() > INLINE_VALUE_CHARS) {
+            annot.append(value->second, 0, INLINE_VALUE_CHARS - 3);
+            annot += "...";
+        } else {
+            annot += value->second;
+        }
+    }
+    return annot;
+}
+
+//------------------------------------------------------------------------------
+static void
+DrawInlineValues(const SourceView&  view,
+                 const LineMetrics& lm,
+                 const ImU32*       palette,
+                 uint32_t           line,
+                 ImVec2             pos)
+{
+    if (view.m_InlineValues == nullptr)
+        return;
+
+    std::string annot =
+      SourceInlineText(*view.m_Doc, *view.m_InlineValues, line);
+    if (!annot.empty()) {
+        ImGui::GetWindowDrawList()->AddText(
+          lm.m_Font,
+          lm.m_FontSize,
+          pos,
+          palette[(int)TextEditor::PaletteIndex::Comment],
+          annot.data(),
+          annot.data() + annot.size());
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+SourceViewInit(SourceView& view, SourceDocument* doc)
+{
+    view.m_Doc            = doc;
+    view.m_CursorLine     = 0;
+    view.m_CursorColumn   = 0;
+    view.m_SelStartLine   = 0;
+    view.m_SelStartColumn = 0;
+    view.m_Selecting      = false;
+    view.m_ScrollToCursor = false;
+    view.m_RestoreScroll  = false;
+    view.m_ScrollX        = 0.0f;
+    view.m_ScrollY        = 0.0f;
+    view.m_HoverFrame     = -1;
+    view.m_HoverLine      = 0;
+    view.m_HoverFirst     = 0;
+    view.m_HoverLast      = 0;
+    view.m_Breakpoints    = nullptr;
+    view.m_InlineValues   = nullptr;
+    view.m_Palette = TextEditor::GetDarkPalette();
+}
+
+//------------------------------------------------------------------------------
+void
+SourceSetCursor(SourceView& view, uint32_t line, uint32_t column)
+{
+    uint32_t count = SourceLineCount(*view.m_Doc);
+
+    view.m_CursorLine     = count ? std::min(line, count - 1) : 0;
+    view.m_CursorColumn   = column;
+    view.m_SelStartLine   = view.m_CursorLine;
+    view.m_SelStartColumn = column;
+    view.m_ScrollToCursor = true;
+
+    // gets the colorizer there before the next frame scrolls to it
+    uint32_t half = COLOR_BLOCK_LINES / 2;
+    SourceRequestLines(*view.m_Doc,
+                       view.m_CursorLine > half ? view.m_CursorLine - half : 0,
+                       view.m_CursorLine + half,
+                       0.0);
+}
+
+//------------------------------------------------------------------------------
+void
+SourceRender(SourceView& view, const char* title)
+{
+    using PaletteIndex = TextEditor::PaletteIndex;
+
+    SourceDocument& doc = *view.m_Doc;
+
+    // its text can't be read anymore, until it's loaded again
+    if (doc.m_Truncated.load(std::memory_order_relaxed)) {
+        ImGui::TextDisabled("The file got shorter on disk");
+        return;
+    }
+
+    // the palette w/ the current alpha from style
+    ImU32 palette[(int)PaletteIndex::Max];
+    for (int i = 0; i < (int)PaletteIndex::Max; ++i) {
+        ImVec4 color = ImGui::ColorConvertU32ToFloat4(view.m_Palette[i]);
+        color.w *= ImGui::GetStyle().Alpha;
+        palette[i] = ImGui::ColorConvertFloat4ToU32(color);
+    }
+
+    ImGui::PushStyleColor(
+      ImGuiCol_ChildBg,
+      ImGui::ColorConvertU32ToFloat4(palette[(int)PaletteIndex::Background]));
+    ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0.0f, 0.0f));
+    ImGui::BeginChild(title,
+                      ImVec2(),
+                      false,
+                      ImGuiWindowFlags_HorizontalScrollbar |
+                        ImGuiWindowFlags_AlwaysHorizontalScrollbar |
+                        ImGuiWindowFlags_NoMove);
+
+    LineMetrics lm;
+    lm.m_Font     = ImGui::GetFont();
+    lm.m_FontSize = ImGui::GetFontSize();
+    lm.m_Height   = ImGui::GetTextLineHeightWithSpacing();
+    lm.m_TabWidth =
+      4.0f *
+      lm.m_Font->CalcTextSizeA(lm.m_FontSize, FLT_MAX, -1.0f, " ").x;
+
+    uint32_t count = SourceLineCount(doc);
+
+    char buf[16];
+    snprintf(buf, sizeof(buf), " %u ", count);
+    float text_start =
+      lm.m_Font->CalcTextSizeA(lm.m_FontSize, FLT_MAX, -1.0f, buf).x + 10.0f;
+
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+
+    HandleKeyboardInputs(view, lm);
+    HandleMouseInputs(view, lm, origin, text_start);
+    UpdateHover(view, lm, origin, text_start);
+
+    float scroll_x = ImGui::GetScrollX();
+    float scroll_y = ImGui::GetScrollY();
+
+    // where the view will be from the next frame on
+    float target_x = scroll_x;
+    float target_y = scroll_y;
+    if (view.m_RestoreScroll) {
+        view.m_RestoreScroll = false;
+        target_x             = view.m_ScrollX;
+        target_y             = view.m_ScrollY;
+        ImGui::SetScrollX(target_x);
+        ImGui::SetScrollY(target_y);
+    }
+    view.m_ScrollX = target_x;
+    view.m_ScrollY = target_y;
+
+    ImVec2      content = ImGui::GetWindowContentRegionMax();
+    ImDrawList* draw    = ImGui::GetWindowDrawList();
+    bool        focused = ImGui::IsWindowFocused();
+    float       clip_x  = origin.x + scroll_x + content.x;
+
+    uint32_t first = (uint32_t)std::floor(scroll_y / lm.m_Height);
+    uint32_t last =
+      std::min(count, first + (uint32_t)std::ceil(content.y / lm.m_Height) + 1);
+
+    SourceRequestLines(doc, first, last, VISIBLE_WAIT_MS);
+
+    uint32_t sel[4];
+    GetSelection(view, sel);
+    bool  has_sel = HasSelection(view);
+    float longest = text_start;
+
+    for (uint32_t line = first; line < last; line++) {
+        ImVec2 line_pos(origin.x, origin.y + line * lm.m_Height);
+        ImVec2 text_pos(line_pos.x + text_start, line_pos.y);
+        ImVec2 start(line_pos.x + scroll_x, line_pos.y);
+        ImVec2 end(line_pos.x + content.x + scroll_x,
+                   line_pos.y + lm.m_Height);
+
+        uint32_t    sz;
+        const char* text = SourceLine(doc, line, &sz);
+
+        // selection
+        if (has_sel && line >= sel[0] && line <= sel[2]) {
+            float x0 = line == sel[0] ? ColumnToX(lm, text, sz, sel[1]) : 0.0f;
+            float x1 = line == sel[2] ? ColumnToX(lm, text, sz, sel[3])
+                                      : ColumnToX(lm, text, sz, sz) +
+                                          lm.m_TabWidth / 4.0f;
+            if (x0 < x1) {
+                draw->AddRectFilled(
+                  ImVec2(text_pos.x + x0, text_pos.y),
+                  ImVec2(text_pos.x + x1, text_pos.y + lm.m_Height),
+                  palette[(int)PaletteIndex::Selection]);
+            }
+        }
+
+        if (view.m_Breakpoints && view.m_Breakpoints->count((int)line + 1)) {
+            draw->AddRectFilled(
+              start, end, palette[(int)PaletteIndex::Breakpoint]);
+        }
+
+        // line number (right aligned)
+        snprintf(buf, sizeof(buf), "%u  ", line + 1);
+        float num_w =
+          lm.m_Font->CalcTextSizeA(lm.m_FontSize, FLT_MAX, -1.0f, buf).x;
+        draw->AddText(ImVec2(line_pos.x + text_start - num_w, line_pos.y),
+                      palette[(int)PaletteIndex::LineNumber],
+                      buf);
+
+        if (line == view.m_CursorLine && !has_sel) {
+            draw->AddRectFilled(
+              start,
+              end,
+              palette[(int)(focused ? PaletteIndex::CurrentLineFill
+                                    : PaletteIndex::CurrentLineFillInactive)]);
+            draw->AddRect(
+              start, end, palette[(int)PaletteIndex::CurrentLineEdge], 1.0f);
+        }
+
+        float width = DrawLine(view, lm, palette, line, text_pos, clip_x);
+        longest     = std::max(longest, text_start + width);
+
+        if (text_pos.x + width < clip_x) {
+            DrawInlineValues(
+              view, lm, palette, line, ImVec2(text_pos.x + width, text_pos.y));
+        }
+    }
+
+    ImGui::Dummy(ImVec2(longest + 2.0f, count * lm.m_Height));
+
+    if (view.m_ScrollToCursor) {
+        view.m_ScrollToCursor = false;
+
+        // centered when it leaves the screen
+        float height = ImGui::GetWindowHeight();
+        float y      = view.m_CursorLine * lm.m_Height;
+        if (y < target_y || y + lm.m_Height > target_y + height - 20.0f) {
+            ImGui::SetScrollY(
+              std::max(0.0f, y - (height - lm.m_Height) * 0.5f));
+        }
+
+        uint32_t    sz;
+        const char* text = SourceLine(doc, view.m_CursorLine, &sz);
+        float       x =
+          text_start + ColumnToX(lm, text, sz, view.m_CursorColumn);
+        if (x < target_x + text_start || x > target_x + content.x)
+            ImGui::SetScrollX(std::max(0.0f, x - text_start));
+    }
+
+    ImGui::EndChild();
+    ImGui::PopStyleVar();
+    ImGui::PopStyleColor();
+}
+
+//------------------------------------------------------------------------------
+std::string
+SourceHoverExpression(const SourceView& view)
+{
+    // the view wasn't drawn this frame or the mouse is elsewhere
+    if (view.m_HoverFrame != ImGui::GetFrameCount())
+        return std::string();
+
+    uint32_t    sz;
+    const char* text  = SourceLine(*view.m_Doc, view.m_HoverLine, &sz);
+    uint32_t    last  = std::min(view.m_HoverLast, sz);
+    uint32_t    first = std::min(view.m_HoverFirst, last);
+    return std::string(text + first, text + last);
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "Frontend/TextEditor.h" // palettes & language definitions
+#include <atomic>
+#include <condition_variable>
+#include <inttypes.h>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Read-only source viewer. The text stays where it was loaded from (the
+// mapped file) & is indexed by line. Colours are runs per line, only the
+// visible lines are ever turned into draw calls
+
+// A run of one colour, from m_Column to the next run or the end of the line.
+// m_Color is a TextEditor::PaletteIndex | SPAN_PREPROC
+struct ColorSpan
+{
+    uint32_t m_Column : 24;
+    uint32_t m_Color : 8;
+};
+
+#define SPAN_PREPROC 0x80
+
+struct SourceLanguage
+{
+    const TextEditor::LanguageDefinition* m_Source; // the static definition
+    TextEditor::LanguageDefinition        m_Def;
+
+    std::vector<std::pair<std::regex, TextEditor::PaletteIndex>> m_Regexes;
+
+    // keywords, known & preprocessor identifiers in one lookup, the
+    // preprocessor ones alone for preprocessor lines
+    std::unordered_map<std::string, TextEditor::PaletteIndex> m_Words;
+    std::unordered_map<std::string, TextEditor::PaletteIndex> m_PreprocWords;
+};
+
+// State carried from one line to the next by the colorizer
+struct ColorState
+{
+    bool m_InComment; // multi line comment
+    bool m_Continued; // line ended w/ '\'
+    bool m_Preproc;
+    bool m_LineComment;
+};
+
+#define COLOR_BLOCK_LINES 128
+
+// Colours of COLOR_BLOCK_LINES lines, never changed once published : a
+// block colorized from the wrong state is replaced by a new one
+struct ColorBlock
+{
+    ColorState m_StartState;
+    ColorState m_EndState;
+
+    // the runs of line i are [m_SpanStarts[i], m_SpanStarts[i + 1])
+    std::vector<ColorSpan> m_Spans;
+    std::vector<uint32_t>  m_SpanStarts;
+};
+
+struct SourceDocument
+{
+    const char* m_Text; // not owned
+    uint32_t    m_TextSz;
+
+    // file the text is mapped from (empty : text in memory). Pages past the
+    // end of a file fault when they're read, so it's only read while the
+    // file is no shorter than it was (see SourceCheckFile)
+    std::string       m_Path;
+    std::atomic<bool> m_Truncated;
+
+    // line i is [m_LineStarts[i], m_LineStarts[i + 1]), newline included
+    std::vector<uint32_t> m_LineStarts;
+
+    const SourceLanguage* m_Lang;
+
+    // Colorizer thread : the blocks on screen come first, w/ the state the
+    // block above ended with (or none), then the whole file from the top.
+    // Blocks that were guessed wrong on the way are done again
+    std::unique_ptr<std::atomic<ColorBlock*>[]> m_Blocks;
+    uint32_t                                    m_BlockCount;
+
+    std::thread             m_Worker;
+    std::mutex              m_Lock;
+    std::condition_variable m_PublishCv;
+    bool                    m_WorkerExit;
+    uint32_t                m_VisibleFirst, m_VisibleLast; // blocks
+    uint32_t                m_NextBlock; // in order pass, from m_NextState
+    ColorState              m_NextState;
+    std::vector<ColorBlock*> m_Retired; // freed by the ui thread
+};
+
+// Values drawn at the end of the lines that use them, lines [m_FirstLine,
+// m_LastLine] (0 based). Names are looked up in the identifier runs of the
+// lines on screen
+struct SourceInlineValues
+{
+    uint32_t m_FirstLine, m_LastLine;
+
+    std::unordered_map<std::string, std::string> m_Values;
+};
+
+struct SourceView
+{
+    SourceDocument* m_Doc;
+
+    uint32_t m_CursorLine;
+    uint32_t m_CursorColumn;
+    uint32_t m_SelStartLine, m_SelStartColumn; // anchor of the selection
+    bool     m_Selecting;
+    bool     m_ScrollToCursor;
+
+    // scroll of the last frame, set it w/ m_RestoreScroll to go back to a
+    // position
+    float m_ScrollX, m_ScrollY;
+    bool  m_RestoreScroll;
+
+    // word under the mouse, columns [m_HoverFirst, m_HoverLast) of
+    // m_HoverLine. Only for the frame it was found in
+    int      m_HoverFrame;
+    uint32_t m_HoverLine, m_HoverFirst, m_HoverLast;
+
+    const std::unordered_set<int>* m_Breakpoints; // 1 based lines, or NULL
+    const SourceInlineValues*      m_InlineValues; // or NULL
+    TextEditor::Palette            m_Palette;
+};
+
+//------------------------------------------------------------------------------
+
+// Regexes are compiled once per language & kept for the whole run, def must
+// be one of the static definitions
+const SourceLanguage*
+GetSourceLanguage(const TextEditor::LanguageDefinition& def);
+
+// Indexes the lines of text, which must outlive the document (or the next
+// load) & starts colorizing it. path is the file text is mapped from, NULL
+// for text in memory. Fails for texts of 4 GB & more
+bool SourceLoad(SourceDocument&       doc,
+                const char*           text,
+                size_t                text_sz,
+                const SourceLanguage* lang,
+                const char*           path);
+
+// False once the file of the document got shorter than its text : it's not
+// read anymore & has to be loaded again. Checked by the colorizer before
+// each block, call it before drawing the document
+bool SourceCheckFile(SourceDocument& doc);
+
+// Stops the colorizer, call before the text goes away
+void SourceUnload(SourceDocument& doc);
+
+inline uint32_t
+SourceLineCount(const SourceDocument& doc)
+{
+    return doc.m_LineStarts.empty() ? 0 : (uint32_t)doc.m_LineStarts.size() - 1;
+}
+
+// Line w/o its newline
+const char* SourceLine(const SourceDocument& doc, uint32_t line, uint32_t* sz);
+
+// Colour runs of a line, NULL when it's not colorized yet. Only valid until
+// the next SourceRequestLines
+const ColorSpan*
+SourceLineSpans(const SourceDocument& doc, uint32_t line, uint32_t* count);
+
+// Moves lines [first, last) to the front of the colorizer & waits up to
+// wait_ms for them. Frees the blocks replaced since the last call
+void SourceRequestLines(SourceDocument& doc,
+                        uint32_t        first,
+                        uint32_t        last,
+                        double          wait_ms);
+
+// Heap bytes held by the document (the text itself is mapped)
+size_t SourceMemoryUsage(const SourceDocument& doc);
+
+//------------------------------------------------------------------------------
+
+void SourceViewInit(SourceView& view, SourceDocument* doc);
+
+// Moves the cursor (0 based line) & scrolls it into view
+void SourceSetCursor(SourceView& view, uint32_t line, uint32_t column);
+
+void SourceRender(SourceView& view, const char* title);
+
+// "  name = value, ..." for the values line (0 based) uses, once each & in
+// the order they come. Empty when it uses none or isn't colorized yet
+std::string SourceInlineText(const SourceDocument&     doc,
+                             const SourceInlineValues& values,
+                             uint32_t                  line);
+
+// Identifier at column (0 based) of line w/ the members it's reached
+// through, as columns [first, last). False for anything else
+bool SourceExpressionAt(const SourceDocument& doc,
+                        uint32_t              line,
+                        uint32_t              column,
+                        uint32_t*             first_column,
+                        uint32_t*             last_column);
+
+// Identifier under the mouse in the last SourceRender, w/ the members it's
+// reached through (p->pos for pos in p->pos[0]). Empty when there's none
+std::string SourceHoverExpression(const SourceView& view);
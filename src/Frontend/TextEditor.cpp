@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstring>
 #include <regex>
 #include <string>
 
@@ -1251,17 +1252,35 @@ TextEditor::Render(const char* aTitle, const ImVec2& aSize, bool aBorder)
 
 void
 TextEditor::SetText(const std::string& aText)
+{
+    SetText(aText.data(), aText.size());
+}
+
+void
+TextEditor::SetText(const char* aText, size_t aSize)
 {
     mLines.clear();
-    mLines.emplace_back(Line());
-    for (auto chr : aText) {
-        if (chr == '\r') {
+
+    // one pass per line w/ memchr, each line is allocated once
+    const char* end = aText + aSize;
+    while (true) {
+        const char* eol = (const char*)memchr(aText, '\n', end - aText);
+        const char* stop = eol ? eol : end;
+
+        mLines.emplace_back(Line());
+        Line& line = mLines.back();
+        line.reserve(stop - aText);
+        for (; aText < stop; aText++) {
             // ignore the carriage return character
-        } else if (chr == '\n')
-            mLines.emplace_back(Line());
-        else {
-            mLines.back().emplace_back(Glyph(chr, PaletteIndex::Default));
+            if (*aText != '\r') {
+                line.emplace_back(Glyph(*aText, PaletteIndex::Default));
+            }
+        }
+
+        if (eol == nullptr) {
+            break;
         }
+        aText = eol + 1;
     }
 
     mTextChanged = true;
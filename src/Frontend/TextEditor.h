@@ -224,6 +224,7 @@ class TextEditor
                        const ImVec2& aSize   = ImVec2(),
                        bool          aBorder = false);
     void        SetText(const std::string& aText);
+    void        SetText(const char* aText, size_t aSize);
     std::string GetText() const;
 
     void SetTextLines(const std::vector<std::string>& aLines);
@@ -35,6 +35,10 @@ extern "C"
     static int                      g_MinImageCount    = 2;
     static bool                     g_SwapChainRebuild = false;
 
+    static bool          s_headless;
+    static bool          s_count_geometry;
+    static GuiFrameStats s_frame_stats;
+
     static void check_vk_result(VkResult err)
     {
         if (err == 0)
@@ -333,14 +337,8 @@ extern "C"
           wd->ImageCount; // Now we can use the next set of semaphores
     }
 
-    void SetupGuiContext(VkStateBin* vkstate, AppWindowData* win)
+    static void InitImGuiContext()
     {
-        g_Instance = vkstate->m_Inst;
-        SetupVulkan();
-
-        ImGui_ImplVulkanH_Window* wd = &g_MainWindowData;
-        SetupVulkanWindow(
-          wd, vkstate->m_Surface, win->m_ClientW, win->m_ClientH);
         ImGui::CreateContext();
 
         // Setup back-end capabilities flags
@@ -379,54 +377,10 @@ extern "C"
         io.KeyMap[ImGuiKey_Z]           = g_KeyIds.WK_KEY_Z;
 
         // io.GetClipboardTextFn = GetClipBoard;
+    }
 
-        // Setup Platform/Renderer backends
-        ImGui_ImplVulkan_InitInfo init_info = {};
-        init_info.Instance                  = g_Instance;
-        init_info.PhysicalDevice            = g_PhysicalDevice;
-        init_info.Device                    = g_Device;
-        init_info.QueueFamily               = g_QueueFamily;
-        init_info.Queue                     = g_Queue;
-        init_info.PipelineCache             = g_PipelineCache;
-        init_info.DescriptorPool            = g_DescriptorPool;
-        init_info.Allocator                 = g_Allocator;
-        init_info.MinImageCount             = g_MinImageCount;
-        init_info.ImageCount                = wd->ImageCount;
-        init_info.CheckVkResultFn           = check_vk_result;
-        ImGui_ImplVulkan_Init(&init_info, wd->RenderPass);
-
-        VkResult err;
-        // Upload Fonts
-        {
-            // Use any command queue
-            VkCommandPool command_pool = wd->Frames[wd->FrameIndex].CommandPool;
-            VkCommandBuffer command_buffer =
-              wd->Frames[wd->FrameIndex].CommandBuffer;
-
-            err = vkResetCommandPool(g_Device, command_pool, 0);
-            check_vk_result(err);
-            VkCommandBufferBeginInfo begin_info = {};
-            begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-            begin_info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-            err = vkBeginCommandBuffer(command_buffer, &begin_info);
-            check_vk_result(err);
-
-            ImGui_ImplVulkan_CreateFontsTexture(command_buffer);
-
-            VkSubmitInfo end_info       = {};
-            end_info.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-            end_info.commandBufferCount = 1;
-            end_info.pCommandBuffers    = &command_buffer;
-            err                         = vkEndCommandBuffer(command_buffer);
-            check_vk_result(err);
-            err = vkQueueSubmit(g_Queue, 1, &end_info, VK_NULL_HANDLE);
-            check_vk_result(err);
-
-            err = vkDeviceWaitIdle(g_Device);
-            check_vk_result(err);
-            ImGui_ImplVulkan_DestroyFontUploadObjects();
-        }
-
+    static void SetupStyle()
+    {
         // Change style: corporate gray
         ImGuiStyle& style  = ImGui::GetStyle();
         ImVec4*     colors = style.Colors;
@@ -519,32 +473,10 @@ extern "C"
         // 0.28f);
     }
 
-    void ProcessGuiFrame(AppWindowData* win, FrontEndCB f_cb)
+    // Window/script input -> imgui io
+    static void FeedInput(AppWindowData* win)
     {
-        ImGui_ImplVulkanH_Window* wd = &g_MainWindowData;
-        ImVec4 clear_color           = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
-
-        // Resize swap chain?
         int width = win->m_ClientW, height = win->m_ClientH;
-        if (g_SwapChainRebuild) {
-            if (width > 0 && height > 0) {
-                ImGui_ImplVulkan_SetMinImageCount(g_MinImageCount);
-                ImGui_ImplVulkanH_CreateOrResizeWindow(g_Instance,
-                                                       g_PhysicalDevice,
-                                                       g_Device,
-                                                       &g_MainWindowData,
-                                                       g_QueueFamily,
-                                                       g_Allocator,
-                                                       width,
-                                                       height,
-                                                       g_MinImageCount);
-                g_MainWindowData.FrameIndex = 0;
-                g_SwapChainRebuild          = false;
-            }
-        }
-
-        // Start the Dear ImGui frame
-        ImGui_ImplVulkan_NewFrame();
 
         ImGuiIO&          io       = ImGui::GetIO();
         const KeySymData* key_data = AppRetrieveKeyData();
@@ -593,6 +525,151 @@ extern "C"
         io.DisplayFramebufferScale = ImVec2(1, 1);
 
         io.DeltaTime = (float)1.f / 60.f;
+    }
+
+    void SetupGuiContext(VkStateBin* vkstate, AppWindowData* win)
+    {
+        g_Instance = vkstate->m_Inst;
+        SetupVulkan();
+
+        ImGui_ImplVulkanH_Window* wd = &g_MainWindowData;
+        SetupVulkanWindow(
+          wd, vkstate->m_Surface, win->m_ClientW, win->m_ClientH);
+        InitImGuiContext();
+
+        // Setup Platform/Renderer backends
+        ImGui_ImplVulkan_InitInfo init_info = {};
+        init_info.Instance                  = g_Instance;
+        init_info.PhysicalDevice            = g_PhysicalDevice;
+        init_info.Device                    = g_Device;
+        init_info.QueueFamily               = g_QueueFamily;
+        init_info.Queue                     = g_Queue;
+        init_info.PipelineCache             = g_PipelineCache;
+        init_info.DescriptorPool            = g_DescriptorPool;
+        init_info.Allocator                 = g_Allocator;
+        init_info.MinImageCount             = g_MinImageCount;
+        init_info.ImageCount                = wd->ImageCount;
+        init_info.CheckVkResultFn           = check_vk_result;
+        ImGui_ImplVulkan_Init(&init_info, wd->RenderPass);
+
+        VkResult err;
+        // Upload Fonts
+        {
+            // Use any command queue
+            VkCommandPool command_pool = wd->Frames[wd->FrameIndex].CommandPool;
+            VkCommandBuffer command_buffer =
+              wd->Frames[wd->FrameIndex].CommandBuffer;
+
+            err = vkResetCommandPool(g_Device, command_pool, 0);
+            check_vk_result(err);
+            VkCommandBufferBeginInfo begin_info = {};
+            begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            begin_info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            err = vkBeginCommandBuffer(command_buffer, &begin_info);
+            check_vk_result(err);
+
+            ImGui_ImplVulkan_CreateFontsTexture(command_buffer);
+
+            VkSubmitInfo end_info       = {};
+            end_info.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            end_info.commandBufferCount = 1;
+            end_info.pCommandBuffers    = &command_buffer;
+            err                         = vkEndCommandBuffer(command_buffer);
+            check_vk_result(err);
+            err = vkQueueSubmit(g_Queue, 1, &end_info, VK_NULL_HANDLE);
+            check_vk_result(err);
+
+            err = vkDeviceWaitIdle(g_Device);
+            check_vk_result(err);
+            ImGui_ImplVulkan_DestroyFontUploadObjects();
+        }
+
+        SetupStyle();
+    }
+
+    void SetupHeadlessGuiContext(AppWindowData* win, bool count_geometry)
+    {
+        UNUSED_VAR(win);
+
+        s_headless       = true;
+        s_count_geometry = count_geometry;
+
+        InitImGuiContext();
+
+        ImGuiIO& io            = ImGui::GetIO();
+        io.BackendRendererName = "null";
+
+        // nothing to upload to, NewFrame only needs the atlas to be built
+        unsigned char* pixels = NULL;
+        int            tex_w = 0, tex_h = 0;
+        io.Fonts->GetTexDataAsAlpha8(&pixels, &tex_w, &tex_h);
+
+        SetupStyle();
+    }
+
+    const GuiFrameStats* GetGuiFrameStats(void)
+    {
+        return &s_frame_stats;
+    }
+
+    // Draw data is built as usual but goes nowhere, the geometry can be
+    // counted to check for regressions in what a frame submits
+    static void ProcessHeadlessFrame(AppWindowData* win, FrontEndCB f_cb)
+    {
+        FeedInput(win);
+
+        ImGui::NewFrame();
+
+        if (f_cb) {
+            f_cb();
+        }
+
+        if (AppMustExit() == false) {
+            ImGui::Render();
+            ImDrawData* draw_data = ImGui::GetDrawData();
+
+            if (s_count_geometry) {
+                uint32_t cmd_count = 0;
+                for (int i = 0; i < draw_data->CmdListsCount; i++) {
+                    cmd_count += draw_data->CmdLists[i]->CmdBuffer.Size;
+                }
+                s_frame_stats.m_VtxCount = draw_data->TotalVtxCount;
+                s_frame_stats.m_IdxCount = draw_data->TotalIdxCount;
+                s_frame_stats.m_CmdCount = cmd_count;
+                s_frame_stats.m_VtxTotal += draw_data->TotalVtxCount;
+                s_frame_stats.m_IdxTotal += draw_data->TotalIdxCount;
+            }
+        }
+    }
+
+    static void ProcessVulkanFrame(AppWindowData* win, FrontEndCB f_cb)
+    {
+        ImGui_ImplVulkanH_Window* wd = &g_MainWindowData;
+        ImVec4 clear_color           = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
+
+        // Resize swap chain?
+        int width = win->m_ClientW, height = win->m_ClientH;
+        if (g_SwapChainRebuild) {
+            if (width > 0 && height > 0) {
+                ImGui_ImplVulkan_SetMinImageCount(g_MinImageCount);
+                ImGui_ImplVulkanH_CreateOrResizeWindow(g_Instance,
+                                                       g_PhysicalDevice,
+                                                       g_Device,
+                                                       &g_MainWindowData,
+                                                       g_QueueFamily,
+                                                       g_Allocator,
+                                                       width,
+                                                       height,
+                                                       g_MinImageCount);
+                g_MainWindowData.FrameIndex = 0;
+                g_SwapChainRebuild          = false;
+            }
+        }
+
+        // Start the Dear ImGui frame
+        ImGui_ImplVulkan_NewFrame();
+
+        FeedInput(win);
 
         ImGui::NewFrame();
 
@@ -618,6 +695,21 @@ extern "C"
         UNUSED_VAR(CleanupVulkanWindow);
     }
 
+    void ProcessGuiFrame(AppWindowData* win, FrontEndCB f_cb)
+    {
+        uint64_t cpu_start = GetThreadCpuTime();
+
+        if (s_headless) {
+            ProcessHeadlessFrame(win, f_cb);
+        } else {
+            ProcessVulkanFrame(win, f_cb);
+        }
+
+        s_frame_stats.m_Frames++;
+        s_frame_stats.m_CpuMs =
+          NanoToSec(GetThreadCpuTime() - cpu_start) * 1000.0;
+    }
+
     void ShutdownGui(AppWindowData* win, FrontEndCB f_cb)
     {
         UNUSED_VAR(win);
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <inttypes.h>
+#include <stdbool.h>
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -10,8 +13,25 @@ extern "C"
 
     typedef int (*FrontEndCB)(void);
 
+    typedef struct GuiFrameStats
+    {
+        uint64_t m_Frames;
+        double   m_CpuMs; // main thread cpu time of the last frame
+        uint64_t m_VtxTotal;
+        uint64_t m_IdxTotal;
+        uint32_t m_VtxCount; // last frame (counted only if asked for)
+        uint32_t m_IdxCount;
+        uint32_t m_CmdCount;
+    } GuiFrameStats;
+
     void SetupGuiContext(VkStateBin* vkstate, AppWindowData* win);
 
+    // Null renderer : no window system or gpu needed. Frames are built &
+    // rendered to draw data which is dropped (geometry optionally counted)
+    void SetupHeadlessGuiContext(AppWindowData* win, bool count_geometry);
+
+    const GuiFrameStats* GetGuiFrameStats(void);
+
     void ProcessGuiFrame(AppWindowData* win, FrontEndCB f_cb);
 
     void ShutdownGui(AppWindowData* win, FrontEndCB f_cb);
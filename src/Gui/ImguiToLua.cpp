@@ -3,13 +3,28 @@
 #include <inttypes.h>
 
 #include "LuaLayer.h"
+#include "ProcessIO.h"
 #include "UtilityMacros.h"
 #include "imgui.h"
+#include "imgui_internal.h" // ImGuiWindow::GetID(int)
 #include "lua.hpp"
 
-static char        s_text_buff[1024 * 4];
 static const char* s_str_ptrs[1024];
 
+#define TEXT_BUFFER_MT "ImGui.TextBuffer"
+
+// Growable text storage that imgui edits in place. The lua string for the
+// contents is cached in the userdata's user value until the next edit
+struct TextBuffer
+{
+    char*  m_Data;
+    size_t m_Capacity;
+    size_t m_Len;
+};
+
+// Scratch buffer for InputText calls made with plain lua strings
+static TextBuffer s_scratch_buff;
+
 /*
  * Reimplemented functions
  */
@@ -43,6 +58,12 @@ SetNxtWinSz(lua_State* L);
 
 // parameter stack
 
+static int
+PushID(lua_State* L);
+static int
+PopID(lua_State* L);
+static int
+GetID(lua_State* L);
 static int
 PushItemWidth(lua_State* L);
 static int
@@ -68,6 +89,8 @@ Dummy(lua_State* L);
 // scrolling
 static int
 SetScrollY(lua_State* L);
+static int
+SetKeyboardFocusHere(lua_State* L);
 
 // text widgets
 
@@ -116,6 +139,8 @@ static int
 TableNextRow(lua_State* L);
 static int
 TableSetColumnIndex(lua_State* L);
+static int
+DrawTable(lua_State* L);
 
 // Float functions
 
@@ -161,6 +186,8 @@ static int
 InputTextMulti(lua_State* L);
 static int
 InputTextHints(lua_State* L);
+static int
+NewTextBuffer(lua_State* L);
 
 // tree widget (use w/ Selectable())
 
@@ -271,16 +298,22 @@ static const struct luaL_Reg s_imgui_lib[] = {
     { "GetWindowHeight", GetWinHeight },
     { "SetNextWindowPos", SetNxtWinPos },
     { "SetNextWindowSize", SetNxtWinSz },
+    { "PushID", PushID },
+    { "PopID", PopID },
+    { "GetID", GetID },
     { "PushItemWidth", PushItemWidth },
     { "PopItemWidth", PopItemWidth },
     { "PushStyleColor", PushStyleColor },
     { "PopStyleColor", PopStyleColor },
     { "SetNextItemWidth", SetNxtItemWidth },
+    { "Vec2", LuaNewVec2 },
+    { "Vec4", LuaNewVec4 },
     { "Separator", Separator },
     { "SameLine", SameLine },
     { "NewLine", NewLine },
     { "Dummy", Dummy },
     { "SetScrollY", SetScrollY },
+    { "SetKeyboardFocusHere", SetKeyboardFocusHere },
     { "Text", TextRaw },
     { "TextWrapped", TextWrapped },
     { "TextColored", TextColored },
@@ -299,6 +332,7 @@ static const struct luaL_Reg s_imgui_lib[] = {
     { "EndTable", EndTable },
     { "TableNextRow", TableNextRow },
     { "TableSetColumnIndex", TableSetColumnIndex },
+    { "DrawTable", DrawTable },
     { "DragFloat", DFloat },
     { "DragFloat2", DFloat2 },
     { "DragFloat3", DFloat3 },
@@ -310,6 +344,7 @@ static const struct luaL_Reg s_imgui_lib[] = {
     { "InputText", InputText },
     { "InputTextMultiline", InputTextMulti },
     { "InputTextWithHint", InputTextHints },
+    { "TextBuffer", NewTextBuffer },
     { "TreeNode", TreeNode },
     { "TreePop", TreePop },
     { "ListBox", ListBox },
@@ -347,9 +382,40 @@ static const struct luaL_Reg s_imgui_lib[] = {
     { NULL, NULL }
 };
 
+static int
+TextBufferGet(lua_State* L);
+static int
+TextBufferSet(lua_State* L);
+static int
+TextBufferCapacity(lua_State* L);
+static int
+TextBufferClear(lua_State* L);
+static int
+TextBufferLen(lua_State* L);
+static int
+TextBufferGC(lua_State* L);
+
+static const struct luaL_Reg s_text_buffer_meta[] = {
+    { "get", TextBufferGet },
+    { "set", TextBufferSet },
+    { "capacity", TextBufferCapacity },
+    { "clear", TextBufferClear },
+    { "__len", TextBufferLen },
+    { "__tostring", TextBufferGet },
+    { "__gc", TextBufferGC },
+    { NULL, NULL }
+};
+
 int
 luaopen_ImguiLib(lua_State* L)
 {
+    // TextBuffer metatable (methods are looked up on the metatable itself)
+    luaL_newmetatable(L, TEXT_BUFFER_MT);
+    luaL_setfuncs(L, s_text_buffer_meta, 0);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
+
     lua_newtable(L);
     luaL_checkstack(L, 2, "too many arguments");
 
@@ -582,7 +648,7 @@ BeginChild(lua_State* L)
         curr_idx++;
 
         Vec4 sz = { 0 };
-        if (top > 1 && lua_istable(L, curr_idx)) {
+        if (top > 1 && IsVecArg(L, curr_idx)) {
             ReadFBufferFromLua(sz.raw, 4, curr_idx);
             curr_idx++;
         }
@@ -656,7 +722,7 @@ GetWinPos(lua_State* L)
 
     Vec4 v4 = (Vec4)ImGui::GetWindowPos();
 
-    PushFBufferToLua(v4.raw, 4);
+    PushFBufferToLuaOut(v4.raw, 2, 1);
 
     return 1;
 }
@@ -670,7 +736,7 @@ GetWinSz(lua_State* L)
 
     Vec4 v4 = (Vec4)ImGui::GetWindowSize();
 
-    PushFBufferToLua(v4.raw, 4);
+    PushFBufferToLuaOut(v4.raw, 2, 1);
 
     return 1;
 }
@@ -706,7 +772,7 @@ SetNxtWinPos(lua_State* L)
         int curr_idx = 1;
 
         Vec4 pos = { 0 };
-        if (lua_istable(L, curr_idx)) {
+        if (IsVecArg(L, curr_idx)) {
             ReadFBufferFromLua(pos.raw, 2, 1);
             curr_idx++;
         }
@@ -718,7 +784,7 @@ SetNxtWinPos(lua_State* L)
         }
 
         Vec4 pivot = { 0 };
-        if (top > 1 && lua_istable(L, curr_idx)) {
+        if (top > 1 && IsVecArg(L, curr_idx)) {
             ReadFBufferFromLua(pivot.raw, 4, curr_idx);
             curr_idx++;
         }
@@ -744,7 +810,7 @@ SetNxtWinSz(lua_State* L)
         int curr_idx = 1;
 
         Vec4 sz = { 0 };
-        if (lua_istable(L, curr_idx)) {
+        if (IsVecArg(L, curr_idx)) {
             ReadFBufferFromLua(sz.raw, 2, 1);
             curr_idx++;
         }
@@ -760,6 +826,102 @@ SetNxtWinSz(lua_State* L)
 
 //-----------------------------------------------------------------------------
 
+// PushID(int | string | table | userdata)
+static int
+PushID(lua_State* L)
+{
+    int top = lua_gettop(L);
+    if (top == 1) {
+        switch (lua_type(L, 1)) {
+            case LUA_TNUMBER:
+                ImGui::PushID((int)lua_tointeger(L, 1));
+                break;
+            case LUA_TSTRING: {
+                size_t      len = 0;
+                const char* str = lua_tolstring(L, 1, &len);
+                ImGui::PushID(str, str + len);
+                break;
+            }
+            default:
+                // tables, functions, userdata : identity of the object
+                ImGui::PushID(lua_topointer(L, 1));
+                break;
+        }
+    } else {
+        assert(false && "Invalid arguments");
+    }
+    return 0;
+}
+
+static int
+PopID(lua_State* L)
+{
+    UNUSED_VAR(L);
+
+    ImGui::PopID();
+
+    return 0;
+}
+
+static int
+GetID(lua_State* L)
+{
+    ImGuiID id = 0;
+
+    switch (lua_type(L, 1)) {
+        case LUA_TNUMBER:
+            // hashed as the int PushID & the integer id widgets push
+            id = ImGui::GetCurrentWindow()->GetID((int)lua_tointeger(L, 1));
+            break;
+        case LUA_TSTRING: {
+            size_t      len = 0;
+            const char* str = lua_tolstring(L, 1, &len);
+            id              = ImGui::GetID(str, str + len);
+            break;
+        }
+        default:
+            id = ImGui::GetID(lua_topointer(L, 1));
+            break;
+    }
+    lua_pushinteger(L, (lua_Integer)id);
+
+    return 1;
+}
+
+// Widgets take either a label or an integer id followed by the (optional)
+// display text. The integer is pushed on imgui's id stack so lua never has to
+// build "##name"..i labels; pair with PopWidgetID
+static const char*
+GetWidgetLabel(lua_State* L, int* curr_idx, bool has_text)
+{
+    if (lua_type(L, *curr_idx) == LUA_TNUMBER) {
+        ImGui::PushID((int)lua_tointeger(L, *curr_idx));
+        (*curr_idx)++;
+
+        if (has_text && lua_type(L, *curr_idx) == LUA_TSTRING) {
+            const char* text = lua_tolstring(L, *curr_idx, nullptr);
+            (*curr_idx)++;
+            return text;
+        }
+        return "##";
+    }
+
+    const char* label = luaL_checklstring(L, *curr_idx, nullptr);
+    (*curr_idx)++;
+
+    return label;
+}
+
+static void
+PopWidgetID(lua_State* L)
+{
+    if (lua_type(L, 1) == LUA_TNUMBER) {
+        ImGui::PopID();
+    }
+}
+
+//-----------------------------------------------------------------------------
+
 static int
 PushItemWidth(lua_State* L)
 {
@@ -913,6 +1075,16 @@ SetScrollY(lua_State* L)
     return 0;
 }
 
+static int
+SetKeyboardFocusHere(lua_State* L)
+{
+    int offset = (int)luaL_optinteger(L, 1, 0);
+
+    ImGui::SetKeyboardFocusHere(offset);
+
+    return 0;
+}
+
 //-----------------------------------------------------------------------------
 
 static int
@@ -982,15 +1154,17 @@ Button(lua_State* L)
 {
     int top = lua_gettop(L);
     if (top >= 1) {
-        const char* label = luaL_checklstring(L, 1, nullptr);
+        int         curr_idx = 1;
+        const char* label    = GetWidgetLabel(L, &curr_idx, true);
 
         Vec4 sz = { 0 };
-        if (top > 1) {
-            ReadFBufferFromLua(sz.raw, 2, 1);
+        if (top >= curr_idx) {
+            ReadFBufferFromLua(sz.raw, 2, curr_idx);
         }
 
         ImVec2 val(sz);
         lua_pushboolean(L, ImGui::Button(label, val));
+        PopWidgetID(L);
     } else {
         assert(false && "Invalid arguments");
     }
@@ -1003,10 +1177,12 @@ static int
 SmallButton(lua_State* L)
 {
     int top = lua_gettop(L);
-    if (top == 1) {
-        const char* label = luaL_checklstring(L, 1, nullptr);
+    if (top >= 1) {
+        int         curr_idx = 1;
+        const char* label    = GetWidgetLabel(L, &curr_idx, true);
 
         lua_pushboolean(L, ImGui::SmallButton(label));
+        PopWidgetID(L);
     } else {
         assert(false && "Invalid arguments");
     }
@@ -1085,20 +1261,22 @@ CheckBox(lua_State* L)
 {
     int top = lua_gettop(L);
     if (top >= 2) {
-        const char* label = luaL_checklstring(L, 1, nullptr);
+        int         curr_idx = 1;
+        const char* label    = GetWidgetLabel(L, &curr_idx, false);
 
-        if (lua_isboolean(L, 2)) {
-            bool val = (bool)lua_toboolean(L, 2);
+        if (lua_isboolean(L, curr_idx)) {
+            bool val = (bool)lua_toboolean(L, curr_idx);
 
             lua_pushboolean(L, ImGui::Checkbox(label, &val));
             lua_pushboolean(L, val);
         } else {
-            uint32_t bitflag  = (uint32_t)luaL_checkinteger(L, 2);
-            int      flag_val = (int)luaL_checkinteger(L, 3);
+            uint32_t bitflag  = (uint32_t)luaL_checkinteger(L, curr_idx);
+            int      flag_val = (int)luaL_checkinteger(L, curr_idx + 1);
 
             lua_pushboolean(L, ImGui::CheckboxFlags(label, &bitflag, flag_val));
             lua_pushinteger(L, bitflag);
         }
+        PopWidgetID(L);
     } else {
         assert(false && "Invalid arguments");
     }
@@ -1117,7 +1295,7 @@ ProgressBar(lua_State* L)
         curr_idx++;
 
         Vec4 sz = { -1.f, 0, 0, 0 };
-        if (top > 1 && lua_istable(L, curr_idx)) {
+        if (top > 1 && IsVecArg(L, curr_idx)) {
             ReadFBufferFromLua(sz.raw, 4, curr_idx);
             curr_idx++;
         }
@@ -1187,11 +1365,10 @@ Selectable(lua_State* L)
     int top = lua_gettop(L);
     if (top >= 1) {
         int                  curr_idx = 1;
-        const char*          label    = luaL_checklstring(L, curr_idx, nullptr);
+        const char*          label    = GetWidgetLabel(L, &curr_idx, true);
         bool                 selected = false;
         ImGuiSelectableFlags flags    = 0;
         Vec4                 sz       = { 0 };
-        curr_idx++;
 
         if (top > 1 && lua_isboolean(L, curr_idx)) {
             selected = lua_toboolean(L, curr_idx);
@@ -1203,13 +1380,14 @@ Selectable(lua_State* L)
             curr_idx++;
         }
 
-        if (top > 1 && lua_istable(L, curr_idx)) {
-            ReadFBufferFromLua(sz.raw, 2, 1);
+        if (top > 1 && IsVecArg(L, curr_idx)) {
+            ReadFBufferFromLua(sz.raw, 2, curr_idx);
             curr_idx++;
         }
 
         ImVec2 val(sz);
         lua_pushboolean(L, ImGui::Selectable(label, selected, flags, val));
+        PopWidgetID(L);
     } else {
         assert(false && "Invalid arguments");
     }
@@ -1292,6 +1470,282 @@ TableSetColumnIndex(lua_State* L)
 
 //-----------------------------------------------------------------------------
 
+#define MAX_TABLE_COLUMNS 64
+
+struct TableColumn
+{
+    const char* m_Name;
+    int         m_KeyIdx; // stack slot of the row field name (0 : use index)
+    bool        m_Input;
+    bool        m_HasColor;
+    float       m_Width;
+    ImVec4      m_Color;
+};
+
+static TableColumn s_tbl_columns[MAX_TABLE_COLUMNS];
+
+static bool
+GetTableOption(lua_State* L, int opts_idx, const char* field, int l_type)
+{
+    if (opts_idx == 0) {
+        return false;
+    }
+    if (lua_getfield(L, opts_idx, field) == l_type) {
+        return true;
+    }
+    lua_pop(L, 1);
+    return false;
+}
+
+// Same as GetTableOption for a table or a Vec2/Vec4
+static bool
+GetVecOption(lua_State* L, int opts_idx, const char* field)
+{
+    if (opts_idx == 0) {
+        return false;
+    }
+    lua_getfield(L, opts_idx, field);
+    if (IsVecArg(L, -1)) {
+        return true;
+    }
+    lua_pop(L, 1);
+    return false;
+}
+
+static const char*
+GetTableCell(lua_State* L, int row_idx, int column, size_t* len)
+{
+    const TableColumn& clmn = s_tbl_columns[column];
+    if (clmn.m_KeyIdx) {
+        lua_pushvalue(L, clmn.m_KeyIdx);
+        lua_rawget(L, row_idx);
+    } else {
+        lua_rawgeti(L, row_idx, column + 1);
+    }
+
+    // numbers are converted on the stack copy, the row itself is untouched
+    int l_type = lua_type(L, -1);
+    if (l_type == LUA_TSTRING || l_type == LUA_TNUMBER) {
+        return lua_tolstring(L, -1, len);
+    }
+    *len = 0;
+    return nullptr;
+}
+
+// DrawTable(id, columns, rows [, opts]) -> { clicked row, ... } | nil
+//  columns : { "name" | { name, key = "field", input = bool, color = {},
+//              width = px }, ... }
+//  rows    : { { cell, ... } | { field = cell, ... }, ... }
+//  opts    : { size = {w, h}, flags = int, selectable = bool, selected = row,
+//              header = bool }
+// Only the rows inside the clipping rect are read from lua
+static int
+DrawTable(lua_State* L)
+{
+    int top = lua_gettop(L);
+    if (top >= 3) {
+        int         curr_idx = 1;
+        const char* label    = luaL_checklstring(L, curr_idx, nullptr);
+        curr_idx++;
+
+        luaL_checktype(L, curr_idx, LUA_TTABLE);
+        int clmns_idx = curr_idx;
+        curr_idx++;
+
+        luaL_checktype(L, curr_idx, LUA_TTABLE);
+        int rows_idx = curr_idx;
+        curr_idx++;
+
+        int opts_idx = 0;
+        if (top > 3 && lua_istable(L, curr_idx)) {
+            opts_idx = curr_idx;
+            curr_idx++;
+        }
+        lua_settop(L, curr_idx - 1);
+
+        Vec4            sz         = { 0 };
+        int             selected   = 0;
+        bool            selectable = false;
+        bool            header     = true;
+        ImGuiTableFlags flags      = ImGuiTableFlags_ColumnsWidthFixed |
+                                ImGuiTableFlags_ScrollX |
+                                ImGuiTableFlags_ScrollY |
+                                ImGuiTableFlags_Borders;
+
+        if (GetVecOption(L, opts_idx, "size")) {
+            ReadFBufferFromLua(sz.raw, 2, lua_gettop(L));
+            lua_pop(L, 1);
+        }
+        if (GetTableOption(L, opts_idx, "flags", LUA_TNUMBER)) {
+            flags = (ImGuiTableFlags)lua_tointeger(L, -1);
+            lua_pop(L, 1);
+        }
+        if (GetTableOption(L, opts_idx, "selected", LUA_TNUMBER)) {
+            selected = (int)lua_tointeger(L, -1);
+            lua_pop(L, 1);
+        }
+        if (GetTableOption(L, opts_idx, "selectable", LUA_TBOOLEAN)) {
+            selectable = lua_toboolean(L, -1);
+            lua_pop(L, 1);
+        }
+        if (GetTableOption(L, opts_idx, "header", LUA_TBOOLEAN)) {
+            header = lua_toboolean(L, -1);
+            lua_pop(L, 1);
+        }
+
+        // column descriptions (field names stay on the stack for lookups)
+        int clmn_cnt = (int)lua_rawlen(L, clmns_idx);
+        clmn_cnt     = MIN(clmn_cnt, MAX_TABLE_COLUMNS);
+        luaL_checkstack(L, clmn_cnt * 2 + 8, "too many table columns");
+
+        for (int i = 0; i < clmn_cnt; i++) {
+            TableColumn& clmn = s_tbl_columns[i];
+            clmn              = {};
+            clmn.m_Name       = "";
+
+            int l_type = lua_rawgeti(L, clmns_idx, i + 1);
+            if (l_type == LUA_TSTRING) {
+                clmn.m_Name = lua_tolstring(L, -1, nullptr);
+            } else if (l_type == LUA_TTABLE) {
+                int clmn_idx = lua_gettop(L);
+
+                if (lua_rawgeti(L, clmn_idx, 1) == LUA_TSTRING) {
+                    clmn.m_Name = lua_tolstring(L, -1, nullptr);
+                }
+                if (lua_getfield(L, clmn_idx, "name") == LUA_TSTRING) {
+                    clmn.m_Name = lua_tolstring(L, -1, nullptr);
+                }
+                if (lua_getfield(L, clmn_idx, "input") != LUA_TNIL) {
+                    clmn.m_Input = lua_toboolean(L, -1);
+                }
+                if (lua_getfield(L, clmn_idx, "width") == LUA_TNUMBER) {
+                    clmn.m_Width = (float)lua_tonumber(L, -1);
+                }
+                lua_getfield(L, clmn_idx, "color");
+                if (IsVecArg(L, -1)) {
+                    Vec4 col = { 0 };
+                    ReadFBufferFromLua(col.raw, 4, lua_gettop(L));
+                    clmn.m_Color    = ImVec4(col);
+                    clmn.m_HasColor = true;
+                }
+                lua_pop(L, 4);
+
+                if (lua_getfield(L, clmn_idx, "key") == LUA_TSTRING) {
+                    clmn.m_KeyIdx = lua_gettop(L);
+                } else {
+                    lua_pop(L, 1);
+                }
+            } else {
+                lua_pop(L, 1);
+            }
+        }
+
+        if (clmn_cnt == 0 || !ImGui::BeginTable(label, clmn_cnt, flags, sz)) {
+            lua_pushnil(L);
+            return 1;
+        }
+
+        for (int i = 0; i < clmn_cnt; i++) {
+            const TableColumn& clmn = s_tbl_columns[i];
+            ImGui::TableSetupColumn(clmn.m_Name,
+                                    clmn.m_Width > 0.f
+                                      ? ImGuiTableColumnFlags_WidthFixed
+                                      : ImGuiTableColumnFlags_None,
+                                    clmn.m_Width);
+        }
+        if (header) {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableHeadersRow();
+        }
+
+        // clicked rows are rare so the result table is created on demand
+        lua_pushnil(L);
+        int clicked_idx = lua_gettop(L);
+        int clicked_cnt = 0;
+
+        const ImU32 select_col = ImGui::GetColorU32(ImGuiCol_Header);
+
+        int              row_cnt = (int)lua_rawlen(L, rows_idx);
+        ImGuiListClipper clipper;
+        clipper.Begin(row_cnt);
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd;
+                 row++) {
+                ImGui::TableNextRow();
+
+                int l_type = lua_rawgeti(L, rows_idx, row + 1);
+                if (l_type != LUA_TTABLE) {
+                    lua_pop(L, 1);
+                    continue;
+                }
+                int row_idx = lua_gettop(L);
+
+                ImGui::PushID(row);
+
+                if (selectable) {
+                    ImGui::TableSetColumnIndex(0);
+                    if (ImGui::Selectable("##row",
+                                          row + 1 == selected,
+                                          ImGuiSelectableFlags_SpanAllColumns |
+                                            ImGuiSelectableFlags_AllowItemOverlap)) {
+                        if (clicked_cnt == 0) {
+                            lua_createtable(L, 1, 0);
+                            lua_replace(L, clicked_idx);
+                        }
+                        clicked_cnt++;
+                        lua_pushinteger(L, row + 1);
+                        lua_rawseti(L, clicked_idx, clicked_cnt);
+                    }
+                    ImGui::SameLine();
+                } else if (row + 1 == selected) {
+                    ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg1,
+                                           select_col);
+                }
+
+                for (int i = 0; i < clmn_cnt; i++) {
+                    size_t      len  = 0;
+                    const char* cell = GetTableCell(L, row_idx, i, &len);
+                    if (cell && ImGui::TableSetColumnIndex(i)) {
+                        const TableColumn& clmn = s_tbl_columns[i];
+                        if (clmn.m_Input) {
+                            // read only so imgui never writes to the lua string
+                            ImGui::PushID(i);
+                            ImGui::PushItemWidth(-1);
+                            ImGui::InputText("##cell",
+                                             (char*)cell,
+                                             len + 1,
+                                             ImGuiInputTextFlags_ReadOnly);
+                            ImGui::PopItemWidth();
+                            ImGui::PopID();
+                        } else if (clmn.m_HasColor) {
+                            ImGui::PushStyleColor(ImGuiCol_Text, clmn.m_Color);
+                            ImGui::TextUnformatted(cell, cell + len);
+                            ImGui::PopStyleColor();
+                        } else {
+                            ImGui::TextUnformatted(cell, cell + len);
+                        }
+                    }
+                    lua_pop(L, 1);
+                }
+
+                ImGui::PopID();
+                lua_pop(L, 1);
+            }
+        }
+        clipper.End();
+
+        ImGui::EndTable();
+
+        lua_pushvalue(L, clicked_idx);
+    } else {
+        assert(false && "Invalid arguments");
+        lua_pushnil(L);
+    }
+    return 1;
+}
+
+//-----------------------------------------------------------------------------
+
 static int
 DFloat(lua_State* L)
 {
@@ -1327,7 +1781,7 @@ DFloat2(lua_State* L)
                                       input.m_Max,
                                       input.m_Fmt,
                                       input.m_Power));
-    PushFBufferToLua(input.m_Vf.raw, 4);
+    PushFBufferToLuaOut(input.m_Vf.raw, 4, 2);
 
     return 2;
 }
@@ -1348,7 +1802,7 @@ DFloat3(lua_State* L)
                                       input.m_Max,
                                       input.m_Fmt,
                                       input.m_Power));
-    PushFBufferToLua(input.m_Vf.raw, 4);
+    PushFBufferToLuaOut(input.m_Vf.raw, 4, 2);
 
     return 2;
 }
@@ -1369,7 +1823,7 @@ DFloat4(lua_State* L)
                                       input.m_Max,
                                       input.m_Fmt,
                                       input.m_Power));
-    PushFBufferToLua(input.m_Vf.raw, 4);
+    PushFBufferToLuaOut(input.m_Vf.raw, 4, 2);
 
     return 2;
 }
@@ -1409,7 +1863,7 @@ SFloat2(lua_State* L)
                                         input.m_Max,
                                         input.m_Fmt,
                                         input.m_Power));
-    PushFBufferToLua(input.m_Vf.raw, 4);
+    PushFBufferToLuaOut(input.m_Vf.raw, 4, 2);
 
     return 2;
 }
@@ -1429,7 +1883,7 @@ SFloat3(lua_State* L)
                                         input.m_Max,
                                         input.m_Fmt,
                                         input.m_Power));
-    PushFBufferToLua(input.m_Vf.raw, 4);
+    PushFBufferToLuaOut(input.m_Vf.raw, 4, 2);
 
     return 2;
 }
@@ -1449,24 +1903,94 @@ SFloat4(lua_State* L)
                                         input.m_Max,
                                         input.m_Fmt,
                                         input.m_Power));
-    PushFBufferToLua(input.m_Vf.raw, 4);
+    PushFBufferToLuaOut(input.m_Vf.raw, 4, 2);
 
     return 2;
 }
 
 //-----------------------------------------------------------------------------
 
+static void
+GrowTextBuffer(TextBuffer* buff, size_t sz)
+{
+    if (sz <= buff->m_Capacity) {
+        return;
+    }
+    size_t new_cap  = ROUNDUP(MAX(sz, buff->m_Capacity * 2), (size_t)64);
+    buff->m_Data     = (char*)WmRealloc(buff->m_Data, new_cap);
+    buff->m_Capacity = new_cap;
+}
+
+static void
+AssignTextBuffer(TextBuffer* buff, const char* str, size_t len)
+{
+    GrowTextBuffer(buff, len + 1);
+    memcpy(buff->m_Data, str, len);
+    buff->m_Data[len] = '\0';
+    buff->m_Len       = len;
+}
+
+static int
+TextBufferResize(ImGuiInputTextCallbackData* data)
+{
+    if (data->EventFlag == ImGuiInputTextFlags_CallbackResize) {
+        TextBuffer* buff = (TextBuffer*)data->UserData;
+        GrowTextBuffer(buff, (size_t)data->BufTextLen + 1);
+        data->Buf     = buff->m_Data;
+        data->BufSize = (int)buff->m_Capacity;
+    }
+    return 0;
+}
+
+// Accepts either a TextBuffer (edited in place) or a lua string (copied to
+// the scratch buffer)
+static TextBuffer*
+GetTextInput(lua_State* L, int index)
+{
+    TextBuffer* buff = (TextBuffer*)luaL_testudata(L, index, TEXT_BUFFER_MT);
+    if (buff) {
+        GrowTextBuffer(buff, 1);
+        return buff;
+    }
+
+    size_t      len       = 0;
+    const char* input_txt = luaL_checklstring(L, index, &len);
+    AssignTextBuffer(&s_scratch_buff, input_txt, len);
+
+    return &s_scratch_buff;
+}
+
+// Pushes the widget's text value : the argument itself unless the user edited
+// it, so untouched fields never create a new lua string
+static void
+PushTextInput(lua_State* L, int index, TextBuffer* buff)
+{
+    if (ImGui::IsItemEdited()) {
+        buff->m_Len = strlen(buff->m_Data);
+
+        if (buff == &s_scratch_buff) {
+            lua_pushlstring(L, buff->m_Data, buff->m_Len);
+            return;
+        }
+
+        lua_pushnil(L);
+        lua_setiuservalue(L, index, 1);
+    }
+    lua_pushvalue(L, index);
+}
+
+//-----------------------------------------------------------------------------
+
 static int
 InputText(lua_State* L)
 {
     int top = lua_gettop(L);
     if (top >= 2) {
         int         curr_idx = 1;
-        const char* label    = luaL_checklstring(L, curr_idx, nullptr);
-        curr_idx++;
-        const char* input_txt = luaL_checklstring(L, curr_idx, nullptr);
+        const char* label    = GetWidgetLabel(L, &curr_idx, false);
+        int         txt_idx  = curr_idx;
+        TextBuffer* buff    = GetTextInput(L, curr_idx);
         curr_idx++;
-        snprintf(s_text_buff, sizeof(s_text_buff), "%s", input_txt);
 
         ImGuiInputTextFlags flags = 0;
         Vec4                sz    = { 0 };
@@ -1476,15 +2000,22 @@ InputText(lua_State* L)
             curr_idx++;
         }
 
-        if (top > 2 && lua_istable(L, curr_idx)) {
+        if (top > 2 && IsVecArg(L, curr_idx)) {
             ReadFBufferFromLua(sz.raw, 4, curr_idx);
             curr_idx++;
         }
 
         ImVec2 val(sz.x, sz.y);
         lua_pushboolean(
-          L, ImGui::InputText(label, s_text_buff, sizeof(s_text_buff), flags));
-        lua_pushstring(L, s_text_buff);
+          L,
+          ImGui::InputText(label,
+                           buff->m_Data,
+                           buff->m_Capacity,
+                           flags | ImGuiInputTextFlags_CallbackResize,
+                           TextBufferResize,
+                           buff));
+        PushTextInput(L, txt_idx, buff);
+        PopWidgetID(L);
     } else {
         assert(false && "Invalid arguments");
     }
@@ -1499,11 +2030,10 @@ InputTextMulti(lua_State* L)
     int top = lua_gettop(L);
     if (top >= 2) {
         int         curr_idx = 1;
-        const char* label    = luaL_checklstring(L, curr_idx, nullptr);
+        const char* label    = GetWidgetLabel(L, &curr_idx, false);
+        int         txt_idx  = curr_idx;
+        TextBuffer* buff    = GetTextInput(L, curr_idx);
         curr_idx++;
-        const char* input_txt = luaL_checklstring(L, curr_idx, nullptr);
-        curr_idx++;
-        snprintf(s_text_buff, sizeof(s_text_buff), "%s", input_txt);
 
         ImGuiInputTextFlags flags = 0;
         Vec4                sz    = { 0 };
@@ -1513,7 +2043,7 @@ InputTextMulti(lua_State* L)
             curr_idx++;
         }
 
-        if (top > 2 && lua_istable(L, curr_idx)) {
+        if (top > 2 && IsVecArg(L, curr_idx)) {
             ReadFBufferFromLua(sz.raw, 4, curr_idx);
             curr_idx++;
         }
@@ -1521,8 +2051,15 @@ InputTextMulti(lua_State* L)
         ImVec2 val(sz.x, sz.y);
         lua_pushboolean(L,
                         ImGui::InputTextMultiline(
-                          label, s_text_buff, sizeof(s_text_buff), val, flags));
-        lua_pushstring(L, s_text_buff);
+                          label,
+                          buff->m_Data,
+                          buff->m_Capacity,
+                          val,
+                          flags | ImGuiInputTextFlags_CallbackResize,
+                          TextBufferResize,
+                          buff));
+        PushTextInput(L, txt_idx, buff);
+        PopWidgetID(L);
     } else {
         assert(false && "Invalid arguments");
     }
@@ -1537,13 +2074,12 @@ InputTextHints(lua_State* L)
     int top = lua_gettop(L);
     if (top >= 2) {
         int         curr_idx = 1;
-        const char* label    = luaL_checklstring(L, curr_idx, nullptr);
+        const char* label    = GetWidgetLabel(L, &curr_idx, false);
+        const char* hint     = luaL_checklstring(L, curr_idx, nullptr);
         curr_idx++;
-        const char* hint = luaL_checklstring(L, curr_idx, nullptr);
+        int         txt_idx = curr_idx;
+        TextBuffer* buff    = GetTextInput(L, curr_idx);
         curr_idx++;
-        const char* input_txt = luaL_checklstring(L, curr_idx, nullptr);
-        curr_idx++;
-        snprintf(s_text_buff, sizeof(s_text_buff), "%s", input_txt);
 
         ImGuiInputTextFlags flags = 0;
         Vec4                sz    = { 0 };
@@ -1553,7 +2089,7 @@ InputTextHints(lua_State* L)
             curr_idx++;
         }
 
-        if (top > 2 && lua_istable(L, curr_idx)) {
+        if (top > 2 && IsVecArg(L, curr_idx)) {
             ReadFBufferFromLua(sz.raw, 4, curr_idx);
             curr_idx++;
         }
@@ -1561,9 +2097,15 @@ InputTextHints(lua_State* L)
         ImVec2 val(sz.x, sz.y);
         lua_pushboolean(
           L,
-          ImGui::InputTextWithHint(
-            label, hint, s_text_buff, sizeof(s_text_buff), flags));
-        lua_pushstring(L, s_text_buff);
+          ImGui::InputTextWithHint(label,
+                                   hint,
+                                   buff->m_Data,
+                                   buff->m_Capacity,
+                                   flags | ImGuiInputTextFlags_CallbackResize,
+                                   TextBufferResize,
+                                   buff));
+        PushTextInput(L, txt_idx, buff);
+        PopWidgetID(L);
     } else {
         assert(false && "Invalid arguments");
     }
@@ -1572,6 +2114,111 @@ InputTextHints(lua_State* L)
 
 //-----------------------------------------------------------------------------
 
+// TextBuffer([str], [capacity]) | TextBuffer(capacity)
+static int
+NewTextBuffer(lua_State* L)
+{
+    int         top      = lua_gettop(L);
+    int         curr_idx = 1;
+    const char* init_txt = "";
+    size_t      init_len = 0;
+    size_t      capacity = 256;
+
+    if (top >= curr_idx && lua_type(L, curr_idx) == LUA_TSTRING) {
+        init_txt = lua_tolstring(L, curr_idx, &init_len);
+        curr_idx++;
+    }
+
+    if (top >= curr_idx && lua_isinteger(L, curr_idx)) {
+        capacity = (size_t)MAX(lua_tointeger(L, curr_idx), 1);
+        curr_idx++;
+    }
+
+    TextBuffer* buff = (TextBuffer*)lua_newuserdatauv(L, sizeof(TextBuffer), 1);
+    *buff            = {};
+    luaL_setmetatable(L, TEXT_BUFFER_MT);
+
+    GrowTextBuffer(buff, MAX(capacity, init_len + 1));
+    AssignTextBuffer(buff, init_txt, init_len);
+
+    return 1;
+}
+
+static int
+TextBufferGet(lua_State* L)
+{
+    TextBuffer* buff = (TextBuffer*)luaL_checkudata(L, 1, TEXT_BUFFER_MT);
+
+    if (lua_getiuservalue(L, 1, 1) != LUA_TSTRING) {
+        lua_pop(L, 1);
+        lua_pushlstring(L, buff->m_Data ? buff->m_Data : "", buff->m_Len);
+        lua_pushvalue(L, -1);
+        lua_setiuservalue(L, 1, 1);
+    }
+    return 1;
+}
+
+static int
+TextBufferSet(lua_State* L)
+{
+    TextBuffer* buff = (TextBuffer*)luaL_checkudata(L, 1, TEXT_BUFFER_MT);
+    size_t      len  = 0;
+    const char* str  = luaL_checklstring(L, 2, &len);
+
+    AssignTextBuffer(buff, str, len);
+
+    lua_pushvalue(L, 2);
+    lua_setiuservalue(L, 1, 1);
+
+    return 0;
+}
+
+static int
+TextBufferCapacity(lua_State* L)
+{
+    TextBuffer* buff = (TextBuffer*)luaL_checkudata(L, 1, TEXT_BUFFER_MT);
+
+    lua_pushinteger(L, (lua_Integer)buff->m_Capacity);
+
+    return 1;
+}
+
+static int
+TextBufferClear(lua_State* L)
+{
+    TextBuffer* buff = (TextBuffer*)luaL_checkudata(L, 1, TEXT_BUFFER_MT);
+
+    AssignTextBuffer(buff, "", 0);
+
+    lua_pushnil(L);
+    lua_setiuservalue(L, 1, 1);
+
+    return 0;
+}
+
+static int
+TextBufferLen(lua_State* L)
+{
+    TextBuffer* buff = (TextBuffer*)luaL_checkudata(L, 1, TEXT_BUFFER_MT);
+
+    lua_pushinteger(L, (lua_Integer)buff->m_Len);
+
+    return 1;
+}
+
+static int
+TextBufferGC(lua_State* L)
+{
+    TextBuffer* buff = (TextBuffer*)luaL_checkudata(L, 1, TEXT_BUFFER_MT);
+
+    WmFree(buff->m_Data);
+    *buff = {};
+
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+
 static int
 TreeNode(lua_State* L)
 {
@@ -2055,7 +2702,7 @@ GetItemRectMin(lua_State* L)
     UNUSED_VAR(L);
 
     Vec4 v4 = (Vec4)ImGui::GetItemRectMin();
-    PushFBufferToLua(v4.raw, 4);
+    PushFBufferToLuaOut(v4.raw, 2, 1);
 
     return 1;
 }
@@ -2068,7 +2715,7 @@ GetItemRectMax(lua_State* L)
     UNUSED_VAR(L);
 
     Vec4 v4 = (Vec4)ImGui::GetItemRectMax();
-    PushFBufferToLua(v4.raw, 4);
+    PushFBufferToLuaOut(v4.raw, 2, 1);
 
     return 1;
 }
@@ -2081,7 +2728,7 @@ GetItemRectSize(lua_State* L)
     UNUSED_VAR(L);
 
     Vec4 v4 = (Vec4)ImGui::GetItemRectSize();
-    PushFBufferToLua(v4.raw, 4);
+    PushFBufferToLuaOut(v4.raw, 2, 1);
 
     return 1;
 }
@@ -0,0 +1,414 @@
+#include "Gui/LuaProfiler.h"
+#include "LuaLayer.h"
+#include "ProcessIO.h"
+#include "imgui.h"
+#include "lua.hpp"
+#include <algorithm>
+#include <atomic>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+// Sampling profiler for the lua program layer. A timer thread signals the ui
+// thread every m_Period microseconds while a frame is running, and the signal
+// handler arms a one-shot count hook (lua_sethook is safe to call from a
+// signal). The hook records where lua is & removes itself, so lua runs at
+// full speed between samples. Each sample is weighted by the time since the
+// previous one, time spent in C functions goes to the lua line that called
+// them. When stopped no hook is installed & the timer thread is gone.
+
+#define DEFAULT_SAMPLE_PERIOD 1000 // microseconds
+#define FRAMES_PER_REPORT 60
+#define MAX_STACK_DEPTH 64
+#define MAX_REPORT_ROWS 32
+
+struct ProfStat
+{
+    std::string m_Func;
+    uint64_t    m_TimeNs;
+    uint32_t    m_Samples;
+};
+
+struct ProfRow
+{
+    std::string m_Location;
+    std::string m_Func;
+    double      m_MsPerFrame;
+    double      m_Percent;
+};
+
+struct LuaProfiler
+{
+    bool     m_Running;
+    bool     m_ShowOverlay;
+    int32_t  m_Period;
+    uint64_t m_LastSample;
+
+    std::thread       m_Timer;
+    std::atomic<bool> m_TimerRun;
+    std::atomic<bool> m_InFrame;
+    pthread_t         m_UiThread;
+    struct sigaction  m_OldAction;
+    volatile bool     m_InHook;
+
+    uint32_t m_Frames;
+    uint64_t m_FramesTimeNs; // lua time covered by the samples in the window
+
+    std::unordered_map<std::string, ProfStat> m_Lines;   // current window
+    std::unordered_map<std::string, uint64_t> m_Stacks;  // since Start/Reset
+    std::vector<ProfRow>                      m_Report;  // last full window
+    double                                    m_ReportMs;
+    std::string                               m_Key;
+};
+
+static LuaProfiler s_prof;
+
+//------------------------------------------------------------------------------
+
+static void
+AppendFrameName(std::string& dst, lua_Debug& ar)
+{
+    if (ar.name) {
+        dst += ar.name;
+    } else if (*ar.what == 'm') {
+        dst += "main chunk";
+    } else {
+        dst += "?";
+    }
+
+    if (*ar.what != 'C') {
+        char loc[LUA_IDSIZE + 16];
+        snprintf(loc, sizeof(loc), "@%s:%d", ar.short_src, ar.linedefined);
+        dst += loc;
+    }
+}
+
+static void
+ProfilerHook(lua_State* L, lua_Debug* hook_ar)
+{
+    // one shot (coroutines created while armed inherit it, same thing)
+    lua_sethook(L, NULL, 0, 0);
+    if (s_prof.m_Running == false) {
+        return;
+    }
+
+    uint64_t now        = GetHighResTime();
+    uint64_t dt         = now - s_prof.m_LastSample;
+    s_prof.m_LastSample = now;
+
+    lua_Debug ar;
+    if (lua_getstack(L, 0, &ar) == 0) {
+        return;
+    }
+    // set only past the early returns, SampleSignal doesn't arm the hook
+    // again until it's cleared
+    s_prof.m_InHook = true;
+    lua_getinfo(L, "Sln", &ar);
+
+    char leaf[LUA_IDSIZE + 16];
+    snprintf(leaf, sizeof(leaf), "%s:%d", ar.short_src, ar.currentline);
+
+    ProfStat& line = s_prof.m_Lines[leaf];
+    if (line.m_Samples == 0) {
+        AppendFrameName(line.m_Func, ar);
+    }
+    line.m_Samples++;
+    line.m_TimeNs += dt;
+    s_prof.m_FramesTimeNs += dt;
+
+    // collapsed stack, root first : "f0;f1;...;leaf"
+    lua_Debug frames[MAX_STACK_DEPTH];
+    int32_t   depth = 0;
+    while (depth < MAX_STACK_DEPTH && lua_getstack(L, depth, &frames[depth])) {
+        lua_getinfo(L, "Sn", &frames[depth]);
+        depth++;
+    }
+
+    std::string& key = s_prof.m_Key;
+    key.clear();
+    for (int32_t i = depth - 1; i >= 0; i--) {
+        AppendFrameName(key, frames[i]);
+        key += ';';
+    }
+    key += leaf;
+
+    s_prof.m_Stacks[key] += dt / 1000;
+    s_prof.m_InHook = false;
+    (void)hook_ar;
+}
+
+static void
+SampleSignal(int signum)
+{
+    if (s_prof.m_InHook == false) {
+        lua_sethook(GetLuaState(), ProfilerHook, LUA_MASKCOUNT, 1);
+    }
+    (void)signum;
+}
+
+static void
+SampleTimer(void)
+{
+    while (s_prof.m_TimerRun) {
+        usleep(s_prof.m_Period);
+        if (s_prof.m_InFrame) {
+            pthread_kill(s_prof.m_UiThread, SIGPROF);
+        }
+    }
+}
+
+static void
+PublishReport(void)
+{
+    double frames = s_prof.m_Frames ? s_prof.m_Frames : 1;
+    double total  = s_prof.m_FramesTimeNs ? s_prof.m_FramesTimeNs : 1;
+
+    s_prof.m_Report.clear();
+    for (auto& line : s_prof.m_Lines) {
+        ProfRow row = { line.first,
+                        line.second.m_Func,
+                        NanoToSec(line.second.m_TimeNs) * 1000.0 / frames,
+                        line.second.m_TimeNs * 100.0 / total };
+        s_prof.m_Report.push_back(row);
+    }
+    std::sort(s_prof.m_Report.begin(),
+              s_prof.m_Report.end(),
+              [](const ProfRow& a, const ProfRow& b) {
+                  return a.m_MsPerFrame > b.m_MsPerFrame;
+              });
+    if (s_prof.m_Report.size() > MAX_REPORT_ROWS) {
+        s_prof.m_Report.resize(MAX_REPORT_ROWS);
+    }
+    s_prof.m_ReportMs = NanoToSec(s_prof.m_FramesTimeNs) * 1000.0 / frames;
+
+    s_prof.m_Lines.clear();
+    s_prof.m_Frames       = 0;
+    s_prof.m_FramesTimeNs = 0;
+}
+
+static void
+StartProfiler(int32_t period)
+{
+    if (s_prof.m_Running) {
+        return;
+    }
+    s_prof.m_Period     = period > 0 ? period : DEFAULT_SAMPLE_PERIOD;
+    s_prof.m_Running    = true;
+    s_prof.m_LastSample = GetHighResTime();
+    s_prof.m_UiThread   = pthread_self();
+
+    struct sigaction action = {};
+    action.sa_handler       = SampleSignal;
+    action.sa_flags         = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, &s_prof.m_OldAction);
+
+    s_prof.m_TimerRun = true;
+    s_prof.m_Timer    = std::thread(SampleTimer);
+}
+
+static void
+StopProfiler(void)
+{
+    if (s_prof.m_Running == false) {
+        return;
+    }
+    s_prof.m_Running  = false;
+    s_prof.m_TimerRun = false;
+    s_prof.m_Timer.join();
+
+    sigaction(SIGPROF, &s_prof.m_OldAction, nullptr);
+    lua_sethook(GetLuaState(), NULL, 0, 0);
+}
+
+static void
+ResetProfile(void)
+{
+    s_prof.m_Stacks.clear();
+    s_prof.m_Lines.clear();
+    s_prof.m_Frames       = 0;
+    s_prof.m_FramesTimeNs = 0;
+}
+
+static bool
+ExportProfile(const char* path)
+{
+    char default_path[512];
+    if (path == nullptr) {
+        snprintf(default_path,
+                 sizeof(default_path),
+                 "%s/.gdbvkgui/lua_profile.folded",
+                 getenv("HOME"));
+        path = default_path;
+    }
+
+    FILE* file = fopen(path, "w");
+    if (file == nullptr) {
+        return false;
+    }
+    // flamegraph.pl / speedscope collapsed format, weights in microseconds
+    for (auto& stack : s_prof.m_Stacks) {
+        fprintf(file,
+                "%s %llu\n",
+                stack.first.c_str(),
+                (unsigned long long)stack.second);
+    }
+    fclose(file);
+
+    printf("Lua profile written to %s\n", path);
+    return true;
+}
+
+static void
+DrawOverlay(void)
+{
+    ImGui::SetNextWindowBgAlpha(0.85f);
+    ImGui::SetNextWindowSize(ImVec2(560, 320), ImGuiCond_FirstUseEver);
+    if (ImGui::Begin("Lua Profiler",
+                     &s_prof.m_ShowOverlay,
+                     ImGuiWindowFlags_NoFocusOnAppearing)) {
+
+        if (ImGui::Button(s_prof.m_Running ? "Stop" : "Start")) {
+            s_prof.m_Running ? StopProfiler() : StartProfiler(s_prof.m_Period);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Reset")) {
+            ResetProfile();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Export")) {
+            ExportProfile(nullptr);
+        }
+        ImGui::SameLine();
+        ImGui::Text("lua %.3f ms/frame (sampled every %d us)",
+                    s_prof.m_ReportMs,
+                    s_prof.m_Period);
+
+        ImGuiTableFlags flags = ImGuiTableFlags_RowBg |
+                                ImGuiTableFlags_Borders |
+                                ImGuiTableFlags_ScrollY |
+                                ImGuiTableFlags_Resizable;
+        if (ImGui::BeginTable("##lua_prof", 4, flags)) {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("ms/frame");
+            ImGui::TableSetupColumn("%");
+            ImGui::TableSetupColumn("line");
+            ImGui::TableSetupColumn("function");
+            ImGui::TableHeadersRow();
+
+            for (const ProfRow& row : s_prof.m_Report) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", row.m_MsPerFrame);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", row.m_Percent);
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(row.m_Location.c_str());
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(row.m_Func.c_str());
+            }
+            ImGui::EndTable();
+        }
+    }
+    ImGui::End();
+}
+
+//------------------------------------------------------------------------------
+
+void
+LuaProfilerBeginFrame(void)
+{
+    if (s_prof.m_Running) {
+        // time between frames isn't lua's
+        s_prof.m_LastSample = GetHighResTime();
+        s_prof.m_InFrame    = true;
+    }
+}
+
+void
+LuaProfilerEndFrame(void)
+{
+    if (s_prof.m_Running == false) {
+        return;
+    }
+    s_prof.m_InFrame = false;
+    lua_sethook(GetLuaState(), NULL, 0, 0);
+
+    if (++s_prof.m_Frames >= FRAMES_PER_REPORT) {
+        PublishReport();
+    }
+    if (s_prof.m_ShowOverlay) {
+        DrawOverlay();
+    }
+}
+
+void
+LuaProfilerShutdown(void)
+{
+    StopProfiler();
+}
+
+//------------------------------------------------------------------------------
+
+static int
+ProfStart(lua_State* L)
+{
+    StartProfiler((int32_t)luaL_optinteger(L, 1, DEFAULT_SAMPLE_PERIOD));
+    s_prof.m_ShowOverlay = true;
+    return 0;
+}
+
+static int
+ProfStop(lua_State* L)
+{
+    StopProfiler();
+    return 0;
+}
+
+static int
+ProfRunning(lua_State* L)
+{
+    lua_pushboolean(L, s_prof.m_Running);
+    return 1;
+}
+
+static int
+ProfReset(lua_State* L)
+{
+    ResetProfile();
+    return 0;
+}
+
+static int
+ProfExport(lua_State* L)
+{
+    lua_pushboolean(L, ExportProfile(luaL_optstring(L, 1, nullptr)));
+    return 1;
+}
+
+static int
+ProfShowOverlay(lua_State* L)
+{
+    s_prof.m_ShowOverlay = lua_toboolean(L, 1);
+    return 0;
+}
+
+static const luaL_Reg s_prof_lib[] = {
+    { "Start", ProfStart },     { "Stop", ProfStop },
+    { "Running", ProfRunning }, { "Reset", ProfReset },
+    { "Export", ProfExport },   { "ShowOverlay", ProfShowOverlay },
+    { NULL, NULL },
+};
+
+int
+luaopen_LuaProfiler(lua_State* L)
+{
+    luaL_newlib(L, s_prof_lib);
+    return 1;
+}
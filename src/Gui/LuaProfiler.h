@@ -0,0 +1,24 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct lua_State lua_State;
+
+    // Global "LuaProfiler" : Start([period_us]), Stop(), Running(),
+    // Reset(), Export([path]), ShowOverlay(bool). Samples are taken every
+    // period_us microseconds (1000 by default)
+    int luaopen_LuaProfiler(lua_State* L);
+
+    // Bracket the lua work of a frame. EndFrame also draws the overlay
+    void LuaProfilerBeginFrame(void);
+
+    void LuaProfilerEndFrame(void);
+
+    void LuaProfilerShutdown(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,908 @@
+#include "LuaJson.h"
+#include "lua.h"
+
+#include "lauxlib.h"
+
+#include "ProcessIO.h"
+#include "UtilityMacros.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Native replacement for JSON.lua's encode/decode. Output matches JSON.lua's
+// defaults : tables with only positive integer keys are arrays (holes become
+// null), everything else is an object with sorted keys, pretty printing
+// indents objects with tabs & keeps arrays inline. Encoding goes through a
+// fixed size buffer that is flushed to disk when writing a file, so a large
+// session is never built as one lua string
+
+#define JSON_WRITER_MT "Json.Writer"
+#define JSON_STREAM_SZ (64 * 1024)
+#define JSON_MAX_DEPTH 200
+
+typedef struct JsonWriter
+{
+    char*   m_Buff;
+    size_t  m_Len;
+    size_t  m_Cap;
+    FILE*   m_File; // when set the buffer is flushed here instead of grown
+    bool    m_Pretty;
+    bool    m_Failed;
+} JsonWriter;
+
+typedef struct JsonKey
+{
+    const char* m_Str;
+    size_t      m_Len;
+    lua_Number  m_Num;
+    bool        m_IsNum; // numeric keys go after the string ones
+} JsonKey;
+
+typedef struct JsonReader
+{
+    lua_State*  L;
+    const char* m_Start;
+    const char* m_Cur;
+    const char* m_End;
+} JsonReader;
+
+//------------------------------------------------------------------------------
+
+static int
+WriterGc(lua_State* L)
+{
+    JsonWriter* w = (JsonWriter*)luaL_checkudata(L, 1, JSON_WRITER_MT);
+    if (w->m_Buff) {
+        WmFree(w->m_Buff);
+        w->m_Buff = NULL;
+    }
+    if (w->m_File) {
+        fclose(w->m_File);
+        w->m_File = NULL;
+    }
+    return 0;
+}
+
+// The writer is a userdata so the buffer & file are released even when
+// encoding raises an error half way through
+static JsonWriter*
+PushWriter(lua_State* L, size_t cap, bool pretty)
+{
+    JsonWriter* w = (JsonWriter*)lua_newuserdatauv(L, sizeof(JsonWriter), 0);
+    memset(w, 0, sizeof(JsonWriter));
+    if (luaL_newmetatable(L, JSON_WRITER_MT)) {
+        lua_pushcfunction(L, WriterGc);
+        lua_setfield(L, -2, "__gc");
+    }
+    lua_setmetatable(L, -2);
+
+    w->m_Buff   = (char*)WmMalloc(cap);
+    w->m_Cap    = cap;
+    w->m_Pretty = pretty;
+    return w;
+}
+
+static void
+FlushWriter(JsonWriter* w)
+{
+    if (w->m_File && w->m_Len) {
+        if (fwrite(w->m_Buff, 1, w->m_Len, w->m_File) != w->m_Len) {
+            w->m_Failed = true;
+        }
+        w->m_Len = 0;
+    }
+}
+
+static void
+WriteBytes(JsonWriter* w, const char* src, size_t sz)
+{
+    if (w->m_Len + sz > w->m_Cap) {
+        if (w->m_File) {
+            FlushWriter(w);
+            if (sz > w->m_Cap) {
+                if (fwrite(src, 1, sz, w->m_File) != sz) {
+                    w->m_Failed = true;
+                }
+                return;
+            }
+        } else {
+            size_t new_cap = w->m_Cap * 2;
+            while (new_cap < w->m_Len + sz) {
+                new_cap *= 2;
+            }
+            w->m_Buff = (char*)WmRealloc(w->m_Buff, new_cap);
+            w->m_Cap  = new_cap;
+        }
+    }
+    memcpy(w->m_Buff + w->m_Len, src, sz);
+    w->m_Len += sz;
+}
+
+static inline void
+WriteChar(JsonWriter* w, char c)
+{
+    if (w->m_Len == w->m_Cap) {
+        WriteBytes(w, &c, 1);
+    } else {
+        w->m_Buff[w->m_Len++] = c;
+    }
+}
+
+static void
+WriteIndent(JsonWriter* w, int32_t depth)
+{
+    for (int32_t i = 0; i < depth; i++) {
+        WriteChar(w, '\t');
+    }
+}
+
+static void
+WriteString(JsonWriter* w, const char* str, size_t sz)
+{
+    WriteChar(w, '"');
+
+    size_t run = 0; // bytes that need no escaping are copied in one go
+    for (size_t i = 0; i < sz; i++) {
+        unsigned char c = (unsigned char)str[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        WriteBytes(w, str + run, i - run);
+        run = i + 1;
+
+        char esc[8];
+        switch (c) {
+            case '"':
+                WriteBytes(w, "\\\"", 2);
+                break;
+            case '\\':
+                WriteBytes(w, "\\\\", 2);
+                break;
+            case '\n':
+                WriteBytes(w, "\\n", 2);
+                break;
+            case '\r':
+                WriteBytes(w, "\\r", 2);
+                break;
+            case '\t':
+                WriteBytes(w, "\\t", 2);
+                break;
+            case '\b':
+                WriteBytes(w, "\\b", 2);
+                break;
+            case '\f':
+                WriteBytes(w, "\\f", 2);
+                break;
+            default:
+                snprintf(esc, sizeof(esc), "\\u%04x", c);
+                WriteBytes(w, esc, 6);
+                break;
+        }
+    }
+    WriteBytes(w, str + run, sz - run);
+
+    WriteChar(w, '"');
+}
+
+static void
+WriteNumber(lua_State* L, JsonWriter* w, int idx)
+{
+    char buff[64];
+    int  sz = 0;
+    if (lua_isinteger(L, idx)) {
+        sz = snprintf(buff,
+                      sizeof(buff),
+                      LUA_INTEGER_FMT,
+                      (LUAI_UACINT)lua_tointeger(L, idx));
+    } else {
+        lua_Number num = lua_tonumber(L, idx);
+        if (num != num) {
+            sz = snprintf(buff, sizeof(buff), "null");
+        } else if (isinf(num)) {
+            sz = snprintf(buff, sizeof(buff), num > 0 ? "1e+9999" : "-1e+9999");
+        } else {
+            // same text as tostring()
+            sz = snprintf(buff, sizeof(buff), LUA_NUMBER_FMT, num);
+            if (buff[strspn(buff, "-0123456789")] == '\0') {
+                buff[sz++] = '.';
+                buff[sz++] = '0';
+            }
+        }
+    }
+    WriteBytes(w, buff, sz);
+}
+
+static int
+CompareKeys(const void* lhs, const void* rhs)
+{
+    const JsonKey* a = (const JsonKey*)lhs;
+    const JsonKey* b = (const JsonKey*)rhs;
+
+    if (a->m_IsNum != b->m_IsNum) {
+        return a->m_IsNum ? 1 : -1;
+    } else if (a->m_IsNum) {
+        return a->m_Num < b->m_Num ? -1 : (a->m_Num > b->m_Num ? 1 : 0);
+    }
+
+    int cmp = memcmp(a->m_Str, b->m_Str, MIN(a->m_Len, b->m_Len));
+    if (cmp == 0) {
+        return a->m_Len < b->m_Len ? -1 : (a->m_Len > b->m_Len ? 1 : 0);
+    }
+    return cmp;
+}
+
+static void
+EncodeValue(lua_State* L, JsonWriter* w, int idx, int32_t depth);
+
+static void
+EncodeArray(lua_State*  L,
+            JsonWriter* w,
+            int         idx,
+            lua_Integer count,
+            int32_t     depth)
+{
+    WriteChar(w, '[');
+    if (w->m_Pretty) {
+        WriteChar(w, ' ');
+    }
+    for (lua_Integer i = 1; i <= count; i++) {
+        if (i > 1) {
+            WriteBytes(w, w->m_Pretty ? ", " : ",", w->m_Pretty ? 2 : 1);
+        }
+        lua_rawgeti(L, idx, i);
+        EncodeValue(L, w, lua_gettop(L), depth);
+        lua_pop(L, 1);
+    }
+    if (w->m_Pretty) {
+        WriteChar(w, ' ');
+    }
+    WriteChar(w, ']');
+}
+
+// Copy of a table with every key converted to a string (JSON.lua does the
+// same for tables that mix numeric & string keys)
+static void
+PushStringKeyed(lua_State* L, int idx)
+{
+    lua_newtable(L);
+    int map = lua_gettop(L);
+
+    lua_pushnil(L);
+    while (lua_next(L, idx)) {
+        int key_type = lua_type(L, -2);
+        if (key_type != LUA_TSTRING && key_type != LUA_TNUMBER &&
+            key_type != LUA_TBOOLEAN) {
+            luaL_error(L,
+                       "can't encode table with a key of type %s",
+                       luaL_typename(L, -2));
+        }
+        luaL_tolstring(L, -2, NULL);
+        lua_pushvalue(L, -1);
+        if (lua_rawget(L, map) != LUA_TNIL) {
+            luaL_error(L,
+                       "conflict converting table with mixed-type keys into a "
+                       "JSON object: key %s exists both as a string and a "
+                       "number",
+                       lua_tostring(L, -2));
+        }
+        lua_pop(L, 1);
+        lua_pushvalue(L, -2);
+        lua_rawset(L, map); // map[tostring(key)] = value
+        lua_pop(L, 1);
+    }
+}
+
+// Keys come from the table at idx, values from the table at vals (the string
+// keyed copy for mixed tables). Numeric & boolean key strings are interned so
+// they stay alive in the copy after being popped
+static void
+EncodeObject(lua_State*  L,
+             JsonWriter* w,
+             int         idx,
+             int         vals,
+             uint32_t    count,
+             int32_t     depth)
+{
+    // the key strings stay alive as long as the table does
+    JsonKey* keys = (JsonKey*)lua_newuserdatauv(L, count * sizeof(JsonKey), 0);
+    uint32_t n    = 0;
+    lua_pushnil(L);
+    while (lua_next(L, idx)) {
+        lua_pop(L, 1);
+        keys[n].m_IsNum = lua_type(L, -1) == LUA_TNUMBER;
+        keys[n].m_Num   = keys[n].m_IsNum ? lua_tonumber(L, -1) : 0;
+        if (lua_type(L, -1) == LUA_TSTRING) {
+            keys[n].m_Str = lua_tolstring(L, -1, &keys[n].m_Len);
+        } else {
+            keys[n].m_Str = luaL_tolstring(L, -1, &keys[n].m_Len);
+            lua_pop(L, 1);
+        }
+        n++;
+    }
+    qsort(keys, n, sizeof(JsonKey), CompareKeys);
+
+    WriteChar(w, '{');
+    for (uint32_t i = 0; i < n; i++) {
+        if (i) {
+            WriteChar(w, ',');
+        }
+        if (w->m_Pretty) {
+            WriteChar(w, '\n');
+            WriteIndent(w, depth + 1);
+        }
+        WriteString(w, keys[i].m_Str, keys[i].m_Len);
+        WriteBytes(w, w->m_Pretty ? ": " : ":", w->m_Pretty ? 2 : 1);
+
+        lua_pushlstring(L, keys[i].m_Str, keys[i].m_Len);
+        lua_rawget(L, vals);
+        EncodeValue(L, w, lua_gettop(L), depth + 1);
+        lua_pop(L, 1);
+    }
+    if (w->m_Pretty) {
+        WriteChar(w, '\n');
+        WriteIndent(w, depth);
+    }
+    WriteChar(w, '}');
+
+    lua_pop(L, 1); // keys
+}
+
+static void
+EncodeTable(lua_State* L, JsonWriter* w, int idx, int32_t depth)
+{
+    if (depth >= JSON_MAX_DEPTH) {
+        luaL_error(L,
+                   "table nested too deeply to encode (is it a child of "
+                   "itself?)");
+    }
+    luaL_checkstack(L, 6, "table nested too deeply to encode");
+
+    uint32_t    string_keys = 0;
+    uint32_t    index_keys  = 0;
+    uint32_t    other_keys  = 0;
+    lua_Integer max_index   = 0;
+
+    lua_pushnil(L);
+    while (lua_next(L, idx)) {
+        lua_pop(L, 1);
+        if (lua_type(L, -1) == LUA_TSTRING) {
+            string_keys++;
+        } else if (lua_isinteger(L, -1) && lua_tointeger(L, -1) > 0) {
+            max_index = MAX(max_index, lua_tointeger(L, -1));
+            index_keys++;
+        } else {
+            other_keys++;
+        }
+    }
+
+    if (string_keys == 0 && other_keys == 0) {
+        if (max_index) {
+            EncodeArray(L, w, idx, max_index, depth);
+        } else {
+            // empty array/object, JSON.lua also guesses array
+            WriteBytes(w, "[]", 2);
+        }
+    } else if (max_index == 0 && other_keys == 0) {
+        EncodeObject(L, w, idx, idx, string_keys, depth);
+    } else {
+        PushStringKeyed(L, idx);
+        EncodeObject(L,
+                     w,
+                     idx,
+                     lua_gettop(L),
+                     string_keys + index_keys + other_keys,
+                     depth);
+        lua_pop(L, 1);
+    }
+}
+
+static void
+EncodeValue(lua_State* L, JsonWriter* w, int idx, int32_t depth)
+{
+    size_t      sz  = 0;
+    const char* str = NULL;
+    switch (lua_type(L, idx)) {
+        case LUA_TNIL:
+        case LUA_TNONE:
+            WriteBytes(w, "null", 4);
+            break;
+        case LUA_TBOOLEAN:
+            if (lua_toboolean(L, idx)) {
+                WriteBytes(w, "true", 4);
+            } else {
+                WriteBytes(w, "false", 5);
+            }
+            break;
+        case LUA_TNUMBER:
+            WriteNumber(L, w, idx);
+            break;
+        case LUA_TSTRING:
+            str = lua_tolstring(L, idx, &sz);
+            WriteString(w, str, sz);
+            break;
+        case LUA_TTABLE:
+            EncodeTable(L, w, idx, depth);
+            break;
+        default:
+            luaL_error(L, "can't convert %s to JSON", luaL_typename(L, idx));
+            break;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+static int
+DecodeError(JsonReader* r, const char* msg)
+{
+    return luaL_error(r->L,
+                      "%s at byte %d of JSON text",
+                      msg,
+                      (int)(r->m_Cur - r->m_Start) + 1);
+}
+
+static inline void
+SkipWhitespace(JsonReader* r)
+{
+    while (r->m_Cur < r->m_End &&
+           (*r->m_Cur == ' ' || *r->m_Cur == '\n' || *r->m_Cur == '\t' ||
+            *r->m_Cur == '\r')) {
+        r->m_Cur++;
+    }
+}
+
+static int32_t
+HexValue(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// -1 when there aren't 4 hex digits (the escape is then passed through)
+static int32_t
+ReadHex4(JsonReader* r)
+{
+    if (r->m_End - r->m_Cur < 4) {
+        return -1;
+    }
+    int32_t code = 0;
+    for (int32_t i = 0; i < 4; i++) {
+        int32_t digit = HexValue(r->m_Cur[i]);
+        if (digit < 0) {
+            return -1;
+        }
+        code = (code << 4) | digit;
+    }
+    r->m_Cur += 4;
+    return code;
+}
+
+static void
+AddUtf8(luaL_Buffer* b, uint32_t code)
+{
+    if (code < 0x80) {
+        luaL_addchar(b, (char)code);
+    } else if (code < 0x800) {
+        luaL_addchar(b, (char)(0xC0 | (code >> 6)));
+        luaL_addchar(b, (char)(0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+        luaL_addchar(b, (char)(0xE0 | (code >> 12)));
+        luaL_addchar(b, (char)(0x80 | ((code >> 6) & 0x3F)));
+        luaL_addchar(b, (char)(0x80 | (code & 0x3F)));
+    } else {
+        luaL_addchar(b, (char)(0xF0 | (code >> 18)));
+        luaL_addchar(b, (char)(0x80 | ((code >> 12) & 0x3F)));
+        luaL_addchar(b, (char)(0x80 | ((code >> 6) & 0x3F)));
+        luaL_addchar(b, (char)(0x80 | (code & 0x3F)));
+    }
+}
+
+static void
+DecodeString(JsonReader* r)
+{
+    r->m_Cur++; // opening quote
+
+    // most strings have no escapes : push them straight from the text
+    const char* scan = r->m_Cur;
+    while (scan < r->m_End && *scan != '"' && *scan != '\\') {
+        scan++;
+    }
+    if (scan == r->m_End) {
+        DecodeError(r, "unterminated string");
+    }
+    if (*scan == '"') {
+        lua_pushlstring(r->L, r->m_Cur, scan - r->m_Cur);
+        r->m_Cur = scan + 1;
+        return;
+    }
+
+    luaL_Buffer b;
+    luaL_buffinit(r->L, &b);
+    luaL_addlstring(&b, r->m_Cur, scan - r->m_Cur);
+    r->m_Cur = scan;
+
+    while (r->m_Cur < r->m_End && *r->m_Cur != '"') {
+        char c = *r->m_Cur++;
+        if (c != '\\') {
+            luaL_addchar(&b, c);
+            continue;
+        }
+        if (r->m_Cur == r->m_End) {
+            break;
+        }
+        c = *r->m_Cur++;
+        switch (c) {
+            case 'n':
+                luaL_addchar(&b, '\n');
+                break;
+            case 'r':
+                luaL_addchar(&b, '\r');
+                break;
+            case 't':
+                luaL_addchar(&b, '\t');
+                break;
+            case 'b':
+                luaL_addchar(&b, '\b');
+                break;
+            case 'f':
+                luaL_addchar(&b, '\f');
+                break;
+            case 'u': {
+                int32_t code = ReadHex4(r);
+                if (code < 0) {
+                    luaL_addchar(&b, c);
+                    break;
+                }
+                if (code >= 0xD800 && code <= 0xDBFF &&
+                    r->m_End - r->m_Cur >= 6 && r->m_Cur[0] == '\\' &&
+                    r->m_Cur[1] == 'u') {
+                    // surrogate pair
+                    const char* save = r->m_Cur;
+                    r->m_Cur += 2;
+                    int32_t low = ReadHex4(r);
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        code = 0x10000 + ((code - 0xD800) << 10) +
+                               (low - 0xDC00);
+                    } else {
+                        r->m_Cur = save;
+                    }
+                }
+                AddUtf8(&b, (uint32_t)code);
+            } break;
+            default: // \" \\ \/ & anything else verbatim
+                luaL_addchar(&b, c);
+                break;
+        }
+    }
+    if (r->m_Cur == r->m_End) {
+        DecodeError(r, "unterminated string");
+    }
+    r->m_Cur++; // closing quote
+
+    luaL_pushresult(&b);
+}
+
+static void
+DecodeNumber(JsonReader* r)
+{
+    const char* start = r->m_Cur;
+    const char* cur   = start;
+    bool        neg   = false;
+    if (cur < r->m_End && *cur == '-') {
+        neg = true;
+        cur++;
+    }
+
+    // plain integers that can't overflow take the fast path
+    uint64_t value = 0;
+    const char* digits = cur;
+    while (cur < r->m_End && *cur >= '0' && *cur <= '9') {
+        value = value * 10 + (*cur - '0');
+        cur++;
+    }
+    if (cur == digits) {
+        DecodeError(r, "bad number");
+    }
+    bool is_float = false;
+    while (cur < r->m_End &&
+           ((*cur >= '0' && *cur <= '9') || *cur == '.' || *cur == 'e' ||
+            *cur == 'E' || *cur == '+' || *cur == '-')) {
+        is_float = true;
+        cur++;
+    }
+
+    if (is_float == false && cur - digits <= 18) {
+        lua_pushinteger(r->L, neg ? -(lua_Integer)value : (lua_Integer)value);
+    } else {
+        // tonumber() semantics : floats & integers that overflow to floats
+        char buff[128];
+        if (cur - start >= (ptrdiff_t)sizeof(buff)) {
+            DecodeError(r, "number too long");
+        }
+        memcpy(buff, start, cur - start);
+        buff[cur - start] = '\0';
+        if (lua_stringtonumber(r->L, buff) == 0) {
+            DecodeError(r, "bad number");
+        }
+    }
+    r->m_Cur = cur;
+}
+
+static bool
+MatchLiteral(JsonReader* r, const char* lit, size_t sz)
+{
+    if ((size_t)(r->m_End - r->m_Cur) >= sz && memcmp(r->m_Cur, lit, sz) == 0) {
+        r->m_Cur += sz;
+        return true;
+    }
+    return false;
+}
+
+// Pushes exactly one value (nil for null)
+static void
+DecodeValue(JsonReader* r, int32_t depth);
+
+static void
+DecodeArray(JsonReader* r, int32_t depth)
+{
+    lua_State* L = r->L;
+    lua_newtable(L);
+    r->m_Cur++;
+
+    SkipWhitespace(r);
+    if (r->m_Cur < r->m_End && *r->m_Cur == ']') {
+        r->m_Cur++;
+        return;
+    }
+
+    lua_Integer index = 1;
+    for (;;) {
+        DecodeValue(r, depth + 1);
+        if (lua_isnil(L, -1)) {
+            lua_pop(L, 1); // null leaves a hole
+        } else {
+            lua_rawseti(L, -2, index);
+        }
+        index++;
+
+        SkipWhitespace(r);
+        if (r->m_Cur == r->m_End) {
+            DecodeError(r, "unclosed array");
+        }
+        char c = *r->m_Cur++;
+        if (c == ']') {
+            break;
+        } else if (c != ',') {
+            r->m_Cur--;
+            DecodeError(r, "expected comma or ']' in array");
+        }
+    }
+}
+
+static void
+DecodeObject(JsonReader* r, int32_t depth)
+{
+    lua_State* L = r->L;
+    lua_newtable(L);
+    r->m_Cur++;
+
+    SkipWhitespace(r);
+    if (r->m_Cur < r->m_End && *r->m_Cur == '}') {
+        r->m_Cur++;
+        return;
+    }
+
+    for (;;) {
+        SkipWhitespace(r);
+        if (r->m_Cur == r->m_End || *r->m_Cur != '"') {
+            DecodeError(r, "expected string key in object");
+        }
+        DecodeString(r);
+
+        SkipWhitespace(r);
+        if (r->m_Cur == r->m_End || *r->m_Cur != ':') {
+            DecodeError(r, "expected colon in object");
+        }
+        r->m_Cur++;
+
+        DecodeValue(r, depth + 1);
+        if (lua_isnil(L, -1)) {
+            lua_pop(L, 2);
+        } else {
+            lua_rawset(L, -3);
+        }
+
+        SkipWhitespace(r);
+        if (r->m_Cur == r->m_End) {
+            DecodeError(r, "unclosed object");
+        }
+        char c = *r->m_Cur++;
+        if (c == '}') {
+            break;
+        } else if (c != ',') {
+            r->m_Cur--;
+            DecodeError(r, "expected comma or '}' in object");
+        }
+    }
+}
+
+static void
+DecodeValue(JsonReader* r, int32_t depth)
+{
+    if (depth >= JSON_MAX_DEPTH) {
+        DecodeError(r, "JSON nested too deeply");
+    }
+    luaL_checkstack(r->L, 4, "JSON nested too deeply");
+
+    SkipWhitespace(r);
+    if (r->m_Cur == r->m_End) {
+        DecodeError(r, "unexpected end of JSON text");
+    }
+
+    switch (*r->m_Cur) {
+        case '{':
+            DecodeObject(r, depth);
+            break;
+        case '[':
+            DecodeArray(r, depth);
+            break;
+        case '"':
+            DecodeString(r);
+            break;
+        case 't':
+            if (MatchLiteral(r, "true", 4) == false) {
+                DecodeError(r, "unexpected token");
+            }
+            lua_pushboolean(r->L, 1);
+            break;
+        case 'f':
+            if (MatchLiteral(r, "false", 5) == false) {
+                DecodeError(r, "unexpected token");
+            }
+            lua_pushboolean(r->L, 0);
+            break;
+        case 'n':
+            if (MatchLiteral(r, "null", 4) == false) {
+                DecodeError(r, "unexpected token");
+            }
+            lua_pushnil(r->L);
+            break;
+        default:
+            DecodeNumber(r);
+            break;
+    }
+}
+
+static int
+DecodeText(lua_State* L, const char* text, size_t sz)
+{
+    JsonReader r = { L, text, text, text + sz };
+
+    // an empty string is nothing, but not an error
+    SkipWhitespace(&r);
+    if (r.m_Cur == r.m_End) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    DecodeValue(&r, 0);
+
+    SkipWhitespace(&r);
+    if (r.m_Cur != r.m_End) {
+        DecodeError(&r, "trailing garbage");
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+
+static int
+JsonDecode(lua_State* L)
+{
+    size_t      sz   = 0;
+    const char* text = luaL_checklstring(L, 2, &sz);
+    return DecodeText(L, text, sz);
+}
+
+static int
+JsonDecodeFile(lua_State* L)
+{
+    const char* path = luaL_checkstring(L, 2);
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        luaL_pushfail(L);
+        lua_pushfstring(L, "can't open %s", path);
+        return 2;
+    }
+    fseek(file, 0, SEEK_END);
+    long sz = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    // the text is a userdata so it goes away with the stack on a parse error
+    char*  text = (char*)lua_newuserdatauv(L, sz > 0 ? sz : 1, 0);
+    size_t read = sz > 0 ? fread(text, 1, sz, file) : 0;
+    fclose(file);
+
+    DecodeText(L, text, read);
+    lua_remove(L, -2);
+    return 1;
+}
+
+static int
+EncodeToString(lua_State* L, bool pretty)
+{
+    luaL_checkany(L, 2);
+    lua_settop(L, 2);
+
+    JsonWriter* w = PushWriter(L, 4096, pretty);
+    EncodeValue(L, w, 2, 0);
+
+    lua_pushlstring(L, w->m_Buff, w->m_Len);
+    return 1;
+}
+
+static int
+JsonEncode(lua_State* L)
+{
+    return EncodeToString(L, false);
+}
+
+static int
+JsonEncodePretty(lua_State* L)
+{
+    return EncodeToString(L, true);
+}
+
+static int
+JsonEncodeToFile(lua_State* L)
+{
+    luaL_checkany(L, 2);
+    const char* path   = luaL_checkstring(L, 3);
+    bool        pretty = lua_toboolean(L, 4);
+    lua_settop(L, 3);
+
+    JsonWriter* w = PushWriter(L, JSON_STREAM_SZ, pretty);
+    w->m_File     = fopen(path, "w");
+    if (w->m_File == NULL) {
+        luaL_pushfail(L);
+        lua_pushfstring(L, "can't open %s", path);
+        return 2;
+    }
+
+    EncodeValue(L, w, 2, 0);
+    FlushWriter(w);
+
+    bool failed = fclose(w->m_File) != 0 || w->m_Failed;
+    w->m_File   = NULL;
+    if (failed) {
+        luaL_pushfail(L);
+        lua_pushfstring(L, "failed writing %s", path);
+        return 2;
+    }
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+static const luaL_Reg s_json_lib[] = {
+    { "decode", JsonDecode },
+    { "decode_file", JsonDecodeFile },
+    { "encode", JsonEncode },
+    { "encode_pretty", JsonEncodePretty },
+    { "encode_to_file", JsonEncodeToFile },
+    { NULL, NULL },
+};
+
+int
+luaopen_Json(lua_State* L)
+{
+    luaL_newlib(L, s_json_lib);
+    return 1;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct lua_State lua_State;
+
+    // require "Json" : same calling convention as JSON.lua (Json:decode(text),
+    // Json:encode(v), Json:encode_pretty(v)) plus the streaming
+    // Json:encode_to_file(v, path[, pretty]) & Json:decode_file(path)
+    int luaopen_Json(lua_State* L);
+
+#ifdef __cplusplus
+}
+#endif
@@ -5,10 +5,17 @@
 #include "lauxlib.h"
 
 #include "Gui/ImguiToLua.h"
+#include "LuaJson.h"
 #include "ProcessIO.h"
 #include "UtilityMacros.h"
 #include "WindowInterface.h"
+#include <errno.h>
 #include <stdlib.h>
+#include <strings.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 
 static lua_State* s_lstate;
 static uint64_t   s_lua_alloc_count;
@@ -16,6 +23,21 @@ static uint64_t   s_lua_alloc_count;
 static int32_t s_glb_ref;
 static int32_t s_func_ref;
 
+static int  s_watch_fd = -1;
+static char s_watch_dir[512];
+
+#define LUA_VEC_MT "ImGui.Vec"
+
+// Vector userdata : m_Count (2 or 4) components of m_V are visible to lua
+typedef struct LuaVec
+{
+    Vec4    m_V;
+    int32_t m_Count;
+} LuaVec;
+
+static void
+RegisterVecMetatable(void);
+
 //------------------------------------------------------------------------------
 
 static void*
@@ -39,6 +61,15 @@ LuaAlloc(void* user_data, void* ptr, size_t old_sz, size_t new_sz)
     }
 }
 
+// Ends the app after the current frame (same as closing the window)
+static int
+LuaExitApp(lua_State* L)
+{
+    UNUSED_VAR(L);
+    AppForceQuit();
+    return 0;
+}
+
 lua_State*
 InitLuaState(void)
 {
@@ -70,8 +101,14 @@ InitLuaState(void)
         lua_pushstring(s_lstate, root_dir);
         lua_setglobal(s_lstate, "ROOT_DIR");
 
+        lua_register(s_lstate, "ExitApp", LuaExitApp);
+
+        RegisterVecMetatable();
+
         // add user libraries and functions
         luaL_requiref(s_lstate, "ImGuiLib", luaopen_ImguiLib, 1);
+        luaL_requiref(s_lstate, "Json", luaopen_Json, 0);
+        lua_pop(s_lstate, 2);
     }
     s_glb_ref  = -1;
     s_func_ref = -1;
@@ -85,6 +122,13 @@ GetLuaState(void)
     return s_lstate;
 }
 
+static int
+MsgHandler(lua_State* L)
+{
+    luaL_traceback(L, L, lua_tostring(L, 1), 1);
+    return 1;
+}
+
 static void
 handle_lua_error()
 {
@@ -279,6 +323,462 @@ GetLuaGlobalReference(const int l_class, const char* func)
     return LUA_REFNIL;
 }
 
+//------------------------------------------------------------------------------
+// Hot reload. Changed *.lua files in the watched directory are re-run between
+// frames if they belong to an already loaded module (matched by file name,
+// case insensitive) or are the AppMain entry script. Module tables & GdbApp
+// keep their identity : functions from the new chunk replace the old ones,
+// new keys are added and existing state is left alone.
+
+int
+WatchScriptDir(const char* dir)
+{
+    if (s_watch_fd == -1) {
+        s_watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    }
+    if (s_watch_fd == -1 ||
+        inotify_add_watch(s_watch_fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+        printf("Failed to watch script directory %s : %s\n",
+               dir,
+               strerror(errno));
+        return 0;
+    }
+    snprintf(s_watch_dir, sizeof(s_watch_dir), "%s", dir);
+
+    // scripts in the watched directory take precedence for require
+    lua_getglobal(s_lstate, "package");
+    lua_pushfstring(s_lstate, "%s/?.lua;", dir);
+    lua_getfield(s_lstate, -2, "path");
+    lua_concat(s_lstate, 2);
+    lua_setfield(s_lstate, -2, "path");
+    lua_pop(s_lstate, 1);
+
+    printf("Watching %s for script changes\n", dir);
+    return 1;
+}
+
+// Copies functions & missing keys of the table at new_idx into old_idx
+static void
+MergeLuaTable(int old_idx, int new_idx)
+{
+    old_idx = lua_absindex(s_lstate, old_idx);
+    new_idx = lua_absindex(s_lstate, new_idx);
+
+    lua_pushnil(s_lstate);
+    while (lua_next(s_lstate, new_idx)) {
+        lua_pushvalue(s_lstate, -2);
+        lua_rawget(s_lstate, old_idx);
+        bool replace = lua_isnil(s_lstate, -1) || lua_isfunction(s_lstate, -2);
+        lua_pop(s_lstate, 1);
+
+        if (replace) {
+            lua_pushvalue(s_lstate, -2);
+            lua_insert(s_lstate, -2);
+            lua_rawset(s_lstate, old_idx);
+        } else {
+            lua_pop(s_lstate, 1);
+        }
+    }
+}
+
+// Pushes the name of the loaded module for file stem (or nil)
+static void
+FindLoadedModule(const char* stem)
+{
+    lua_getfield(s_lstate, LUA_REGISTRYINDEX, LUA_LOADED_TABLE);
+    lua_pushnil(s_lstate);
+    while (lua_next(s_lstate, -2)) {
+        lua_pop(s_lstate, 1);
+        if (lua_type(s_lstate, -1) == LUA_TSTRING &&
+            strcasecmp(lua_tostring(s_lstate, -1), stem) == 0) {
+            lua_remove(s_lstate, -2);
+            return;
+        }
+    }
+    lua_pop(s_lstate, 1);
+
+    if (strcmp(stem, "AppMain") == 0) {
+        lua_pushstring(s_lstate, stem);
+    } else {
+        lua_pushnil(s_lstate);
+    }
+}
+
+static double
+FileAgeMs(const char* path)
+{
+    struct stat     inf = { 0 };
+    struct timespec now;
+    if (stat(path, &inf) != 0 || clock_gettime(CLOCK_REALTIME, &now) != 0) {
+        return 0.0;
+    }
+    return (now.tv_sec - inf.st_mtim.tv_sec) * 1000.0 +
+           (now.tv_nsec - inf.st_mtim.tv_nsec) / 1000000.0;
+}
+
+static bool
+ReloadScript(const char* stem)
+{
+    int top = lua_gettop(s_lstate);
+
+    FindLoadedModule(stem);
+    if (lua_isnil(s_lstate, -1)) {
+        lua_settop(s_lstate, top);
+        return false;
+    }
+    const char* name = lua_tostring(s_lstate, -1);
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%.255s.lua", s_watch_dir, stem);
+    double   write_age  = FileAgeMs(path);
+    uint64_t start_time = GetHighResTime();
+
+    // keep the old module & app state around : [name, old_mod, old_app]
+    lua_getfield(s_lstate, LUA_REGISTRYINDEX, LUA_LOADED_TABLE);
+    lua_getfield(s_lstate, -1, name);
+    lua_remove(s_lstate, -2);
+    lua_getglobal(s_lstate, "GdbApp");
+
+    lua_pushcfunction(s_lstate, MsgHandler);
+    int msgh = lua_gettop(s_lstate);
+
+    if (luaL_loadfile(s_lstate, path) != LUA_OK ||
+        (lua_pushstring(s_lstate, name),
+         lua_pcall(s_lstate, 1, 1, msgh) != LUA_OK)) {
+
+        printf("[reload] %s failed, keeping the old version :\n%s\n",
+               name,
+               lua_tostring(s_lstate, -1));
+
+        // undo whatever the chunk managed to replace
+        lua_getfield(s_lstate, LUA_REGISTRYINDEX, LUA_LOADED_TABLE);
+        lua_pushvalue(s_lstate, top + 2);
+        lua_setfield(s_lstate, -2, name);
+        lua_pushvalue(s_lstate, top + 3);
+        lua_setglobal(s_lstate, "GdbApp");
+
+        lua_settop(s_lstate, top);
+        return false;
+    }
+
+    // module value : what the chunk returned, else what it stored itself
+    if (lua_isnil(s_lstate, -1)) {
+        lua_pop(s_lstate, 1);
+        lua_getfield(s_lstate, LUA_REGISTRYINDEX, LUA_LOADED_TABLE);
+        lua_getfield(s_lstate, -1, name);
+        lua_remove(s_lstate, -2);
+    }
+
+    int new_mod = lua_gettop(s_lstate);
+    if (lua_istable(s_lstate, top + 2) && lua_istable(s_lstate, new_mod)) {
+        MergeLuaTable(top + 2, new_mod);
+
+        lua_getglobal(s_lstate, name);
+        if (lua_rawequal(s_lstate, -1, new_mod)) {
+            lua_pushvalue(s_lstate, top + 2);
+            lua_setglobal(s_lstate, name);
+        }
+        lua_pop(s_lstate, 1);
+
+        lua_getfield(s_lstate, LUA_REGISTRYINDEX, LUA_LOADED_TABLE);
+        lua_pushvalue(s_lstate, top + 2);
+        lua_setfield(s_lstate, -2, name);
+        lua_pop(s_lstate, 1);
+    }
+
+    lua_getglobal(s_lstate, "GdbApp");
+    if (lua_istable(s_lstate, top + 3) && lua_istable(s_lstate, -1) &&
+        !lua_rawequal(s_lstate, -1, top + 3)) {
+        MergeLuaTable(top + 3, -1);
+        lua_pushvalue(s_lstate, top + 3);
+        lua_setglobal(s_lstate, "GdbApp");
+    }
+
+    double reload_ms = NanoToSec(GetHighResTime() - start_time) * 1000.0;
+    printf("[reload] %s : %.2f ms to reload, %.1f ms since the file was "
+           "written\n",
+           name,
+           reload_ms,
+           write_age + reload_ms);
+
+    lua_settop(s_lstate, top);
+    return true;
+}
+
+int
+ReloadChangedModules(void)
+{
+    if (s_watch_fd == -1) {
+        return 0;
+    }
+
+    // collect first, editors tend to emit several events per save
+    char    stems[16][256];
+    int32_t stem_count = 0;
+
+    char buff[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t read_bytes = 0;
+    while ((read_bytes = read(s_watch_fd, buff, sizeof(buff))) > 0) {
+        for (char* ptr = buff; ptr < buff + read_bytes;) {
+            struct inotify_event* ev = (struct inotify_event*)ptr;
+            ptr += sizeof(struct inotify_event) + ev->len;
+
+            size_t name_len = ev->len ? strlen(ev->name) : 0;
+            if (name_len < 5 || name_len > 255 ||
+                strcmp(ev->name + name_len - 4, ".lua") != 0) {
+                continue;
+            }
+
+            char stem[256] = { 0 };
+            memcpy(stem, ev->name, name_len - 4);
+
+            bool seen = false;
+            for (int32_t i = 0; i < stem_count && !seen; i++) {
+                seen = strcmp(stems[i], stem) == 0;
+            }
+            if (!seen && stem_count < 16) {
+                memcpy(stems[stem_count++], stem, sizeof(stem));
+            }
+        }
+    }
+
+    int reloaded = 0;
+    for (int32_t i = 0; i < stem_count; i++) {
+        reloaded += ReloadScript(stems[i]) ? 1 : 0;
+    }
+    return reloaded;
+}
+
+//------------------------------------------------------------------------------
+
+static LuaVec*
+NewLuaVec(lua_State* L, int32_t count)
+{
+    LuaVec* vec = (LuaVec*)lua_newuserdatauv(L, sizeof(LuaVec), 0);
+    memset(vec, 0, sizeof(LuaVec));
+    vec->m_Count = count;
+    luaL_setmetatable(L, LUA_VEC_MT);
+
+    return vec;
+}
+
+static LuaVec*
+ToLuaVec(lua_State* L, int index)
+{
+    return (LuaVec*)luaL_testudata(L, index, LUA_VEC_MT);
+}
+
+// component index from 1..4 or x/y/z/w, -1 when invalid
+static int32_t
+GetVecComponent(lua_State* L, const LuaVec* vec, int index)
+{
+    int32_t comp = -1;
+    if (lua_type(L, index) == LUA_TNUMBER) {
+        comp = (int32_t)lua_tointeger(L, index) - 1;
+    } else if (lua_type(L, index) == LUA_TSTRING) {
+        size_t      len = 0;
+        const char* key = lua_tolstring(L, index, &len);
+        if (len == 1) {
+            switch (key[0]) {
+                case 'x': comp = 0; break;
+                case 'y': comp = 1; break;
+                case 'z': comp = 2; break;
+                case 'w': comp = 3; break;
+                default: break;
+            }
+        }
+    }
+    return (comp >= 0 && comp < vec->m_Count) ? comp : -1;
+}
+
+static int
+CreateVec(lua_State* L, int32_t count)
+{
+    LuaVec* src = ToLuaVec(L, 1);
+    Vec4    val = { 0 };
+    if (src) {
+        val = src->m_V;
+    } else {
+        for (int32_t i = 0; i < count; i++) {
+            val.raw[i] = (float)luaL_optnumber(L, i + 1, 0.0);
+        }
+    }
+
+    LuaVec* vec = NewLuaVec(L, count);
+    vec->m_V    = val;
+
+    return 1;
+}
+
+int
+LuaNewVec2(lua_State* L)
+{
+    return CreateVec(L, 2);
+}
+
+int
+LuaNewVec4(lua_State* L)
+{
+    return CreateVec(L, 4);
+}
+
+static int
+VecIndex(lua_State* L)
+{
+    LuaVec* vec  = (LuaVec*)luaL_checkudata(L, 1, LUA_VEC_MT);
+    int32_t comp = GetVecComponent(L, vec, 2);
+    if (comp < 0) {
+        lua_pushnil(L);
+    } else {
+        lua_pushnumber(L, vec->m_V.raw[comp]);
+    }
+    return 1;
+}
+
+static int
+VecNewIndex(lua_State* L)
+{
+    LuaVec* vec  = (LuaVec*)luaL_checkudata(L, 1, LUA_VEC_MT);
+    int32_t comp = GetVecComponent(L, vec, 2);
+    if (comp < 0) {
+        return luaL_error(L, "invalid vector component");
+    }
+    vec->m_V.raw[comp] = (float)luaL_checknumber(L, 3);
+
+    return 0;
+}
+
+// binary ops accept vec op vec, vec op number and number op vec
+typedef enum VecOp
+{
+    VEC_ADD,
+    VEC_SUB,
+    VEC_MUL,
+    VEC_DIV,
+} VecOp;
+
+static int
+VecArith(lua_State* L, VecOp op)
+{
+    LuaVec* a       = ToLuaVec(L, 1);
+    LuaVec* b       = ToLuaVec(L, 2);
+    Vec4    lhs     = { 0 };
+    Vec4    rhs     = { 0 };
+    int32_t a_count = a ? a->m_Count : 0;
+    int32_t b_count = b ? b->m_Count : 0;
+    int32_t count   = MAX(a_count, b_count);
+
+    for (int32_t i = 0; i < 4; i++) {
+        lhs.raw[i] = a ? a->m_V.raw[i] : (float)luaL_checknumber(L, 1);
+        rhs.raw[i] = b ? b->m_V.raw[i] : (float)luaL_checknumber(L, 2);
+    }
+
+    LuaVec* out = NewLuaVec(L, count);
+    for (int32_t i = 0; i < count; i++) {
+        switch (op) {
+            case VEC_ADD: out->m_V.raw[i] = lhs.raw[i] + rhs.raw[i]; break;
+            case VEC_SUB: out->m_V.raw[i] = lhs.raw[i] - rhs.raw[i]; break;
+            case VEC_MUL: out->m_V.raw[i] = lhs.raw[i] * rhs.raw[i]; break;
+            case VEC_DIV: out->m_V.raw[i] = lhs.raw[i] / rhs.raw[i]; break;
+        }
+    }
+    return 1;
+}
+
+static int
+VecAdd(lua_State* L)
+{
+    return VecArith(L, VEC_ADD);
+}
+
+static int
+VecSub(lua_State* L)
+{
+    return VecArith(L, VEC_SUB);
+}
+
+static int
+VecMul(lua_State* L)
+{
+    return VecArith(L, VEC_MUL);
+}
+
+static int
+VecDiv(lua_State* L)
+{
+    return VecArith(L, VEC_DIV);
+}
+
+static int
+VecUnm(lua_State* L)
+{
+    LuaVec* vec = (LuaVec*)luaL_checkudata(L, 1, LUA_VEC_MT);
+    LuaVec* out = NewLuaVec(L, vec->m_Count);
+    for (int32_t i = 0; i < vec->m_Count; i++) {
+        out->m_V.raw[i] = -vec->m_V.raw[i];
+    }
+    return 1;
+}
+
+static int
+VecEq(lua_State* L)
+{
+    LuaVec* a = ToLuaVec(L, 1);
+    LuaVec* b = ToLuaVec(L, 2);
+
+    bool equal = a && b && a->m_Count == b->m_Count;
+    for (int32_t i = 0; equal && i < a->m_Count; i++) {
+        equal = a->m_V.raw[i] == b->m_V.raw[i];
+    }
+    lua_pushboolean(L, equal);
+
+    return 1;
+}
+
+static int
+VecLen(lua_State* L)
+{
+    LuaVec* vec = (LuaVec*)luaL_checkudata(L, 1, LUA_VEC_MT);
+    lua_pushinteger(L, vec->m_Count);
+
+    return 1;
+}
+
+static int
+VecToString(lua_State* L)
+{
+    LuaVec* vec = (LuaVec*)luaL_checkudata(L, 1, LUA_VEC_MT);
+    if (vec->m_Count == 2) {
+        lua_pushfstring(
+          L, "Vec2(%f, %f)", (double)vec->m_V.x, (double)vec->m_V.y);
+    } else {
+        lua_pushfstring(L,
+                        "Vec4(%f, %f, %f, %f)",
+                        (double)vec->m_V.x,
+                        (double)vec->m_V.y,
+                        (double)vec->m_V.z,
+                        (double)vec->m_V.w);
+    }
+    return 1;
+}
+
+static const struct luaL_Reg s_vec_meta[] = {
+    { "__index", VecIndex },   { "__newindex", VecNewIndex },
+    { "__add", VecAdd },       { "__sub", VecSub },
+    { "__mul", VecMul },       { "__div", VecDiv },
+    { "__unm", VecUnm },       { "__eq", VecEq },
+    { "__len", VecLen },       { "__tostring", VecToString },
+    { NULL, NULL },
+};
+
+static void
+RegisterVecMetatable(void)
+{
+    luaL_newmetatable(s_lstate, LUA_VEC_MT);
+    luaL_setfuncs(s_lstate, s_vec_meta, 0);
+    lua_pop(s_lstate, 1);
+}
+
 //------------------------------------------------------------------------------
 
 static void
@@ -300,6 +800,16 @@ parse_table_float(float*         buffer,
                 parse_table_float(
                   buffer, buffer_count, idx, (uint32_t)lua_gettop(s_lstate));
                 break;
+            case LUA_TUSERDATA: {
+                LuaVec* vec = ToLuaVec(s_lstate, -1);
+                for (int32_t i = 0; vec && i < vec->m_Count &&
+                                    *idx < buffer_count;
+                     i++) {
+                    buffer[*idx] = vec->m_V.raw[i];
+                    *idx += 1;
+                }
+                break;
+            }
             default:
                 break;
         }
@@ -310,14 +820,25 @@ parse_table_float(float*         buffer,
 void
 PushFBufferToLua(float fbuff[], int fbuff_sz)
 {
-    lua_newtable(s_lstate);
-    luaL_checkstack(s_lstate, 2, "too many arguments");
+    LuaVec* vec = NewLuaVec(s_lstate, fbuff_sz > 2 ? 4 : 2);
+    for (int32_t i = 0; i < MIN(fbuff_sz, 4); i++) {
+        vec->m_V.raw[i] = fbuff[i];
+    }
+}
 
-    for (uint32_t i = 0; i < fbuff_sz; i++) {
-        lua_pushinteger(s_lstate, i + 1);
-        lua_pushnumber(s_lstate, fbuff[i]);
-        lua_settable(s_lstate, -3);
+void
+PushFBufferToLuaOut(float fbuff[], int fbuff_sz, int out_index)
+{
+    LuaVec* vec = out_index > 0 ? ToLuaVec(s_lstate, out_index) : NULL;
+    if (vec == NULL) {
+        PushFBufferToLua(fbuff, fbuff_sz);
+        return;
+    }
+
+    for (int32_t i = 0; i < MIN(fbuff_sz, vec->m_Count); i++) {
+        vec->m_V.raw[i] = fbuff[i];
     }
+    lua_pushvalue(s_lstate, out_index);
 }
 
 void
@@ -329,6 +850,17 @@ ReadFBufferFromLua(float fbuff[], int fbuff_sz, int index)
     for (int32_t i = index; i <= top; i++) {
         int32_t l_type = lua_type(s_lstate, i);
         switch (l_type) {
+            case LUA_TUSERDATA: {
+                // fast path : no table traversal
+                LuaVec* vec = ToLuaVec(s_lstate, i);
+                for (int32_t j = 0; vec && j < vec->m_Count &&
+                                    curr_idx < fbuff_sz;
+                     j++) {
+                    fbuff[curr_idx] = vec->m_V.raw[j];
+                    curr_idx++;
+                }
+                break;
+            }
             case LUA_TTABLE: {
                 parse_table_float(fbuff, fbuff_sz, &curr_idx, i);
                 break;
@@ -344,3 +876,9 @@ ReadFBufferFromLua(float fbuff[], int fbuff_sz, int index)
     }
     // lua_pop(s_lstate, top); // Pop table
 }
+
+int
+IsVecArg(lua_State* L, int index)
+{
+    return lua_istable(L, index) || ToLuaVec(L, index) != NULL;
+}
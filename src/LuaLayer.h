@@ -20,6 +20,13 @@ extern "C"
 
     void ReloadModule(const char* module_name);
 
+    // Watches dir w/ inotify for changed *.lua scripts
+    int WatchScriptDir(const char* dir);
+
+    // Re-runs changed scripts of loaded modules (call between frames).
+    // Returns how many were reloaded
+    int ReloadChangedModules(void);
+
     int EnterLuaCallback(int global_ref, int func_ref);
 
     int ExitLuaCallback(void);
@@ -43,10 +50,24 @@ extern "C"
         };
     } Vec4;
 
+    // Vectors are pushed as Vec2/Vec4 userdata; tables, vectors and plain
+    // numbers are all accepted when reading
     void PushFBufferToLua(float fbuff[], int fbuff_sz);
 
+    // Writes into the vector at out_index (if it is one) instead of creating
+    // a new one
+    void PushFBufferToLuaOut(float fbuff[], int fbuff_sz, int out_index);
+
     void ReadFBufferFromLua(float fbuff[], int fbuff_sz, int index);
 
+    // A table or a Vec2/Vec4 : an argument ReadFBufferFromLua reads as a
+    // vector
+    int IsVecArg(lua_State* L, int index);
+
+    int LuaNewVec2(lua_State* L);
+
+    int LuaNewVec4(lua_State* L);
+
 #ifdef __cplusplus
 }
 #endif
@@ -7,6 +7,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <time.h>
@@ -24,6 +25,15 @@ GetHighResTime(void)
     return hrTime;
 }
 
+uint64_t
+GetThreadCpuTime(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+
+    return (now.tv_sec * 1000000000L) + now.tv_nsec;
+}
+
 long int
 SecToNano(double seconds)
 {
@@ -70,6 +80,12 @@ static char s_err[1024];
 static int s_frontend_to_gdb[2];
 static int s_gdb_to_frontend[2];
 
+static uint64_t s_bytes_sent;
+static uint64_t s_bytes_received;
+
+static FILE*    s_record;
+static uint64_t s_record_start;
+
 static tlsf_t s_heap;
 static pool_t s_pool;
 
@@ -107,6 +123,52 @@ WmFree(void* ptr)
 
 //-----------------------------------------------------------------------------
 
+// Transcript of the MI session : a header line, then one entry per chunk
+// written to ('>') or read from ('<') gdb,
+//   <dir> <microseconds since the recording started> <byte count>\n<bytes>\n
+// Chunks are kept as they went through the pipes, see MiReplay.c for how
+// they are served back
+static void
+RecordTraffic(char dir, const char* data, uint32_t data_sz)
+{
+    if (s_record == NULL || data_sz == 0) {
+        return;
+    }
+    uint64_t usecs = (GetHighResTime() - s_record_start) / 1000;
+    fprintf(s_record, "%c %" PRIu64 " %u\n", dir, usecs, data_sz);
+    fwrite(data, 1, data_sz, s_record);
+    fputc('\n', s_record);
+}
+
+bool
+StartMiRecording(const char* fname)
+{
+    StopMiRecording();
+
+    // close on exec ("e") : gdb mustn't keep the transcript open
+    s_record = fopen(fname, "wbe");
+    if (s_record == NULL) {
+        return false;
+    }
+    setvbuf(s_record, NULL, _IOFBF, (0x1 << 20)); // 1 megabyte
+    fprintf(s_record, "%s\n", MI_TRANSCRIPT_HEADER);
+    fflush(s_record); // nothing buffered for the gdb child to inherit
+    s_record_start = GetHighResTime();
+
+    return true;
+}
+
+void
+StopMiRecording(void)
+{
+    if (s_record) {
+        fclose(s_record);
+        s_record = NULL;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
 int*
 GetFtoGPipes(void)
 {
@@ -145,7 +207,10 @@ SendCommand(const char* fmt, ...)
 
     // TODO : if the command didn't get sent, maybe retry ?
     int wout = write(s_frontend_to_gdb[1], s_cmd_buff, written);
-    UNUSED_VAR(wout);
+    if (wout > 0) {
+        s_bytes_sent += wout;
+        RecordTraffic('>', s_cmd_buff, wout);
+    }
 
     return true;
 }
@@ -163,6 +228,9 @@ GdbOutput(void)
     double timeout    = 0;
     while (read_bytes && (timeout < 10)) { //(timeout < 0.05)) {
         read_bytes = read(s_gdb_to_frontend[0], buff, sizeof(buff));
+        if (read_bytes > 0) {
+            RecordTraffic('<', buff, read_bytes);
+        }
 
         // gdb sends data
         if (read_bytes > 0 && (msg_sz + read_bytes < sizeof(s_gdb_out))) {
@@ -186,10 +254,49 @@ GdbOutput(void)
         //}
     }
 
+    s_bytes_received += msg_sz;
+
     GdbMsg output = { .m_MsgSz = msg_sz, .m_Msg = s_gdb_out };
     return output;
 }
 
+int32_t
+GdbWrite(const char* data, uint32_t data_sz)
+{
+    int wout = write(s_frontend_to_gdb[1], data, data_sz);
+    if ((wout == -1) && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return 0;
+    }
+    if (wout > 0) {
+        s_bytes_sent += wout;
+        RecordTraffic('>', data, wout);
+    }
+    return wout;
+}
+
+int32_t
+GdbReadAvailable(char* buff, uint32_t buff_sz)
+{
+    int read_bytes = read(s_gdb_to_frontend[0], buff, buff_sz);
+    if ((read_bytes == -1) && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return 0;
+    }
+    if (read_bytes > 0) {
+        s_bytes_received += read_bytes;
+        RecordTraffic('<', buff, read_bytes);
+        return read_bytes;
+    }
+    // end of stream is reported as an error, gdb has closed its output
+    return -1;
+}
+
+void
+GdbTrafficTotals(uint64_t* sent, uint64_t* received)
+{
+    *sent     = s_bytes_sent;
+    *received = s_bytes_received;
+}
+
 //-----------------------------------------------------------------------------
 
 bool
@@ -214,23 +321,77 @@ GetFileInfo(const char* fname, FileInfo* f_info)
 bool
 ReadFile(const char* fname, FileInfo* f_info)
 {
-    if (GetFileInfo(fname, f_info)) {
-        int fd = open(fname, O_RDONLY);
-        if (fd != -1) {
-            memset(f_info->m_Contents, 0, f_info->m_ContentMaxSz);
-            if (!f_info->m_Contents) {
-                close(fd);
-                return false;
+    if (f_info->m_Contents == NULL || f_info->m_ContentMaxSz == 0 ||
+        GetFileInfo(fname, f_info) == false) {
+        return false;
+    }
+
+    int fd = open(fname, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+
+    uint32_t max_sz  = MIN(f_info->m_Sz, f_info->m_ContentMaxSz - 1);
+    uint32_t read_sz = 0;
+    while (read_sz < max_sz) {
+        ssize_t sts = read(fd, f_info->m_Contents + read_sz, max_sz - read_sz);
+        if (sts <= 0) {
+            if (sts == -1 && errno == EINTR) {
+                continue;
             }
+            break;
+        }
+        read_sz += (uint32_t)sts;
+    }
+    f_info->m_Contents[read_sz] = 0;
 
-            // TODO : Handles case where file sz is too large?
+    close(fd);
+    return true;
+}
 
-            int sts = read(fd, f_info->m_Contents, f_info->m_Sz);
-            (void)sts;
+bool
+MapFile(const char* fname, MappedFile* file)
+{
+    file->m_Data = NULL;
+    file->m_Sz   = 0;
 
-            close(fd);
-            return true;
-        }
+    int fd = open(fname, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+
+    struct stat inf = { 0 };
+    if (fstat(fd, &inf) != 0 || S_ISREG(inf.st_mode) == false) {
+        close(fd);
+        return false;
+    }
+
+    // an empty file can't be mapped
+    if (inf.st_size == 0) {
+        close(fd);
+        file->m_Data = "";
+        return true;
+    }
+
+    void* data = mmap(NULL, inf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file open
+
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    madvise(data, inf.st_size, MADV_SEQUENTIAL); // SetText reads it once
+
+    file->m_Data = (const char*)data;
+    file->m_Sz   = (size_t)inf.st_size;
+    return true;
+}
+
+void
+UnmapFile(MappedFile* file)
+{
+    if (file->m_Sz) {
+        munmap((void*)file->m_Data, file->m_Sz);
     }
-    return false;
+    file->m_Data = NULL;
+    file->m_Sz   = 0;
 }
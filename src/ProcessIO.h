@@ -27,6 +27,9 @@ extern "C"
 
     uint64_t GetHighResTime(void);
 
+    // cpu time of the calling thread (nanoseconds)
+    uint64_t GetThreadCpuTime(void);
+
     long int SecToNano(double seconds);
 
     double NanoToSec(uint64_t nanosecs);
@@ -44,6 +47,24 @@ extern "C"
 
     GdbMsg GdbOutput(void);
 
+    // Non-blocking write to gdb. Returns bytes accepted by the pipe (0 when
+    // it is full) or -1 on error
+    int32_t GdbWrite(const char* data, uint32_t data_sz);
+
+    // Non-blocking read of whatever gdb has sent so far. Returns bytes read,
+    // 0 when nothing is available or -1 on error
+    int32_t GdbReadAvailable(char* buff, uint32_t buff_sz);
+
+    // Bytes written to & read from gdb's pipes since startup
+    void GdbTrafficTotals(uint64_t* sent, uint64_t* received);
+
+#define MI_TRANSCRIPT_HEADER "# GdbVkGui MI transcript v1"
+
+    // Everything that goes through gdb's pipes is appended w/ its timing to
+    // fname until StopMiRecording (format in ProcessIO.c)
+    bool StartMiRecording(const char* fname);
+    void StopMiRecording(void);
+
     //-----------------------------------------------------------------------------
 
     typedef struct FileInfo
@@ -60,8 +81,20 @@ extern "C"
 
     bool GetFileInfo(const char* fname, FileInfo* f_info);
 
+    // Reads at most m_ContentMaxSz - 1 bytes & null terminates them
     bool ReadFile(const char* fname, FileInfo* f_info);
 
+    // Read-only view of a whole file, w/o a size limit or a copy. Not null
+    // terminated
+    typedef struct MappedFile
+    {
+        const char* m_Data;
+        size_t      m_Sz;
+    } MappedFile;
+
+    bool MapFile(const char* fname, MappedFile* file);
+    void UnmapFile(MappedFile* file);
+
 #ifdef __cplusplus
 }
 #endif
@@ -4,7 +4,9 @@
 ImGui     = ImGuiLib
 GuiRender = require "GuiRender"
 GdbData   = require "GdbData"
-local Json = require "Json"
+local Session = require "Session"
+local Benchmarks = require "Benchmarks"
+local BenchScenario = require "BenchScenario"
 
 GdbApp = {
 	exe_filename = "",
@@ -17,6 +19,12 @@ GdbApp = {
 	bktrace = {},
 	registers = nil,
 	memory = {},
+	search = { pattern = "", root = "", regex = false, ignore_case = false,
+		hits = {}, busy = false },
+	finder = { query = "", last_query = nil, results = {}, open = false },
+	hover = { expr = nil, since = 0, gen = 0, pending = false, cache = {} },
+
+	stop_gen = 0, -- bumped by every command that can change the inferior
 
 	curr_stack_frame = 1,
 
@@ -35,34 +43,27 @@ print("Starting GdbApp")
 function GdbApp:Init(args)
 	-- Increase aggressiveness GC (wait for memory to grow to 1.5x then collect)
 	collectgarbage("setpause", 150)
+
+	Session.Open(ROOT_DIR.."session", ROOT_DIR.."last_session")
+
+	if BENCH_SCRIPT then BenchScenario.Start(BENCH_SCRIPT, BENCH_OUT) end
 end
 
 function GdbApp:OnExit(args)
-	local session = Json:encode_pretty(self.user_args)
-
-	local out_file = ROOT_DIR.."session.json"
-	local file = io.open(out_file, "w")
-	if file then
-		file:write(session)
-		file:close()
-	end
+	-- everything is already in the journal, just write out the last frame
+	Session.Close(self)
 end
 
 function GdbApp:Update(args)
+	BenchScenario.Update(self)
+
 	if ImGui.BeginMainMenuBar() then
 		if ImGui.BeginMenu("File") then
 			if ImGui.MenuItem("Load Last Session", false) then
-				local in_file = ROOT_DIR.."session.json"
-				local file = io.open(in_file, "r")
-				if file then
-					local file_contents = {}
-					for line in file:lines() do
-						file_contents[#file_contents + 1] = line
-					end
-
-					file:close()
-					
-					self.user_args = Json:decode(table.concat(file_contents, "\n"))
+				local session = Session.LoadLast()
+				if session then
+					self.user_args = session
+					Session.Reset(self)
 					if self.user_args.ExeStart and self.user_args.ExeStart.exe then
 						GdbData.LoadExe(self)
 					end
@@ -92,8 +93,28 @@ function GdbApp:Update(args)
 			ImGui.Separator()
 			ImGui.EndMenu()
 		end
+		if ImGui.BeginMenu("Debug") then
+			if ImGui.MenuItem("Run Benchmarks", false) then
+				Benchmarks.Start()
+			end
+			if ImGui.MenuItem("Lua Profiler", LuaProfiler.Running()) then
+				if LuaProfiler.Running() then
+					LuaProfiler.Stop()
+				else
+					LuaProfiler.Start()
+				end
+			end
+			if ImGui.MenuItem("Export Lua Profile", false, LuaProfiler.Running()) then
+				LuaProfiler.Export()
+			end
+			ImGui.EndMenu()
+		end
 		ImGui.EndMainMenuBar()
 	end
 
 	GuiRender.Present(GdbApp, args.win_width, args.win_height)
+
+	Benchmarks.Present()
+
+	Session.Flush(self)
 end
@@ -0,0 +1,254 @@
+-- End-to-end benchmark driven by a JSON scenario (--bench FILE). The ops run
+-- against the live gdb & ui one after another, as a user would click through
+-- them, and a JSON report is written to --bench-out once they are done :
+-- frame cpu time percentiles, per step latency (from the click to the
+-- refreshed panels) and MI bytes per step.
+--
+-- Scenario :
+--   { "name": "...", "exe": "sample", "args": "",   (exe relative to the file)
+--     "ops": [ { "op": "load" },
+--              { "op": "break", "file": "sample.c", "lines": [ 40, 60 ],
+--                "count": 50 },                (lines cycled over the range)
+--              { "op": "run" },
+--              { "op": "step", "button": "Next", "count": 100 },
+--              { "op": "locals" },             (fetch the type of each local)
+--              { "op": "memory", "address": "&grid", "bytes": 256 },
+--              { "op": "idle", "frames": 60 } ] }
+
+local Json = require "Json"
+
+local BenchScenario = {
+	active = false,
+	out = nil,
+	scenario = nil,
+	dir = "",
+
+	op_idx = 0,
+	op_state = nil,
+
+	frame_ms = {},
+	step_ms = {},
+	step_bytes = {},
+	ops = {},
+}
+
+local MAX_WAIT_FRAMES = 6000 -- a step that never settles fails the run
+
+local function Traffic()
+	local sent, received = GdbTraffic()
+	return sent + received
+end
+
+local function Percentiles(samples)
+	local sorted = { table.unpack(samples) }
+	table.sort(sorted)
+
+	local function At(p)
+		if #sorted == 0 then return 0 end
+		return sorted[math.max(1, math.ceil(#sorted * p))]
+	end
+
+	local sum = 0
+	for _, v in ipairs(sorted) do sum = sum + v end
+
+	return {
+		count = #sorted,
+		mean = #sorted > 0 and sum / #sorted or 0,
+		p50 = At(0.5), p90 = At(0.9), p99 = At(0.99),
+		max = sorted[#sorted] or 0,
+	}
+end
+
+local function Settled(data)
+	return not data.refreshing and not data.refresh_queued
+end
+
+--------------------------------------------------------------------------------
+-- Op handlers are called once per frame w/ their state table until they
+-- return true
+
+local Ops = {}
+
+function Ops.load(data, op, state)
+	local exe = BenchScenario.scenario.exe
+	if exe:sub(1, 1) ~= "/" then exe = BenchScenario.dir..exe end
+
+	data.user_args.ExeStart = { exe = exe, args = BenchScenario.scenario.args or "" }
+	GdbData.LoadExe(data)
+	return true
+end
+
+Ops["break"] = function(data, op, state)
+	if state.started == nil then
+		local file = op.file
+		if file:sub(1, 1) ~= "/" then file = BenchScenario.dir..file end
+
+		local first, last = op.lines[1], op.lines[2] or op.lines[1]
+		local breaks = {}
+		for i = 1, op.count or 1 do
+			-- shaped like a -break-list entry, as a saved session would be
+			breaks[i] = {
+				number = tostring(i), enabled = "y", times = "0", cond = "",
+				file = op.file, fullname = file, disp = "keep",
+				line = tostring(first + (i - 1) % (last - first + 1)),
+			}
+		end
+		data.user_args.Breaks = breaks
+		GdbData.LoadSettings(data)
+		state.started = true
+	end
+	return data.restore.finished
+end
+
+function Ops.run(data, op, state)
+	if state.started == nil then
+		data.press = "Start/Run"
+		state.started = true
+		return false
+	end
+	return true
+end
+
+function Ops.step(data, op, state)
+	state.done = state.done or 0
+	if state.pressed then
+		if not Settled(data) then return false end
+
+		local bench = BenchScenario
+		bench.step_ms[#bench.step_ms + 1] = (GetTime() - state.step_t0) * 1000
+		bench.step_bytes[#bench.step_bytes + 1] = Traffic() - state.step_bytes0
+		state.pressed = false
+		state.done = state.done + 1
+	end
+	if state.done >= (op.count or 1) then return true end
+
+	data.press = op.button or "Next"
+	state.pressed = true
+	state.step_t0, state.step_bytes0 = GetTime(), Traffic()
+	return false
+end
+
+function Ops.locals(data, op, state)
+	data.user_args.FetchTypes = true
+	GdbData.GetVCard(data.local_vars)
+	return true
+end
+
+function Ops.memory(data, op, state)
+	if state.started == nil then
+		data.user_args.Memory = {
+			{ id = "address", val = op.address or "&main" },
+			{ id = "bytes", val = tostring(op.bytes or 100) },
+		}
+		data.user_args.MemView = data.user_args.MemView or {}
+		data.user_args.MemView.active = true
+
+		-- the tracked view reads it as it's drawn, UpdateMemory puts a new
+		-- table in data.memory once the reply is in
+		state.memory0 = data.memory
+		state.started = true
+		return false
+	end
+	return data.memory ~= state.memory0
+end
+
+function Ops.idle(data, op, state)
+	return state.waited >= (op.frames or 1)
+end
+
+--------------------------------------------------------------------------------
+
+local function Report()
+	local bench = BenchScenario
+	local report = {
+		scenario = bench.scenario.name or BENCH_SCRIPT,
+		frames = #bench.frame_ms,
+		frame_cpu_ms = Percentiles(bench.frame_ms),
+		steps = {
+			latency_ms = Percentiles(bench.step_ms),
+			mi_bytes = Percentiles(bench.step_bytes),
+		},
+		ops = bench.ops,
+	}
+
+	local ok, err = Json:encode_to_file(report, bench.out, true)
+	if ok then
+		print("[bench] report written to "..bench.out)
+	else
+		print("[bench] failed to write report : "..tostring(err))
+	end
+end
+
+local function Fail(msg)
+	print("[bench] "..msg)
+	BenchScenario.active = false
+	ExitApp()
+end
+
+function BenchScenario.Start(script, out)
+	local ok, scenario = pcall(Json.decode_file, Json, script)
+	if not ok or type(scenario) ~= "table" or type(scenario.ops) ~= "table" then
+		Fail("failed to load scenario "..script.." : "..tostring(scenario))
+		return
+	end
+
+	BenchScenario.scenario = scenario
+	BenchScenario.out = out
+	BenchScenario.dir = script:match("^(.*/)") or ""
+	BenchScenario.active = true
+	BenchScenario.op_idx = 0
+	BenchScenario.op_state = nil
+end
+
+-- Called at the start of every frame, before the ui is drawn
+function BenchScenario.Update(data)
+	local bench = BenchScenario
+	if not bench.active then return end
+
+	-- the stats are for the previous frame
+	if bench.op_idx > 0 then
+		bench.frame_ms[#bench.frame_ms + 1] = GetFrameStats().cpu_ms
+	end
+
+	local state = bench.op_state
+	if state == nil then
+		bench.op_idx = bench.op_idx + 1
+		local op = bench.scenario.ops[bench.op_idx]
+		if op == nil then
+			Report()
+			bench.active = false
+			ExitApp()
+			return
+		end
+		if Ops[op.op] == nil then
+			Fail("unknown op "..tostring(op.op))
+			return
+		end
+
+		state = { op = op, t0 = GetTime(), bytes0 = Traffic(), waited = 0 }
+		bench.op_state = state
+	end
+
+	state.waited = state.waited + 1
+	if state.waited > MAX_WAIT_FRAMES then
+		Fail(string.format("op %d (%s) did not finish", bench.op_idx, state.op.op))
+		return
+	end
+
+	if Ops[state.op.op](data, state.op, state) then
+		bench.ops[#bench.ops + 1] = {
+			op = state.op.op,
+			ms = (GetTime() - state.t0) * 1000,
+			frames = state.waited,
+			mi_bytes = Traffic() - state.bytes0,
+		}
+		print(string.format("[bench] %-8s %10.2f ms %6d frames %10d MI bytes",
+			state.op.op, bench.ops[#bench.ops].ms, state.waited,
+			bench.ops[#bench.ops].mi_bytes))
+		bench.op_state = nil
+	end
+end
+
+package.loaded["BenchScenario"] = BenchScenario
+
+return BenchScenario
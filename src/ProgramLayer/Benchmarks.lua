@@ -0,0 +1,222 @@
+-- Microbenchmarks for the lua -> imgui bridge. Each case is measured inside the
+-- "Benchmarks" window over a number of frames. Results (cpu time and lua
+-- allocations per frame) are printed and listed in the same window.
+-- Cases with a "run" function instead of "ui" don't draw anything & can
+-- override the number of frames. "setup" runs untimed before the first frame.
+
+local Json = require "Json"
+local JsonLua = require "JsonLua"
+
+local Benchmarks = {
+	open = false,
+	rows = 2000,
+	frames = 120,
+
+	queue = {},
+	active = nil,
+	results = {},
+}
+
+local area_sz    = ImGuiLib.Vec2(0, 200)
+local results_sz = ImGuiLib.Vec2(0, 150)
+
+local result_clmns = {
+	{ "case", key = "name" },
+	{ "ms/frame", key = "ms" },
+	{ "KB alloc/frame", key = "kb" },
+}
+
+-- A session like the one saved on exit, with rows breakpoints & watches
+local bench_session = nil
+local bench_session_txt = nil
+local function BenchSession(rows)
+	if bench_session == nil or #bench_session.Breaks ~= rows then
+		local breaks, watch = {}, {}
+		for i = 1, rows do
+			breaks[i] = {
+				number = tostring(i), btype = "breakpoint", disp = "keep",
+				enabled = "y", addr = string.format("0x%016x", 0x401000 + i * 16),
+				func = "Function"..i, file = "file"..(i % 50)..".c",
+				fullname = "/home/user/project/src/file"..(i % 50)..".c",
+				line = tostring(i), thread_g = { "i1" }, times = "0",
+				org_loc = "/home/user/project/src/file"..(i % 50)..".c:"..i,
+				cond = i % 10 == 0 and "count > "..i or "",
+			}
+			watch[i] = { expr = "data->items["..i.."].name", value = "\"item\t"..i.."\"" }
+		end
+		bench_session = {
+			ExeStart = { exe = "/home/user/project/bin/app", args = "--verbose" },
+			FetchTypes = true,
+			MemView = { addr = "0x7fffffffe000", sz = 256 },
+			Breaks = breaks,
+			Watch = watch,
+		}
+		bench_session_txt = Json:encode_pretty(bench_session)
+	end
+	return bench_session, bench_session_txt
+end
+
+Benchmarks.cases = {
+	{ name = "ids : label concat",
+	  ui = function(rows)
+		for i = 1, rows do
+			ImGui.CheckBox("##bkpt_flag"..i, false)
+			ImGui.SameLine()
+			ImGui.InputText("##watche"..i, "expr")
+			ImGui.SameLine()
+			ImGui.Button("Delete##brk_pt"..i)
+		end
+	  end,
+	},
+	{ name = "ids : PushID per row",
+	  ui = function(rows)
+		for i = 1, rows do
+			ImGui.PushID(i)
+			ImGui.CheckBox("##bkpt_flag", false)
+			ImGui.SameLine()
+			ImGui.InputText("##watche", "expr")
+			ImGui.SameLine()
+			ImGui.Button("Delete")
+			ImGui.PopID()
+		end
+	  end,
+	},
+	{ name = "ids : integer id overloads",
+	  ui = function(rows)
+		for i = 1, rows do
+			ImGui.CheckBox(i, false)
+			ImGui.SameLine()
+			ImGui.InputText(i + rows, "expr")
+			ImGui.SameLine()
+			ImGui.Button(i + rows * 2, "Delete")
+		end
+	  end,
+	},
+	{ name = "vectors : table literals",
+	  ui = function(rows)
+		for i = 1, rows do
+			ImGui.TextColored({ 1.0, 1, 1, 0.5 }, "text")
+			ImGui.SameLine()
+			ImGui.Button("Go", { 30, 0 })
+			ImGui.GetItemRectSize()
+		end
+	  end,
+	},
+	{ name = "vectors : Vec userdata",
+	  ui = function(rows)
+		local col, sz, out = ImGui.Vec4(1.0, 1, 1, 0.5), ImGui.Vec2(30, 0), ImGui.Vec2()
+		for i = 1, rows do
+			ImGui.TextColored(col, "text")
+			ImGui.SameLine()
+			ImGui.Button("Go", sz)
+			ImGui.GetItemRectSize(out)
+		end
+	  end,
+	},
+	{ name = "session : JSON.lua encode_pretty", frames = 10, setup = BenchSession,
+	  run = function(rows)
+		JsonLua:encode_pretty(BenchSession(rows))
+	  end,
+	},
+	{ name = "session : native encode_pretty", frames = 10, setup = BenchSession,
+	  run = function(rows)
+		Json:encode_pretty(BenchSession(rows))
+	  end,
+	},
+	{ name = "session : JSON.lua decode", frames = 10, setup = BenchSession,
+	  run = function(rows)
+		local _, txt = BenchSession(rows)
+		JsonLua:decode(txt)
+	  end,
+	},
+	{ name = "session : native decode", frames = 10, setup = BenchSession,
+	  run = function(rows)
+		local _, txt = BenchSession(rows)
+		Json:decode(txt)
+	  end,
+	},
+}
+
+function Benchmarks.Start(case_idx)
+	Benchmarks.queue = {}
+	for i, case in ipairs(Benchmarks.cases) do
+		if case_idx == nil or case_idx == i then
+			Benchmarks.queue[#Benchmarks.queue + 1] = case
+		end
+	end
+	Benchmarks.active = nil
+	Benchmarks.open = true
+end
+
+local function Finish(run)
+	local res = {
+		name = run.case.name,
+		ms = string.format("%.3f", run.time * 1000 / run.frames),
+		kb = string.format("%.2f", run.alloc / run.frames),
+	}
+	print(string.format("[bench] %-32s %10s ms/frame %10s KB/frame",
+		res.name, res.ms, res.kb))
+
+	Benchmarks.results[#Benchmarks.results + 1] = res
+end
+
+-- Measures one frame of the active case (gc is paused so the allocation
+-- count is exact)
+local function Step()
+	local run = Benchmarks.active
+	if run == nil then
+		local case = table.remove(Benchmarks.queue, 1)
+		if case == nil then return end
+
+		run = { case = case, frames = 0, time = 0, alloc = 0 }
+		Benchmarks.active = run
+		if case.setup then case.setup(Benchmarks.rows) end
+	end
+
+	ImGui.BeginChild("##bench_area", area_sz)
+
+	collectgarbage("stop")
+	local mem = collectgarbage("count")
+	local t = os.clock()
+
+	if run.case.ui then
+		run.case.ui(Benchmarks.rows)
+	else
+		run.case.run(Benchmarks.rows)
+	end
+
+	run.time = run.time + os.clock() - t
+	run.alloc = run.alloc + collectgarbage("count") - mem
+	collectgarbage("restart")
+
+	ImGui.EndChild()
+
+	run.frames = run.frames + 1
+	if run.frames >= (run.case.frames or Benchmarks.frames) then
+		Finish(run)
+		Benchmarks.active = nil
+	end
+end
+
+function Benchmarks.Present()
+	if Benchmarks.open == false then return end
+
+	ImGui.Begin("Benchmarks")
+
+	if ImGui.Button("Run all") then Benchmarks.Start() end
+	ImGui.SameLine()
+	if ImGui.Button("Clear") then Benchmarks.results = {} end
+	ImGui.SameLine()
+	if ImGui.Button("Close") then Benchmarks.open = false end
+
+	ImGui.DrawTable("##bench_results", result_clmns, Benchmarks.results, {
+		size = results_sz })
+
+	Step()
+
+	ImGui.End()
+end
+
+package.loaded["Benchmarks"] = Benchmarks
+
+return Benchmarks
@@ -1,11 +1,50 @@
 -- Module that communicates w/ Gdb
 
 local Json = require "Json"
+local Session = require "Session"
 
 local GdbData = {}
 
 local ExecuteCmd = function(cmd) if SendToGdb(cmd) then return ReadFromGdb() end end
 
+-- Sends an MI command from inside a task started w/ GdbTask and suspends the
+-- task until gdb replies. Returns the reply text
+function GdbData.Await(cmd)
+	local _, is_main = coroutine.running()
+	assert(not is_main, "GdbData.Await must be called from a GdbTask")
+
+	return coroutine.yield(SendToGdbAsync(cmd))
+end
+
+-- Same as Await, but the reply is parsed on the MI parser thread and the task
+-- receives a read-only GdbMi view of the result record (nil if unparsable)
+function GdbData.AwaitParsed(cmd)
+	local _, is_main = coroutine.running()
+	assert(not is_main, "GdbData.AwaitParsed must be called from a GdbTask")
+
+	return coroutine.yield(SendToGdbAsync(cmd, true))
+end
+
+-- Pipelines cmds : they are all sent at once, then the replies are collected
+-- in order. on_reply(i, reply) is called as each one arrives. Returns the
+-- replies
+function GdbData.AwaitAll(cmds, on_reply)
+	local _, is_main = coroutine.running()
+	assert(not is_main, "GdbData.AwaitAll must be called from a GdbTask")
+
+	local tokens = {}
+	for i, cmd in ipairs(cmds) do
+		tokens[i] = SendToGdbAsync(cmd)
+	end
+
+	local replies = {}
+	for i, token in ipairs(tokens) do
+		replies[i] = coroutine.yield(token)
+		if on_reply then on_reply(i, replies[i]) end
+	end
+	return replies
+end
+
 -- TODO : maybe create parser function to load() that appends '_' to lua lang keywords
 
 function GdbData.LoadExe(data)
@@ -16,35 +55,95 @@ function GdbData.LoadExe(data)
 	end
 
 	ExecuteCmd("-break-insert -t main")
+
+	GdbData.IndexExe(data)
 end
 
-function GdbData.LoadSettings(data)
-	if data.user_args.Breaks then
-		for _, brk_pt in ipairs(data.user_args.Breaks) do
-			ExecuteCmd(string.format("-break-insert%s --source %s --line %s",
-				brk_pt.disp == "del" and " -t" or "",
-				brk_pt.fullname,
-				brk_pt.line
-			))
+-- Fills the Ctrl-P finder's index w/o blocking the ui, unless the one saved
+-- for this binary (see FuzzyFinder.Open) could be loaded
+function GdbData.IndexExe(data)
+	data.finder.index_id = (data.finder.index_id or 0) + 1
+	if FuzzyFinder.Open(data.user_args.ExeStart.exe) then return end
+
+	local index_id = data.finder.index_id
+	GdbTask(function()
+		local files = GdbData.Await("-file-list-exec-source-files")
+		local funcs = GdbData.Await("-symbol-info-functions")
+
+		-- a binary loaded since then has its own index
+		if index_id ~= data.finder.index_id then return end
+
+		FuzzyFinder.Add(files)
+		FuzzyFinder.Add(funcs)
+		-- not saved when a list is missing (no -symbol-info-functions before
+		-- gdb 10), the next load asks again
+		if files:find("%^done") and funcs:find("%^done") then
+			FuzzyFinder.Commit()
 		end
+	end)
+end
+
+local function RestoreTask(data, breaks)
+	local restore = data.restore
+
+	local cmds = {}
+	for i, brk_pt in ipairs(breaks) do
+		cmds[i] = string.format("-break-insert%s --source %s --line %s",
+			brk_pt.disp == "del" and " -t" or "",
+			brk_pt.fullname,
+			brk_pt.line
+		)
 	end
+
+	GdbData.AwaitAll(cmds, function(i, reply)
+		restore.done = i
+		if reply:find("%^error") == nil then return end
+
+		local _, _, msg = reply:find("%^error,msg=\"(.*)\"")
+		restore.failed[#restore.failed + 1] = {
+			file = breaks[i].file or breaks[i].fullname,
+			line = breaks[i].line,
+			msg = msg and msg:gsub("\\(.)", "%1") or "error",
+		}
+	end)
+
+	GdbData.ParseBreakpoints(data, GdbData.Await("-break-list"))
+	restore.finished = true
+end
+
+-- Re-inserts the session's breakpoints w/o blocking the ui : the inserts are
+-- pipelined in a GdbTask and data.restore tracks progress & failures
+function GdbData.LoadSettings(data)
 	if data.user_args.Watch then
 		for i, watch_data in ipairs(data.user_args.Watch) do
 			watch_data.value = ""
 		end
 	end
-	GdbData.ParseBreakpoints(data, ExecuteCmd("-break-list"))
+
+	local breaks = data.user_args.Breaks or {}
+	data.restore = { total = #breaks, done = 0, failed = {}, finished = false }
+
+	GdbTask(function()
+		local ok, err = pcall(RestoreTask, data, breaks)
+		if not ok then
+			data.restore.failed[#data.restore.failed + 1] = { msg = tostring(err) }
+			data.restore.finished = true
+		end
+	end)
 end
 
 function GdbData.ShowBreaks(data)
 	if data.user_args.Breaks then
-		local markers = {}
-		for _, brk_pt in ipairs(data.user_args.Breaks) do
-			if data.open_file.full == brk_pt.fullname and brk_pt.line then
-				markers[#markers + 1] = tonumber(brk_pt.line)
+		-- every file open in a tab
+		for _, file in ipairs(GetEditorFiles()) do
+			local markers = {}
+			for _, brk_pt in ipairs(data.user_args.Breaks) do
+				if file == brk_pt.fullname and brk_pt.line then
+					markers[#markers + 1] = tonumber(brk_pt.line)
+				end
 			end
+			SetEditorBkPts(#markers, markers, file)
 		end
-		SetEditorBkPts(#markers, markers)
 	end
 end
 
@@ -67,6 +166,44 @@ function GdbData.UpdateFile(data, title, file, line, column, func)
 		end
 	end
 	data.open_file.func = func
+	data.open_file.line = tonumber(line)
+end
+
+-- First line of the function gdb stopped in, from the finder's index. Lines
+-- a bit above the stop are used while it's not built
+local function FuncFirstLine(data)
+	local file = data.open_file
+	local func = file.func or ""
+	if func ~= "" then
+		local best
+		for _, entry in ipairs(FuzzyFinder.Query(func, 20)) do
+			local name = entry.name
+			if entry.kind == "function" and entry.file == file.full
+				and entry.line <= file.line
+				and (name == func or name:sub(1, #func + 1) == func.."(")
+				and (best == nil or entry.line > best) then
+				best = entry.line
+			end
+		end
+		if best then return best end
+	end
+	return math.max(1, file.line - 30)
+end
+
+-- The current frame's locals, drawn after the lines that use them from the
+-- start of the function down to where it stopped
+function GdbData.ShowInlineValues(data)
+	local file = data.open_file
+	if not file.is_open or file.line == nil then
+		SetEditorInlineValues()
+		return
+	end
+
+	local values = {}
+	for _, var in ipairs(data.local_vars) do
+		if var.name and var.value then values[var.name] = var.value end
+	end
+	SetEditorInlineValues(file.full, FuncFirstLine(data), file.line, values)
 end
 
 function GdbData.Next(data, input)
@@ -108,6 +245,7 @@ function GdbData.ParseBreakpoints(data, input)
 				--print(match)
 			end
 		end
+		Session.Set(data, "Breaks")
 	end
 	GdbData.ShowBreaks(data)
 end
@@ -152,6 +290,58 @@ function GdbData.UpdateWatchExpr(data, input)
 	return watch_val and watch_val or ""
 end
 
+-- Hover evaluate : an expression is sent to gdb once the mouse has rested on
+-- it for HOVER_DELAY s, one request at a time. Replies are kept per
+-- (expression, frame) until the next command that can change the inferior
+-- (data.stop_gen), a reply for an expression no longer hovered only goes to
+-- the cache & one from before that command is dropped
+local HOVER_DELAY = 0.35
+local HOVER_CHARS = 512
+
+local function HoverTask(data, key, expr)
+	local hover = data.hover
+	local gen = hover.gen
+	local ok, reply = pcall(GdbData.AwaitParsed,
+		"-data-evaluate-expression \""..expr.."\"")
+	hover.pending = false
+	if not ok then error(reply) end
+	if gen ~= hover.gen or reply == nil then return end
+
+	local value = reply.value
+	if value then
+		if #value > HOVER_CHARS then
+			value = value:sub(1, HOVER_CHARS - 3).."..."
+		end
+		hover.cache[key] = value
+	elseif not tostring(reply.msg):find("running") then
+		-- no such symbol here, not asked again for this stop
+		hover.cache[key] = false
+	end
+end
+
+-- Value to show for the hovered expression (nil : none), once it's known
+function GdbData.HoverValue(data, expr)
+	local hover = data.hover
+	if hover.gen ~= data.stop_gen then
+		hover.gen, hover.cache = data.stop_gen, {}
+	end
+	if expr ~= hover.expr then
+		-- a request not sent yet is dropped w/ the old expression
+		hover.expr, hover.since = expr, GetTime()
+	end
+	if expr == nil then return nil end
+
+	local key = data.curr_stack_frame.." "..expr
+	local value = hover.cache[key]
+	if value ~= nil then return value or nil end
+
+	if not hover.pending and GetTime() - hover.since >= HOVER_DELAY then
+		hover.pending = true
+		GdbTask(HoverTask, data, key, expr)
+	end
+	return nil
+end
+
 function GdbData.UpdateMemory(data, input)
 -- memory=[{begin="0x0000555555648981",offset="0x0000000000000000",end="0x000055555564898b",contents="f30f1efa554889e55348"}]
 
@@ -197,6 +387,40 @@ function GdbData.UpdateBacktrace(data, input)
 	end
 end
 
+function GdbData.UpdateAsmMi(data, reply)
+	local asm_sns = reply and reply.asm_insns
+	if asm_sns then
+		data.asm = GdbMi.ToTable(asm_sns)
+		for _, inst in ipairs(data.asm) do
+			inst.func = inst["func-name"]
+		end
+	end
+end
+
+function GdbData.UpdateBacktraceMi(data, reply)
+	local stack = reply and reply.stack
+	if stack then
+		data.bktrace = GdbMi.ToTable(stack)
+	end
+end
+
+-- Full paths of the inferior's sources (-file-list-exec-source-files), once
+-- each
+function GdbData.ExecSourceFiles(input)
+	local files, seen = {}, {}
+	local reply = type(input) == "string" and GdbMi.Parse(input)
+	local list = reply and reply.files
+	if list then
+		for _, src in ipairs(GdbMi.ToTable(list)) do
+			if src.fullname and not seen[src.fullname] then
+				seen[src.fullname] = true
+				files[#files + 1] = src.fullname
+			end
+		end
+	end
+	return files
+end
+
 function GdbData.GetTrackedRegisters(data)
 	-- currently hardcode most used
 	-- TODO : allow naming/modifying list
@@ -218,6 +442,16 @@ function GdbData.GetTrackedRegisters(data)
 		ebp = { number = -1, id = "ebp", value = "" },
 		esp = { number = -1, id = "esp", value = "" },
 	}
+
+	-- display order for the register table
+	local order = { 
+		"rax", "rbx", "rcx", "rdx", "rsi", "rdi", "rbp", "rsp",
+		"eax", "ebx", "ecx", "edx", "esi", "edi", "ebp", "esp",
+	}
+	data.register_list = {}
+	for i, name in ipairs(order) do
+		data.register_list[i] = data.registers[name]
+	end
 end
 
 function GdbData.SetupRegisterDataCmd(data, cmd_data)
@@ -267,6 +501,20 @@ function GdbData.UpdateRegisters(data, input)
 	end
 end
 
+function GdbData.UpdateRegistersMi(data, reply)
+	local regv = reply and reply["register-values"]
+	if regv and data.registers then
+		local by_number = {}
+		for i = 1, #regv do
+			local regv_i = regv[i]
+			by_number[tonumber(regv_i.number)] = regv_i.value
+		end
+		for _, reg in pairs(data.registers) do
+			reg.value = by_number[reg.number] or reg.value
+		end
+	end
+end
+
 function GdbData.GetVCard(local_vars)
 	for _, var in ipairs(local_vars) do
 		if SendToGdb("whatis "..var.name) then
@@ -299,9 +547,29 @@ function GdbData.UpdateLocals(data, input)
 		--data.local_vars_txt = Json:encode_pretty(new_data.locals)
 
 		if data.user_args.FetchTypes then GdbData.GetVCard(data.local_vars) end
+		GdbData.ShowInlineValues(data)
 	end
 end
 
+function GdbData.UpdateLocalsMi(data, reply)
+	local locals = reply and reply.locals
+	if locals == nil then return end
+
+	data.local_vars = {}
+	for i = 1, #locals do
+		local var = locals[i]
+		local value = var.value or ""
+		if value:find("^{") then
+			-- sanitize long junk strings
+			value = value:gsub("\", [\\'%d]* <[%w%s]*>, \"", "")
+		end
+		data.local_vars[i] = { name = var.name, value = value, vtype = "" }
+	end
+
+	if data.user_args.FetchTypes then GdbData.GetVCard(data.local_vars) end
+	GdbData.ShowInlineValues(data)
+end
+
 function GdbData.ParseDataInput(data, cmd_data)
 	local complete_cmd = {}
 
@@ -1,7 +1,150 @@
 -- Gui render module
 
+local Session = require "Session"
+
 local GuiRender = {}
 
+-- column layouts for ImGui.DrawTable (rows are read by key, only when visible)
+local header_col = ImGuiLib.Vec4(1.0, 1, 1, 0.5)
+local error_col  = ImGuiLib.Vec4(1.0, 0.4, 0.4, 1)
+
+-- reused every frame (filled in place by the imgui getters)
+local win_sz    = ImGuiLib.Vec2()
+local dlg_sz    = ImGuiLib.Vec2()
+local finder_sz = ImGuiLib.Vec2()
+local mem_v  = ImGuiLib.Vec2()
+
+local bktrace_clmns = {
+	{ "address", key = "addr" },
+	{ "function", key = "func" },
+	{ "line", key = "line" },
+	{ "file", key = "file" },
+}
+
+local locals_clmns = {
+	{ "name", key = "name" },
+	{ "type", key = "vtype" },
+	{ "data", key = "value", input = true, width = 400 },
+}
+
+local asm_clmns = {
+	{ "address", key = "address" },
+	{ "offset", key = "offset" },
+	{ "instruction", key = "inst" },
+	{ "function", key = "func" },
+}
+
+local register_clmns = {
+	{ "name", key = "id" },
+	{ "data", key = "value", input = true, width = 250 },
+}
+
+local finder_clmns = {
+	{ "name", key = "name" },
+	{ "kind", key = "kind" },
+	{ "file", key = "short" },
+	{ "line", key = "line" },
+}
+
+local search_clmns = {
+	{ "file", key = "short" },
+	{ "line", key = "line" },
+	{ "text", key = "text" },
+}
+
+-- Rebuilds the memory view rows only when the contents or layout change
+local function GetMemoryRows(memory, mem_settings)
+	local cache = memory.view
+	if cache and cache.bPerColumn == mem_settings.bPerColumn 
+		and cache.nColumns == mem_settings.nColumns then
+		return cache.clmns, cache.rows
+	end
+
+	local clmns = { { "", color = header_col }, "address" }
+	for i = 1, mem_settings.nColumns, 1 do
+		clmns[#clmns + 1] = " "..(i - 1).." "
+	end
+
+	local rows = {}
+	if memory.contents then
+		local total_digits = memory.contents:len()
+		local max_rows = math.ceil(
+			total_digits / (mem_settings.bPerColumn * mem_settings.nColumns))
+
+		local h_cntr = 1
+		for irow = 1, max_rows, 1 do
+			local row = { tostring(irow - 1) }
+			if irow == 1 then row[2] = memory.begin end
+
+			-- write backwards because of big endian formatting
+			for iclmn = mem_settings.nColumns, 1, -1 do
+				local out_hex = { "0x" }
+				for ihex = mem_settings.bPerColumn, 1, -1 do
+					if total_digits >= h_cntr then
+						out_hex[ihex + 1] = memory.contents:sub(h_cntr, h_cntr)
+					else
+						out_hex[ihex + 1] = "0"
+					end
+
+					h_cntr = h_cntr + 1
+				end
+				row[iclmn + 2] = table.concat(out_hex)
+			end
+			rows[#rows + 1] = row
+		end
+		rows[#rows + 1] = { [2] = memory.last }
+	end
+
+	memory.view = { 
+		bPerColumn = mem_settings.bPerColumn,
+		nColumns = mem_settings.nColumns,
+		clmns = clmns,
+		rows = rows
+	}
+	return clmns, rows
+end
+
+-- Re-runs the auto updating commands & watch expressions as a GdbTask so the
+-- frame never waits on gdb. Requests made while it is running are coalesced
+-- into one more pass. Commands w/ a parse_mi handler get their reply decoded
+-- on the parser thread
+local function RefreshViews(data, buttons)
+	local Await, AwaitParsed = GdbData.Await, GdbData.AwaitParsed
+
+	while data.refresh_queued do
+		data.refresh_queued = false
+
+		for _, val in ipairs(buttons) do
+			if val.auto_upd then
+				local cmd = val.mod_args and
+					table.concat(val.mod_args(data, val), "") or table.concat(val.args, "")
+
+				if val.parse_mi then
+					val.parse_mi(data, AwaitParsed(cmd))
+				else
+					val.parse(data, Await(cmd))
+				end
+			end
+		end
+
+		-- watch window
+		for i, watch_data in ipairs(data.user_args.Watch) do
+			if watch_data.expr ~= "" then
+				local val = GdbData.UpdateWatchExpr(
+					data, Await("-data-evaluate-expression "..watch_data.expr))
+				watch_data.value = val == "" and watch_data.value or val
+			end
+		end
+		GdbData.ShowBreaks(data)
+	end
+end
+
+local function RefreshTask(data, buttons)
+	local ok, err = pcall(RefreshViews, data, buttons)
+	data.refreshing = false
+	if not ok then error(err) end
+end
+
 function GuiRender.Present(data, width, height)
 	local ImGui   = ImGuiLib
 	local GdbData = GdbData
@@ -70,6 +213,7 @@ function GuiRender.Present(data, width, height)
 		{ id        = "Locals",
 		  args      = { "-stack-list-locals 1" },
 		  parse     = GdbData.UpdateLocals, 
+		  parse_mi  = GdbData.UpdateLocalsMi,
 		  upd_frame = false, 
 		  invisible = true,
 		  mod_args  = nil,
@@ -82,6 +226,7 @@ function GuiRender.Present(data, width, height)
 						"@after", 
 						"\" -- 0" },
 		  parse     = GdbData.UpdateAsm, 
+		  parse_mi  = GdbData.UpdateAsmMi,
 		  upd_frame = false, 
 		  invisible = true,
 		  mod_args  = GdbData.ParseDataInput,
@@ -91,6 +236,7 @@ function GuiRender.Present(data, width, height)
 		{ id        = "Backtrace",
 		  args      = { "-stack-list-frames" },
 		  parse     = GdbData.UpdateBacktrace, 
+		  parse_mi  = GdbData.UpdateBacktraceMi,
 		  upd_frame = false, 
 		  invisible = true,
 		  mod_args  = nil,
@@ -107,6 +253,7 @@ function GuiRender.Present(data, width, height)
 		{ id        = "Register Values",
 		  args      = { "-data-list-register-values r 1" },
 		  parse     = GdbData.UpdateRegisters, 
+		  parse_mi  = GdbData.UpdateRegistersMi,
 		  upd_frame = true, 
 		  invisible = true,
 		  mod_args  = GdbData.SetupRegisterDataCmd,
@@ -181,6 +328,8 @@ function GuiRender.Present(data, width, height)
 			"run > "..ROOT_DIR.."gdbmi_output.txt"))
 	elseif ImGui.IsKeyPressed("e") and ImGui.IsKeyPressed("ctrl") then
 		data.open_dialog_exe = true
+	elseif ImGui.IsKeyPressed("p") and ImGui.IsKeyPressed("ctrl") then
+		data.finder.open = true
 	end
 
 	---------------------------------------------------------------------------
@@ -191,13 +340,57 @@ function GuiRender.Present(data, width, height)
 	elseif data.open_dialog_exe then
 		ImGui.OpenPopup("Open Executable to Debug")
 		data.open_dialog_exe = false
+	elseif data.finder.open then
+		ImGui.OpenPopup("Go to File or Function")
+		data.finder.open  = false
+		data.finder.focus = true
+	end
+
+	------------------------------------------------------------------------
+	-- Ctrl-P : fuzzy finder over the inferior's files & functions
+
+	if ImGui.BeginPopup("Go to File or Function") then
+		local finder = data.finder
+		if finder.focus then
+			ImGui.SetKeyboardFocusHere()
+			finder.focus = false
+		end
+
+		local enter
+		ImGui.PushItemWidth(width * 0.5)
+		enter, finder.query = ImGui.InputTextWithHint("##finder_query",
+			"file or function", finder.query, imgui.enums.text.EnterReturnsTrue)
+		ImGui.PopItemWidth()
+
+		-- the index may still be growing
+		local indexed, busy = FuzzyFinder.Progress()
+		if finder.query ~= finder.last_query or busy then
+			finder.results    = FuzzyFinder.Query(finder.query)
+			finder.last_query = finder.query
+		end
+		ImGui.TextDisabled(string.format("%d indexed%s", indexed,
+			busy and ", indexing ..." or ""))
+
+		finder_sz.x, finder_sz.y = width * 0.5, height * 0.4
+		local rows = ImGui.DrawTable("##finder_results", finder_clmns,
+			finder.results, { size = finder_sz, selectable = true })
+		local pick = rows and finder.results[rows[1]]
+			or (enter and finder.results[1])
+		if pick then
+			GdbData.UpdateFile(
+				data, pick.short, pick.file, pick.line, 0, data.open_file.func)
+			ImGui.CloseCurrentPopup()
+		end
+
+		ImGui.EndPopup()
 	end
 
 	------------------------------------------------------------------------
 	-- load exe to gdb and set temp breakpoint in main
 
-	local ename <const> = FileDialog(
-		"Open Executable to Debug", { width * 0.7, height * 0.5 } )
+	dlg_sz.x, dlg_sz.y = width * 0.7, height * 0.5
+
+	local ename <const> = FileDialog("Open Executable to Debug", dlg_sz)
 	if ename then
 		data.exe_filename = ename
 		if data.user_args.ExeStart == nil then
@@ -205,29 +398,32 @@ function GuiRender.Present(data, width, height)
 		else
 			data.user_args.ExeStart.exe = ename
 		end
+		Session.Set(data, "ExeStart")
 
 		ImGui.CloseCurrentPopup()
 		ImGui.OpenPopup("Executable Startup Settings")
 	end
 
-	local fname <const> = FileDialog("Open File", { width * 0.7, height * 0.5 } )
+	local fname <const> = FileDialog("Open File", dlg_sz)
 	if fname then
 		GdbData.UpdateFile(data, fname, fname, 1, 0, "")
 	end
 
 	local clicked, _ = ImGui.BeginPopupModal("Executable Startup Settings")
 	if clicked then
+		local exe_changed, args_changed
 		ImGui.Text("Executable: "); ImGui.SameLine()
 		ImGui.PushItemWidth(-1)
-		_, data.user_args.ExeStart.exe = ImGui.InputText(
+		exe_changed, data.user_args.ExeStart.exe = ImGui.InputText(
 			"##exe_name", data.user_args.ExeStart.exe)
 		ImGui.PopItemWidth()
 
 		ImGui.Text("Arguments : "); ImGui.SameLine()
 		ImGui.PushItemWidth(-1)
-		_, data.user_args.ExeStart.args = ImGui.InputText(
+		args_changed, data.user_args.ExeStart.args = ImGui.InputText(
 			"##exe_args", data.user_args.ExeStart.args)
 		ImGui.PopItemWidth()
+		if exe_changed or args_changed then Session.Set(data, "ExeStart") end
 
 		ImGui.Separator()
 		if ImGui.Button("Start") then
@@ -247,10 +443,11 @@ function GuiRender.Present(data, width, height)
 	
 	ImGui.Begin(string.format("%s###CodeWnd", data.open_file.short))
 
+	-- data.press : a button clicked by a script (see BenchScenario)
 	for _, val in ipairs(buttons) do
 		if (val.invisible == false) then
 			ImGui.SameLine()
-			if ImGui.Button(val.id) then
+			if ImGui.Button(val.id) or data.press == val.id then
 				if val.mod_args then
 					val.parse(data, ExecuteCmd(table.concat(val.mod_args(data, val), "")))
 				else
@@ -264,36 +461,43 @@ function GuiRender.Present(data, width, height)
 			end
 			-- user input
 			if data.user_args[val.id] then
+				ImGui.PushID(val.id)
 				for user_i, user_v in ipairs(data.user_args[val.id]) do
 					ImGui.Text(" - "); ImGui.SameLine()
 
-					_, user_v.val = ImGui.InputTextWithHint(
-						"##"..val.id..user_i, user_v.id, user_v.val)
+					local changed
+					changed, user_v.val = ImGui.InputTextWithHint(user_i, user_v.id, user_v.val)
+					if changed then Session.Set(data, val.id) end
 				end
+				ImGui.PopID()
 			end
 		end
 	end
 
+	data.press = nil
+
 	-- right click menu
 	if ImGui.IsMouseReleased(imgui.enums.mouse.Right) then
 		ImGui.OpenPopup("ContextMenu")
 	end
 
 	if ImGui.BeginPopup("ContextMenu") then
-		local line_num = GetEditorFileLineNum()
-		ImGui.Text(string.format("%s : %d", data.open_file.short, line_num + 1))
+		-- the selected tab may show another file than the one gdb is in
+		local line_num, file = GetEditorFileLineNum()
+		file = file or data.open_file.full
+		ImGui.Text(string.format("%s : %d", file:match("[^/]*$"), line_num + 1))
 
 		ImGui.Separator()
 
 		if ImGui.Button("Insert Breakpoint at cursor") then
-			ExecuteCmd("-break-insert --source "..data.open_file.full..
+			ExecuteCmd("-break-insert --source "..file..
 				" --line "..(line_num + 1))
 			GdbData.ParseBreakpoints(data, ExecuteCmd("-break-list"))
 
 			ImGui.CloseCurrentPopup()
 		end
 		if ImGui.Button("Insert Temporary Breakpoint at cursor") then
-			ExecuteCmd("-break-insert -t --source "..data.open_file.full..
+			ExecuteCmd("-break-insert -t --source "..file..
 				" --line "..(line_num + 1))
 			GdbData.ParseBreakpoints(data, ExecuteCmd("-break-list"))
 
@@ -301,7 +505,7 @@ function GuiRender.Present(data, width, height)
 		end
 		if ImGui.Button("Continue until cursor") then
 			print(ExecuteCmd(string.format(
-				"-exec-until %s:%d", data.open_file.full, line_num + 1)))
+				"-exec-until %s:%d", file, line_num + 1)))
 			trigger_updates = true
 			ImGui.CloseCurrentPopup()
 		end
@@ -311,6 +515,14 @@ function GuiRender.Present(data, width, height)
 
 	if data.open_file.is_open then
 		ShowTextEditor()
+
+		local expr = GetEditorHover()
+		local value = GdbData.HoverValue(data, expr)
+		if value then
+			ImGui.BeginTooltip()
+			ImGui.Text(expr.." = "..value)
+			ImGui.EndTooltip()
+		end
 	end
 
 	ImGui.End()
@@ -328,29 +540,51 @@ function GuiRender.Present(data, width, height)
 
 	ImGui.Text("Status symbols: t = temporary, w = watchpoint")
 
-	local tbl_sz = ImGui.GetWindowSize()
+	-- session restore runs in a GdbTask (see GdbData.LoadSettings)
+	local restore = data.restore
+	if restore and restore.finished == false then
+		ImGui.ProgressBar(restore.total > 0 and restore.done / restore.total or 1,
+			string.format("restoring breakpoints %d/%d", restore.done, restore.total))
+	elseif restore and #restore.failed > 0 then
+		ImGui.TextColored(error_col, string.format(
+			"%d breakpoint(s) could not be restored", #restore.failed))
+		ImGui.SameLine()
+		if ImGui.Button("Dismiss") then data.restore = nil end
+		if ImGui.TreeNode("details##restore") then
+			for _, failed in ipairs(restore.failed) do
+				ImGui.Text(string.format("%s:%s : %s",
+					failed.file or "?", failed.line or "?", failed.msg))
+			end
+			ImGui.TreePop()
+		end
+	elseif restore then
+		data.restore = nil
+	end
+
+	local tbl_sz = ImGui.GetWindowSize(win_sz)
 	tbl_sz[2] = tbl_sz[2] - 90
 	if ImGui.BeginTable("##BreakPts", 7, tbl_sz) then
 		ImGui.TableNextRow()
 		ImGui.TableSetColumnIndex(0)
-		ImGui.TextColored({ 1.0, 1, 1, 0.5 }, " ")
+		ImGui.TextColored(header_col, " ")
 		ImGui.TableSetColumnIndex(1)
-		ImGui.TextColored({ 1.0, 1, 1, 0.5 }, "hit")
+		ImGui.TextColored(header_col, "hit")
 		ImGui.TableSetColumnIndex(2)
-		ImGui.TextColored({ 1.0, 1, 1, 0.5 }, "status")
+		ImGui.TextColored(header_col, "status")
 		ImGui.TableSetColumnIndex(3)
-		ImGui.TextColored({ 1.0, 1, 1, 0.5 }, "file")
+		ImGui.TextColored(header_col, "file")
 		ImGui.TableSetColumnIndex(4)
-		ImGui.TextColored({ 1.0, 1, 1, 0.5 }, "line")
+		ImGui.TextColored(header_col, "line")
 		ImGui.TableSetColumnIndex(5)
-		ImGui.TextColored({ 1.0, 1, 1, 0.5 }, "Conditional"..spacing20)
+		ImGui.TextColored(header_col, "Conditional"..spacing20)
 
 		for i, brk_pt in ipairs(data.user_args.Breaks) do
 			ImGui.TableNextRow()
+			ImGui.PushID(i)
 
 			local is_active = false
 			ImGui.TableSetColumnIndex(0)
-			clicked, is_active = ImGui.CheckBox("##bkpt_flag"..i, brk_pt.enabled == "y")
+			clicked, is_active = ImGui.CheckBox("##bkpt_flag", brk_pt.enabled == "y")
 			if clicked and (is_active == false) then
 				ExecuteCmd(string.format("-break-disable %d", tonumber(brk_pt.number)))
 				GdbData.ParseBreakpoints(data, ExecuteCmd("-break-list"))
@@ -378,7 +612,7 @@ function GuiRender.Present(data, width, height)
 				ImGui.TableSetColumnIndex(5)
 				ImGui.PushItemWidth(-1)
 				clicked, brk_pt.cond = ImGui.InputText(
-					"##bkpt_cond"..i, brk_pt.cond, imgui.enums.text.EnterReturnsTrue)
+					"##bkpt_cond", brk_pt.cond, imgui.enums.text.EnterReturnsTrue)
 				ImGui.PopItemWidth()
 				if clicked then
 					-- edit conditional
@@ -388,16 +622,17 @@ function GuiRender.Present(data, width, height)
 			end
 
 			ImGui.TableSetColumnIndex(6)
-			if ImGui.Button("Delete##brk_pt"..i) then
+			if ImGui.Button("Delete") then
 				-- remove breakpoint
 				ExecuteCmd(string.format("-break-delete %d", tonumber(brk_pt.number)))
 				GdbData.ParseBreakpoints(data, ExecuteCmd("-break-list"))
 			end
 			ImGui.SameLine()
-			if ImGui.Button("Goto##brk_pt"..i) then
+			if ImGui.Button("Goto") then
 				GdbData.UpdateFile(
 					data, brk_pt.file, brk_pt.fullname, brk_pt.line, 0, brk_pt.func)
 			end
+			ImGui.PopID()
 		end
 		ImGui.EndTable()
 	end
@@ -406,55 +641,95 @@ function GuiRender.Present(data, width, height)
 
 	------------------------------------------------------------------------
 	
-	ImGui.Begin("CallStack")
-
-	ImGui.NewLine()
+	ImGui.Begin("Search")
+
+	-- files are scanned on SourceSearch's threads, hits stream in every frame
+	local search = data.search
+	local enter, changed
+	ImGui.PushItemWidth(200)
+	enter, search.pattern = ImGui.InputTextWithHint("##search_pattern", "symbol",
+		search.pattern, imgui.enums.text.EnterReturnsTrue)
+	ImGui.PopItemWidth()
+	ImGui.SameLine()
+	changed, search.regex = ImGui.CheckBox("regex", search.regex)
+	ImGui.SameLine()
+	changed, search.ignore_case = ImGui.CheckBox("ignore case", search.ignore_case)
+
+	local search_in = nil
+	if ImGui.Button("In exec sources") or (enter and search.root == "") then
+		search_in = GdbData.ExecSourceFiles(
+			ExecuteCmd("-file-list-exec-source-files"))
+	end
+	ImGui.SameLine()
+	if ImGui.Button("Under root") or (enter and search.root ~= "") then
+		search_in = search.root
+	end
+	ImGui.SameLine()
+	ImGui.PushItemWidth(-1)
+	changed, search.root = ImGui.InputTextWithHint("##search_root", "directory",
+		search.root)
+	ImGui.PopItemWidth()
+
+	if search_in and search.pattern ~= "" then
+		local ok, err = SourceSearch.Start(search.pattern, search_in,
+			{ regex = search.regex, ignore_case = search.ignore_case })
+		search.hits     = {}
+		search.selected = nil
+		search.error    = not ok and err or nil
+		search.busy     = ok
+	end
 
-	local tbl_sz = ImGui.GetWindowSize()
-	tbl_sz[2] = tbl_sz[2] - 60
-	if #data.asm > 0 then
-		if ImGui.BeginTable("##bktrace", 5, tbl_sz) then
-			ImGui.TableNextRow()
-			ImGui.TableSetColumnIndex(1)
-			ImGui.TextColored({ 1.0, 1, 1, 0.5 }, "address")
-			ImGui.TableSetColumnIndex(2)
-			ImGui.TextColored({ 1.0, 1, 1, 0.5 }, "function")
-			ImGui.TableSetColumnIndex(3)
-			ImGui.TextColored({ 1.0, 1, 1, 0.5 }, "line")
-			ImGui.TableSetColumnIndex(4)
-			ImGui.TextColored({ 1.0, 1, 1, 0.5 }, "file")
-
-			local bk_frame = {}
-			for i in ipairs(data.bktrace) do 
-				bk_frame[#bk_frame + 1] = data.curr_stack_frame == i
-			end
+	local files_done, files_total, truncated = 0, 0, false
+	if search.busy then
+		for _, hit in ipairs(SourceSearch.Poll()) do
+			search.hits[#search.hits + 1] = hit
+		end
+	end
+	files_done, files_total, search.busy, truncated = SourceSearch.Progress()
 
-			for i, stack_frame in ipairs(data.bktrace) do
-				ImGui.TableNextRow()
+	if search.error then
+		ImGui.TextColored(error_col, search.error)
+	else
+		ImGui.Text(string.format("%d hits, %d/%d files%s", #search.hits,
+			files_done, files_total, truncated and " (stopped at the max)" or ""))
+	end
+	if search.busy then
+		ImGui.SameLine()
+		if ImGui.Button("Cancel") then SourceSearch.Cancel() end
+	end
 
-				ImGui.TableSetColumnIndex(0)
-				clicked, _ = ImGui.CheckBox("##bktr_box"..i, bk_frame[i])
-				if clicked and (bk_frame[i] == false) then
-					data.curr_stack_frame = i
-				end
+	local hits_sz = ImGui.GetWindowSize(win_sz)
+	hits_sz[2] = hits_sz[2] - 85
+	local rows = ImGui.DrawTable("##search_hits", search_clmns, search.hits, {
+		size = hits_sz, selectable = true, selected = search.selected })
+	if rows then
+		local hit = search.hits[rows[1]]
+		search.selected = rows[1]
+		GdbData.UpdateFile(
+			data, hit.short, hit.file, hit.line, 0, data.open_file.func)
+	end
 
-				-- address
-				ImGui.TableSetColumnIndex(1)
-				ImGui.Text(stack_frame.addr)
+	ImGui.End()
 
-				-- function
-				ImGui.TableSetColumnIndex(2)
-				ImGui.Text(stack_frame.func)
+	------------------------------------------------------------------------
+	
+	ImGui.Begin("CallStack")
 
-				-- line
-				ImGui.TableSetColumnIndex(3)
-				ImGui.Text(stack_frame.line)
+	-- a tab that stays on the frame while the first one follows gdb
+	local sel_frame = data.bktrace[data.curr_stack_frame]
+	if ImGui.Button("Open frame in new tab") and sel_frame
+		and sel_frame.fullname and sel_frame.line then
+		OpenEditorTab(sel_frame.fullname, tonumber(sel_frame.line))
+		GdbData.ShowBreaks(data)
+	end
 
-				-- file
-				ImGui.TableSetColumnIndex(4)
-				ImGui.Text(stack_frame.file)
-			end
-			ImGui.EndTable()
+	local tbl_sz = ImGui.GetWindowSize(win_sz)
+	tbl_sz[2] = tbl_sz[2] - 60
+	if #data.asm > 0 then
+		local frames = ImGui.DrawTable("##bktrace", bktrace_clmns, data.bktrace, {
+			size = tbl_sz, selectable = true, selected = data.curr_stack_frame })
+		if frames then
+			data.curr_stack_frame = frames[1]
 		end
 	end
 
@@ -484,25 +759,12 @@ function GuiRender.Present(data, width, height)
 	------------------------------------------------------------------------
 	
 	if trigger_updates then
-		for _, val in ipairs(buttons) do
-			if val.auto_upd then
-				if val.mod_args then
-					val.parse(data, ExecuteCmd(table.concat(val.mod_args(data, val), "")))
-				else
-					val.parse(data, ExecuteCmd(table.concat(val.args, "")))
-				end
-			end
-		end
-
-		-- watch window
-		for i, watch_data in ipairs(data.user_args.Watch) do
-			if watch_data.expr ~= "" then
-				local val = GdbData.UpdateWatchExpr(
-					data, ExecuteCmd("-data-evaluate-expression "..watch_data.expr))
-				watch_data.value = val == "" and watch_data.value or val
-			end
+		data.stop_gen = data.stop_gen + 1
+		data.refresh_queued = true
+		if not data.refreshing then
+			data.refreshing = true
+			GdbTask(RefreshTask, data, buttons)
 		end
-		GdbData.ShowBreaks(data)
 	end
 
 	------------------------------------------------------------------------
@@ -523,44 +785,13 @@ function GuiRender.Present(data, width, height)
 	local txt = "Retrieve type info (requires round trip thru GDB)"
 	clicked, data.user_args.FetchTypes = ImGui.CheckBox(txt, data.user_args.FetchTypes)
 	if clicked then
+		Session.Set(data, "FetchTypes")
 		GdbData.GetVCard(data.local_vars)
 	end
 
-	tbl_sz = ImGui.GetWindowSize()
+	tbl_sz = ImGui.GetWindowSize(win_sz)
 	tbl_sz[2] = tbl_sz[2] - 60
-	if ImGui.BeginTable("##local_vars", 3, tbl_sz) then
-		ImGui.TableNextRow()
-		ImGui.TableSetColumnIndex(0)
-		ImGui.TextColored({ 1.0, 1, 1, 0.5 }, "name")
-		ImGui.TableSetColumnIndex(1)
-		ImGui.TextColored({ 1.0, 1, 1, 0.5 }, "type")
-		ImGui.TableSetColumnIndex(2)
-		ImGui.TextColored({ 1.0, 1, 1, 0.5 }, string.format(
-			"data%s%s%s", spacing20, spacing20, spacing20))
-
-		for i, var in ipairs(data.local_vars) do
-			ImGui.TableNextRow()
-
-			-- name
-			ImGui.TableSetColumnIndex(0)
-			ImGui.Text(var.name)
-
-			-- type
-			if var.vtype then
-				ImGui.TableSetColumnIndex(1)
-				ImGui.Text(var.vtype)
-			end
-
-			-- value
-			if var.value then
-				ImGui.TableSetColumnIndex(2)
-				ImGui.PushItemWidth(-1)
-				ImGui.InputText("##lv_item"..i, var.value, imgui.enums.text.ReadOnly)
-				ImGui.PopItemWidth()
-			end
-		end
-		ImGui.EndTable()
-	end
+	ImGui.DrawTable("##local_vars", locals_clmns, data.local_vars, { size = tbl_sz })
 
 	--ImGui.TextWrapped(data.local_vars_txt)
 
@@ -570,75 +801,45 @@ function GuiRender.Present(data, width, height)
 	
 	ImGui.Begin("ASM")
 
-	if #data.asm > 0 then
-		-- must exist
-		local curr_pc = data.bktrace[data.curr_stack_frame].addr
-
-		tbl_sz = ImGui.GetWindowSize()
-		tbl_sz[2] = tbl_sz[2] - 30
-		if ImGui.BeginTable("##asm", 5, tbl_sz) then
-
-			for _, val in ipairs(buttons) do
-				if val.id == "Disassembly" then
-					for i, user_v in ipairs(data.user_args[val.id]) do
-						ImGui.TableNextRow()
+	-- the refresh task fills the listing before the backtrace
+	local curr_frame = data.bktrace[data.curr_stack_frame]
+	if #data.asm > 0 and curr_frame then
+		local curr_pc = curr_frame.addr
 
-						ImGui.TableSetColumnIndex(1)
-						ImGui.Text(" - bytes "..user_v.id..": ")
-						ImGui.TableSetColumnIndex(2)
+		for _, val in ipairs(buttons) do
+			if val.id == "Disassembly" then
+				for i, user_v in ipairs(data.user_args[val.id]) do
+					ImGui.Text(" - bytes "..user_v.id..": "); ImGui.SameLine()
 
-						ImGui.PushItemWidth(-1)
-						_, user_v.val = ImGui.InputText("##"..val.id..i, user_v.val)
-						ImGui.PopItemWidth()
+					ImGui.PushItemWidth(100)
+					clicked, user_v.val = ImGui.InputText(i, user_v.val)
+					ImGui.PopItemWidth()
+					if clicked then Session.Set(data, val.id) end
 
-						ImGui.TableSetColumnIndex(3)
-						ImGui.TextColored({ 1.0, 1, 1, 0.5 }, "offset $PC")
-					end
-					break
+					ImGui.SameLine()
+					ImGui.TextColored(header_col, "offset $PC")
 				end
+				break
 			end
+		end
 
-			ImGui.TableNextRow()
-			ImGui.TableSetColumnIndex(1)
-			ImGui.TextColored({ 1.0, 1, 1, 0.5 }, "address")
-			ImGui.TableSetColumnIndex(2)
-			ImGui.TextColored({ 1.0, 1, 1, 0.5 }, "offset")
-			ImGui.TableSetColumnIndex(3)
-			ImGui.TextColored({ 1.0, 1, 1, 0.5 }, "instruction")
-			ImGui.TableSetColumnIndex(4)
-			ImGui.TextColored({ 1.0, 1, 1, 0.5 }, "function")
-
-			for _, asm in ipairs(data.asm) do
-				ImGui.TableNextRow()
-
-				-- location marker
+		-- location marker : only searched for when the listing or pc changes
+		if data.asm_pc ~= curr_pc or data.asm_pc_src ~= data.asm then
+			data.asm_pc     = curr_pc
+			data.asm_pc_src = data.asm
+			data.asm_pc_row = 0
+			for i, asm in ipairs(data.asm) do
 				if asm.address == curr_pc then
-					ImGui.TableSetColumnIndex(0)
-					ImGui.Text(">")
-				end
-
-				-- address
-				ImGui.TableSetColumnIndex(1)
-				ImGui.Text(asm.address)
-
-				-- offset
-				if asm.offset then
-					ImGui.TableSetColumnIndex(2)
-					ImGui.Text(asm.offset)
-				end
-
-				-- instruction
-				ImGui.TableSetColumnIndex(3)
-				ImGui.Text(asm.inst)
-
-				-- function
-				if asm.func then
-					ImGui.TableSetColumnIndex(4)
-					ImGui.Text(asm.func)
+					data.asm_pc_row = i
+					break
 				end
 			end
-			ImGui.EndTable()
 		end
+
+		tbl_sz = ImGui.GetWindowSize(win_sz)
+		tbl_sz[2] = tbl_sz[2] - 80
+		ImGui.DrawTable("##asm", asm_clmns, data.asm, {
+			size = tbl_sz, selected = data.asm_pc_row })
 	end
 
 	ImGui.End()
@@ -653,32 +854,9 @@ function GuiRender.Present(data, width, height)
 			ExecuteCmd(table.concat(GdbData.SetupRegisterDataCmd(data, val), "")))
 	end
 
-	tbl_sz = ImGui.GetWindowSize()
-	if ImGui.BeginTable("##registers", 2, tbl_sz) then
-		ImGui.TableNextRow()
-		ImGui.TableSetColumnIndex(0)
-		ImGui.TextColored({ 1.0, 1, 1, 0.5 }, "name")
-		ImGui.TableSetColumnIndex(1)
-		ImGui.TextColored({ 1.0, 1, 1, 0.5 }, "data"..spacing20..spacing20)
-
-		if data.registers then
-			for _, reg in pairs(data.registers) do
-				ImGui.TableNextRow()
-
-				-- name
-				ImGui.TableSetColumnIndex(0)
-				ImGui.Text(reg.id)
-
-				-- value
-				ImGui.TableSetColumnIndex(1)
-				ImGui.PushItemWidth(-1)
-				ImGui.InputText(
-					"##reg_item"..reg.number, reg.value, imgui.enums.text.ReadOnly)
-				ImGui.PopItemWidth()
-			end
-		end
-		ImGui.EndTable()
-	end
+	tbl_sz = ImGui.GetWindowSize(win_sz)
+	ImGui.DrawTable("##registers", register_clmns, data.register_list or {}, {
+		size = tbl_sz })
 
 	ImGui.End()
 
@@ -692,6 +870,7 @@ function GuiRender.Present(data, width, height)
 	for i, watch_data in ipairs(data.user_args.Watch) do
 		if watch_data.expr ~= "" then compact_l[#compact_l + 1] = watch_data end
 	end
+	if #compact_l + 1 ~= #data.user_args.Watch then Session.Set(data, "Watch") end
 	data.user_args.Watch = compact_l
 	data.user_args.Watch[#data.user_args.Watch + 1] = { expr = "", value = "" }
 
@@ -704,29 +883,31 @@ function GuiRender.Present(data, width, height)
 	local expr_space = {}
 	for i = 1, longest_expr, 1 do expr_space[#expr_space + 1] = " " end
 
-	tbl_sz = ImGui.GetWindowSize()
+	tbl_sz = ImGui.GetWindowSize(win_sz)
 	tbl_sz[2] = tbl_sz[2] - 60 -- shrink in y-axis
 	if ImGui.BeginTable("##watch", 2, tbl_sz) then
 		ImGui.TableNextRow()
 		ImGui.TableSetColumnIndex(0)
-		ImGui.TextColored({ 1.0, 1, 1, 0.5 }, "expr      "..table.concat(expr_space))
+		ImGui.TextColored(header_col, "expr      "..table.concat(expr_space))
 		ImGui.TableSetColumnIndex(1)
-		ImGui.TextColored({ 1.0, 1, 1, 0.5 }, string.format(
+		ImGui.TextColored(header_col, string.format(
 			"data%s%s%s", spacing20, spacing20, spacing20))
 
 		for i, watch_data in ipairs(data.user_args.Watch) do
 			ImGui.TableNextRow()
+			ImGui.PushID(i)
 
 			ImGui.TableSetColumnIndex(0)
 			local in_expr = watch_data.expr
 
 			ImGui.PushItemWidth(-1)
 			clicked, in_expr = ImGui.InputText(
-				"##watche"..i, in_expr, imgui.enums.text.EnterReturnsTrue)
+				"##watche", in_expr, imgui.enums.text.EnterReturnsTrue)
 			ImGui.PopItemWidth()
 			if clicked then
 				-- update specific watch value
 				watch_data.expr = in_expr
+				Session.Set(data, "Watch")
 				local val = GdbData.UpdateWatchExpr(
 					data, ExecuteCmd("-data-evaluate-expression "..watch_data.expr))
 				watch_data.value = val == "" and watch_data.value or val
@@ -734,8 +915,9 @@ function GuiRender.Present(data, width, height)
 
 			ImGui.TableSetColumnIndex(1)
 			ImGui.PushItemWidth(-1)
-			ImGui.InputText("##watchv"..i, watch_data.value, imgui.enums.text.ReadOnly)
+			ImGui.InputText("##watchv", watch_data.value, imgui.enums.text.ReadOnly)
 			ImGui.PopItemWidth()
+			ImGui.PopID()
 		end
 
 		ImGui.EndTable()
@@ -760,6 +942,7 @@ function GuiRender.Present(data, width, height)
 			mem_cmd = val
 
 			clicked, mem_settings.active = ImGui.CheckBox("Track", mem_settings.active)
+			if clicked then Session.Set(data, "MemView") end
 			if mem_settings.active then
 				val.parse(data, ExecuteCmd(table.concat(val.mod_args(data, val), "")))
 			end
@@ -769,84 +952,37 @@ function GuiRender.Present(data, width, height)
 			-- TODO : Maybe fix imgui functions so that I don't need to keep transforming
 			-- ReadFBufferFromLua is greedy and is currently hardcoded to 4
 
-			local v4 = { mem_settings.bPerColumn, mem_settings.nColumns }
+			mem_v.x, mem_v.y = mem_settings.bPerColumn, mem_settings.nColumns
 
 			ImGui.PushItemWidth(-1)
-			_, v4 = ImGui.SliderFloat2("##mem_input", v4, 1.0, 20.0, "%g")
+			if ImGui.SliderFloat2("##mem_input", mem_v, 1.0, 20.0, "%g") then
+				Session.Set(data, "MemView")
+			end
 			ImGui.PopItemWidth()
 
-			mem_settings.bPerColumn = math.floor(v4[1])
-			mem_settings.nColumns = math.floor(v4[2])
+			mem_settings.bPerColumn = math.floor(mem_v.x)
+			mem_settings.nColumns = math.floor(mem_v.y)
 		end
 	end
 
-	tbl_sz = ImGui.GetWindowSize()
+	tbl_sz = ImGui.GetWindowSize(win_sz)
 	tbl_sz[1] = tbl_sz[1] - 3 -- shrink in x-axis
-	tbl_sz[2] = tbl_sz[2] - 60 -- shrink in y-axis
-	if mem_cmd and ImGui.BeginTable("##memory", mem_settings.nColumns + 2, tbl_sz) then
-		-- Each memory unit in gdb is 8 bits
-		-- bPerColumn are the # of hex values per column
-		-- Each hex value represents up to 16 bits (i.e. 2 bytes)
-		-- so request size per column is (bPerColumn * 8 * 2)
-		local mem_unit = mem_settings.bPerColumn * 8 * 2
-
+	tbl_sz[2] = tbl_sz[2] - 85 -- shrink in y-axis
+	if mem_cmd then
 		for i, user_v in ipairs(data.user_args[mem_cmd.id]) do
-			ImGui.TableNextRow()
-
-			ImGui.TableSetColumnIndex(1)
-			ImGui.PushItemWidth(-1)
-			_, user_v.val = ImGui.InputTextWithHint(
-				"##"..mem_cmd.id..i, user_v.id, user_v.val)
+			ImGui.PushItemWidth(150)
+			clicked, user_v.val = ImGui.InputTextWithHint(i, user_v.id, user_v.val)
 			ImGui.PopItemWidth()
+			if clicked then Session.Set(data, mem_cmd.id) end
+			ImGui.SameLine()
 		end
+		ImGui.NewLine()
 
-		ImGui.TableNextRow()
-		ImGui.TableSetColumnIndex(1)
-		ImGui.TextColored({ 1.0, 1, 1, 0.5 }, "address          ")
-		for i = 1, mem_settings.nColumns, 1 do
-			ImGui.TableSetColumnIndex(i + 1)
-			ImGui.TextColored({ 1.0, 1, 1, 0.5 }, " "..(i - 1).." ")
-		end
-
-		if data.memory.contents then
-			local total_digits = data.memory.contents:len()
-			local max_rows = math.ceil(
-				total_digits / (mem_settings.bPerColumn * mem_settings.nColumns))
-
-			local h_cntr = 1
-			for irow = 1, max_rows, 1 do
-				ImGui.TableNextRow()
-				ImGui.TableSetColumnIndex(0)
-				ImGui.TextColored({ 1.0, 1, 1, 0.5 }, irow - 1)
-
-				if irow == 1 then
-					ImGui.TableSetColumnIndex(1)
-					ImGui.Text(data.memory.begin)
-				end
-
-				-- write backwards because of big endian formatting
-				for iclmn = mem_settings.nColumns, 1, -1 do
-					ImGui.TableSetColumnIndex(iclmn + 1)
-
-					local out_hex = { "0x" }
-					for ihex = mem_settings.bPerColumn, 1, -1 do
-						if total_digits >= h_cntr then
-							out_hex[ihex + 1] = tostring(
-								data.memory.contents:sub(h_cntr, h_cntr))
-						else
-							out_hex[ihex + 1] = "0"
-						end
-
-						h_cntr = h_cntr + 1
-					end
-					ImGui.Text(table.concat(out_hex))
-				end
-			end
-			ImGui.TableNextRow()
-			ImGui.TableSetColumnIndex(1)
-			ImGui.Text(data.memory.last)
-		end
-		ImGui.EndTable()
+		-- Each memory unit in gdb is 8 bits
+		-- bPerColumn are the # of hex values per column
+		-- Each hex value represents up to 16 bits (i.e. 2 bytes)
+		local mem_clmns, mem_rows = GetMemoryRows(data.memory, mem_settings)
+		ImGui.DrawTable("##memory", mem_clmns, mem_rows, { size = tbl_sz })
 	end
 
 	ImGui.End()
@@ -1588,7 +1588,7 @@ function OBJDEF:new(args)
 	 return setmetatable(new, OBJDEF)
 end
 
-package.loaded["Json"] = OBJDEF:new()
+package.loaded["JsonLua"] = OBJDEF:new()
 
 return OBJDEF:new()
 
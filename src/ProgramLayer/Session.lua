@@ -0,0 +1,214 @@
+-- Crash-safe session state. Changes to data.user_args are announced with
+-- Session.Set(data, path) and appended to an on-disk journal once per frame
+-- by Session.Flush. Lists are diffed per element so toggling one breakpoint
+-- writes one small record. Every so often the whole state is handed to the
+-- SessionJournal worker thread as a snapshot, the journal then only holds
+-- what changed since. "Load Last Session" replays snapshot + journal.
+--
+-- Journal lines : {"seq":n,"path":["Breaks",3],"value":{...}}
+--                 {"seq":n,"path":["Breaks"],"len":2}   (list shrank)
+-- Snapshot      : {"seq":n,"session":{...user_args...}}
+
+local Json = require "Json"
+
+local Session = {
+	live = nil,      -- file prefix this run writes to
+	last = nil,      -- file prefix of the previous run
+	seq = 0,
+	pending = {},    -- path key -> path, coalesced until the end of the frame
+	journaled = {},  -- path key -> encoded value (or list of them) on disk
+	records = 0,     -- since the last snapshot
+	bytes = 0,
+	snapshot_due = false,
+}
+
+local SNAPSHOT_RECORDS = 1000
+local SNAPSHOT_BYTES = 512 * 1024
+local FILE_SUFFIXES = { ".json", ".journal.old", ".journal" }
+
+local function Lookup(tbl, path)
+	for _, key in ipairs(path) do
+		if type(tbl) ~= "table" then return nil end
+		tbl = tbl[key]
+	end
+	return tbl
+end
+
+local function IsList(value)
+	return type(value) == "table" and (value[1] ~= nil or next(value) == nil)
+end
+
+local function Record(lines, path, field, value_txt)
+	Session.seq = Session.seq + 1
+	lines[#lines + 1] = string.format("{\"seq\":%d,\"path\":%s,\"%s\":%s}\n",
+		Session.seq, Json:encode(path), field, value_txt)
+end
+
+local function RecordChanges(lines, key, path, value)
+	local prev = Session.journaled[key]
+
+	if IsList(value) then
+		prev = type(prev) == "table" and prev or {}
+		local encoded = {}
+		for i = 1, #value do
+			encoded[i] = Json:encode(value[i])
+			if encoded[i] ~= prev[i] then
+				local elem_path = { table.unpack(path) }
+				elem_path[#elem_path + 1] = i
+				Record(lines, elem_path, "value", encoded[i])
+			end
+		end
+		if #value < #prev or Session.journaled[key] == nil then
+			Record(lines, path, "len", tostring(#value))
+		end
+		Session.journaled[key] = encoded
+	else
+		local encoded = Json:encode(value)
+		if encoded ~= prev then
+			Record(lines, path, "value", encoded)
+			Session.journaled[key] = encoded
+		end
+	end
+end
+
+local function Snapshot(data)
+	local state = Json:encode({ seq = Session.seq, session = data.user_args })
+	if SessionJournal.Snapshot(state) then
+		Session.records, Session.bytes = 0, 0
+		Session.snapshot_due = false
+	else
+		Session.snapshot_due = true -- previous one still being written
+	end
+end
+
+local function Apply(state, rec)
+	local path = rec.path
+	if type(path) ~= "table" or #path == 0 then return end
+
+	local tbl = state
+	for i = 1, #path - 1 do
+		if type(tbl[path[i]]) ~= "table" then tbl[path[i]] = {} end
+		tbl = tbl[path[i]]
+	end
+
+	local key = path[#path]
+	if rec.len then
+		if type(tbl[key]) ~= "table" then tbl[key] = {} end
+		local list = tbl[key]
+		for i = #list, rec.len + 1, -1 do list[i] = nil end
+	else
+		tbl[key] = rec.value
+	end
+end
+
+--------------------------------------------------------------------------------
+
+-- Starts this run's journal. Whatever the previous run left behind (clean
+-- exit or not) becomes the "last session"
+function Session.Open(prefix, last_prefix)
+	if Session.live then return end
+
+	local found = false
+	for _, suffix in ipairs(FILE_SUFFIXES) do
+		local file = io.open(prefix..suffix, "r")
+		if file then
+			file:close()
+			found = true
+		end
+	end
+	if found then
+		for _, suffix in ipairs(FILE_SUFFIXES) do
+			os.remove(last_prefix..suffix)
+			os.rename(prefix..suffix, last_prefix..suffix)
+		end
+	end
+
+	Session.live, Session.last = prefix, last_prefix
+	if SessionJournal.Open(prefix) == false then
+		print("Session journal unavailable : "..prefix..".journal")
+	end
+end
+
+-- Records the value at data.user_args[path[1]][path[2]]... (path may be a
+-- single key) when the frame ends
+function Session.Set(data, path)
+	if type(path) ~= "table" then path = { path } end
+	Session.pending[table.concat(path, ".")] = path
+end
+
+function Session.Flush(data)
+	if next(Session.pending) then
+		local lines = {}
+		for key, path in pairs(Session.pending) do
+			RecordChanges(lines, key, path, Lookup(data.user_args, path))
+		end
+		Session.pending = {}
+
+		if #lines > 0 then
+			local batch = table.concat(lines)
+			SessionJournal.Append(batch)
+
+			Session.records = Session.records + #lines
+			Session.bytes = Session.bytes + #batch
+			if Session.records >= SNAPSHOT_RECORDS or Session.bytes >= SNAPSHOT_BYTES then
+				Session.snapshot_due = true
+			end
+		end
+	end
+
+	if Session.snapshot_due and SessionJournal.Busy() == false then
+		Snapshot(data)
+	end
+end
+
+-- Rebuilds the previous run's user_args from its snapshot & journal. Returns
+-- nil if it left nothing behind
+function Session.LoadLast()
+	local prefix = Session.last
+	if prefix == nil then return nil end
+
+	local state, seq = nil, 0
+	local ok, snap = pcall(Json.decode_file, Json, prefix..".json")
+	if ok and type(snap) == "table" then
+		if snap.session then
+			state, seq = snap.session, snap.seq or 0
+		else
+			state = snap -- written before there was a journal
+		end
+	end
+
+	for _, suffix in ipairs({ ".journal.old", ".journal" }) do
+		local file = io.open(prefix..suffix, "r")
+		if file then
+			state = state or {}
+			for line in file:lines() do
+				-- a crash can leave the last line cut short
+				local valid, rec = pcall(Json.decode, Json, line)
+				if valid and type(rec) == "table" and (rec.seq or 0) > seq then
+					Apply(state, rec)
+				end
+			end
+			file:close()
+		end
+	end
+
+	return state
+end
+
+-- The whole state changed (e.g. a session was loaded) : start the journal
+-- over from a snapshot of it
+function Session.Reset(data)
+	Session.pending = {}
+	Session.journaled = {}
+	Session.snapshot_due = true
+	Session.Flush(data)
+end
+
+function Session.Close(data)
+	Session.Flush(data)
+	SessionJournal.Close()
+end
+
+package.loaded["Session"] = Session
+
+return Session
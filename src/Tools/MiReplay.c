@@ -0,0 +1,465 @@
+// Stand-in for gdb that serves a transcript written w/ GdbVkGui --record.
+// Start the frontend w/ --gdb bin/MiReplay, it is launched like gdb so the
+// options are passed through the environment :
+//   MIREPLAY_FILE   transcript to serve (required)
+//   MIREPLAY_SPEED  "recorded" (default) keeps the recorded delays between a
+//                   command & its output, "max" writes the output right away
+//
+// Commands are matched in recorded order, their token aside. A command that
+// was not recorded next is looked up further on & the ones in between are
+// skipped, but never past a command that resumed the inferior. Failing that a
+// command served earlier (the ui polls at its own frame rate) gets its last
+// result again, anything else is answered w/ ^error.
+// Each command releases the output gdb sent before the next command went out
+// (async records included), and always at least its own result record, which
+// gets the token of the live command.
+
+#include "ProcessIO.h"
+#include "UtilityMacros.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct MiLine
+{
+    size_t   m_Offset;
+    uint32_t m_Sz; // w/o the newline
+    uint32_t m_CmdCount; // commands sent before the line was received
+    uint64_t m_Usecs;
+} MiLine;
+
+typedef struct MiStream
+{
+    char*   m_Text;
+    size_t  m_TextSz;
+    MiLine* m_Lines;
+    size_t  m_LineCount;
+    size_t  m_LineMax;
+    size_t  m_LineStart; // of the line being received
+} MiStream;
+
+static MiStream s_sent;
+static MiStream s_received;
+
+static size_t* s_results; // received line of each command's result record
+static size_t  s_result_count;
+
+static bool s_max_speed;
+
+//-----------------------------------------------------------------------------
+
+static void
+FailExit(const char* msg, const char* detail)
+{
+    fprintf(stderr, "MiReplay: %s %s\n", msg, detail ? detail : "");
+    _exit(1);
+}
+
+static void*
+Grow(void* ptr, size_t* count_max, size_t elem_sz)
+{
+    *count_max = MAX(*count_max * 2, 1024);
+    ptr        = realloc(ptr, *count_max * elem_sz);
+    if (ptr == NULL) {
+        FailExit("out of memory", NULL);
+    }
+    return ptr;
+}
+
+// Appends a chunk to the stream, every line it completes is stamped w/ the
+// chunk's time
+static void
+AppendChunk(MiStream* stream, const char* data, uint32_t data_sz, uint64_t t)
+{
+    memcpy(stream->m_Text + stream->m_TextSz, data, data_sz);
+    size_t end = stream->m_TextSz + data_sz;
+
+    for (size_t i = stream->m_TextSz; i < end; i++) {
+        if (stream->m_Text[i] != '\n') {
+            continue;
+        }
+        if (stream->m_LineCount == stream->m_LineMax) {
+            stream->m_Lines =
+              Grow(stream->m_Lines, &stream->m_LineMax, sizeof(MiLine));
+        }
+        MiLine* line     = &stream->m_Lines[stream->m_LineCount++];
+        line->m_Offset   = stream->m_LineStart;
+        line->m_Sz       = (uint32_t)(i - stream->m_LineStart);
+        line->m_CmdCount = (uint32_t)s_sent.m_LineCount;
+        line->m_Usecs    = t;
+
+        stream->m_LineStart = i + 1;
+    }
+    stream->m_TextSz = end;
+}
+
+static const char*
+SkipToken(const char* text, uint32_t* text_sz)
+{
+    const char* start = text;
+    while (text < start + *text_sz && *text >= '0' && *text <= '9') {
+        text++;
+    }
+    *text_sz -= (uint32_t)(text - start);
+    return text;
+}
+
+static bool
+IsResultRecord(const char* text, uint32_t text_sz)
+{
+    text = SkipToken(text, &text_sz);
+    return text_sz && *text == '^';
+}
+
+static void
+LoadTranscript(const char* fname)
+{
+    FILE* file = fopen(fname, "rb");
+    if (file == NULL) {
+        FailExit("failed to open transcript", fname);
+    }
+    fseek(file, 0, SEEK_END);
+    size_t file_sz = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char* contents = malloc(file_sz + 1);
+    if (contents == NULL || fread(contents, 1, file_sz, file) != file_sz) {
+        FailExit("failed to read transcript", fname);
+    }
+    fclose(file);
+    contents[file_sz] = 0;
+
+    size_t header_sz = strlen(MI_TRANSCRIPT_HEADER);
+    if (file_sz <= header_sz ||
+        memcmp(contents, MI_TRANSCRIPT_HEADER, header_sz)) {
+        FailExit("not a transcript", fname);
+    }
+
+    // the streams are at most as large as the file
+    s_sent.m_Text     = malloc(file_sz);
+    s_received.m_Text = malloc(file_sz);
+    if (s_sent.m_Text == NULL || s_received.m_Text == NULL) {
+        FailExit("out of memory", NULL);
+    }
+
+    size_t offset = header_sz + 1;
+    while (offset < file_sz) {
+        char     dir      = 0;
+        uint64_t usecs    = 0;
+        uint32_t chunk_sz = 0;
+        int      entry_sz = 0;
+        // not "\n%n", it would also skip whitespace the chunk starts w/
+        if (sscanf(contents + offset,
+                   "%c %" SCNu64 " %u%n",
+                   &dir,
+                   &usecs,
+                   &chunk_sz,
+                   &entry_sz) != 3 ||
+            contents[offset + entry_sz] != '\n' ||
+            offset + entry_sz + 1 + chunk_sz > file_sz) {
+            fprintf(stderr, "MiReplay: transcript cut short, %s\n", fname);
+            break;
+        }
+        offset += entry_sz + 1;
+
+        MiStream* stream = dir == '>' ? &s_sent : &s_received;
+        AppendChunk(stream, contents + offset, chunk_sz, usecs);
+        offset += chunk_sz + 1;
+    }
+    free(contents);
+
+    size_t results_max = 0;
+    for (size_t i = 0; i < s_received.m_LineCount; i++) {
+        const MiLine* line = &s_received.m_Lines[i];
+        if (IsResultRecord(s_received.m_Text + line->m_Offset, line->m_Sz)) {
+            if (s_result_count == results_max) {
+                s_results = Grow(s_results, &results_max, sizeof(size_t));
+            }
+            s_results[s_result_count++] = i;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Serving
+
+#define NOT_RECORDED SIZE_MAX // line of a command's ^error reply
+#define PROMPT (SIZE_MAX - 1)
+
+typedef struct Scheduled
+{
+    size_t   m_Line;
+    uint64_t m_Due;
+    char     m_Token[16]; // of the live command, result records only
+} Scheduled;
+
+static Scheduled* s_queue;
+static size_t     s_queue_head;
+static size_t     s_queue_count;
+static size_t     s_queue_max;
+
+static size_t s_next_cmd;  // recorded command expected next
+static size_t s_next_line; // first received line not queued yet
+
+static void
+WriteAll(const char* data, size_t data_sz)
+{
+    while (data_sz) {
+        ssize_t wout = write(STDOUT_FILENO, data, data_sz);
+        if (wout < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            _exit(0); // the frontend is gone
+        }
+        data += wout;
+        data_sz -= wout;
+    }
+}
+
+static void
+QueueLine(size_t line_idx, uint64_t due, const char* token)
+{
+    if (s_queue_count == s_queue_max) {
+        s_queue = Grow(s_queue, &s_queue_max, sizeof(Scheduled));
+    }
+    Scheduled* entry = &s_queue[s_queue_count++];
+    entry->m_Line    = line_idx;
+    entry->m_Due     = due;
+    snprintf(entry->m_Token, sizeof(entry->m_Token), "%s", token ? token : "");
+}
+
+// Queues the output released by recorded command cmd_idx, timed from now
+static void
+ReleaseOutput(size_t cmd_idx, const char* token)
+{
+    uint64_t now      = GetHighResTime();
+    uint64_t cmd_t    = s_sent.m_Lines[cmd_idx].m_Usecs;
+    size_t   result   = cmd_idx < s_result_count ? s_results[cmd_idx] : 0;
+    uint64_t last_due = s_queue_count ? s_queue[s_queue_count - 1].m_Due : 0;
+
+    while (s_next_line < s_received.m_LineCount) {
+        const MiLine* line = &s_received.m_Lines[s_next_line];
+        bool own_result    = cmd_idx < s_result_count && s_next_line <= result;
+        if (own_result == false && line->m_CmdCount > cmd_idx + 1) {
+            break;
+        }
+
+        uint64_t due = now;
+        if (s_max_speed == false && line->m_Usecs > cmd_t) {
+            due += (line->m_Usecs - cmd_t) * 1000;
+        }
+        last_due = MAX(due, last_due); // keep the recorded order
+
+        bool is_result = s_next_line == result && cmd_idx < s_result_count;
+        QueueLine(s_next_line, last_due, is_result ? token : NULL);
+        s_next_line++;
+    }
+}
+
+static bool
+SameCommand(size_t cmd_idx, const char* cmd, uint32_t cmd_sz)
+{
+    const MiLine* line    = &s_sent.m_Lines[cmd_idx];
+    uint32_t      line_sz = line->m_Sz;
+    const char*   text = SkipToken(s_sent.m_Text + line->m_Offset, &line_sz);
+
+    return line_sz == cmd_sz && memcmp(text, cmd, cmd_sz) == 0;
+}
+
+// Result record of a recorded command w/o its token (empty if gdb never
+// answered it)
+static const char*
+ResultOf(size_t cmd_idx, uint32_t* result_sz)
+{
+    *result_sz = 0;
+    if (cmd_idx >= s_result_count) {
+        return "";
+    }
+    const MiLine* line = &s_received.m_Lines[s_results[cmd_idx]];
+    *result_sz         = line->m_Sz;
+    return SkipToken(s_received.m_Text + line->m_Offset, result_sz);
+}
+
+static bool
+ResumesInferior(size_t cmd_idx)
+{
+    uint32_t    result_sz = 0;
+    const char* result    = ResultOf(cmd_idx, &result_sz);
+    return result_sz >= 8 && memcmp(result, "^running", 8) == 0;
+}
+
+// Next recorded occurrence of the command. The search doesn't go past a
+// command that resumed the inferior, execution is never skipped
+static size_t
+FindAhead(const char* cmd, uint32_t cmd_sz)
+{
+    for (size_t i = s_next_cmd; i < s_sent.m_LineCount; i++) {
+        if (SameCommand(i, cmd, cmd_sz)) {
+            return i;
+        }
+        if (ResumesInferior(i)) {
+            break;
+        }
+    }
+    return NOT_RECORDED;
+}
+
+static size_t
+FindServed(const char* cmd, uint32_t cmd_sz)
+{
+    for (size_t i = s_next_cmd; i-- > 0;) {
+        if (SameCommand(i, cmd, cmd_sz) && i < s_result_count) {
+            return i;
+        }
+    }
+    return NOT_RECORDED;
+}
+
+static void
+ServeCommand(const char* line, uint32_t line_sz)
+{
+    char        token[16] = { 0 };
+    uint32_t    cmd_sz    = line_sz;
+    const char* cmd       = SkipToken(line, &cmd_sz);
+    snprintf(token, sizeof(token), "%.*s", (int)(cmd - line), line);
+
+    uint64_t last_due = s_queue_count ? s_queue[s_queue_count - 1].m_Due : 0;
+    uint64_t now      = MAX(GetHighResTime(), last_due);
+
+    size_t cmd_idx = FindAhead(cmd, cmd_sz);
+    if (cmd_idx == NOT_RECORDED) {
+        // the frontend polls more often than it did when recording : a
+        // command already served gets the same answer again
+        size_t served = FindServed(cmd, cmd_sz);
+        if (served == NOT_RECORDED) {
+            fprintf(stderr, "MiReplay: not recorded: %.*s\n", line_sz, line);
+        }
+        QueueLine(served == NOT_RECORDED ? NOT_RECORDED : s_results[served],
+                  now,
+                  token);
+        QueueLine(PROMPT, now, NULL);
+        return;
+    }
+
+    // drop the output of skipped commands, up to their last result record
+    if (cmd_idx > s_next_cmd && cmd_idx - 1 < s_result_count) {
+        s_next_line = MAX(s_next_line, s_results[cmd_idx - 1] + 1);
+    }
+    s_next_cmd = cmd_idx + 1;
+
+    ReleaseOutput(cmd_idx, token);
+}
+
+static void
+WriteQueued(const Scheduled* entry)
+{
+    if (entry->m_Line == NOT_RECORDED) {
+        const char* reply = "^error,msg=\"MiReplay: not recorded\"\n";
+        WriteAll(entry->m_Token, strlen(entry->m_Token));
+        WriteAll(reply, strlen(reply));
+        return;
+    }
+    if (entry->m_Line == PROMPT) {
+        WriteAll("(gdb) \n", 7);
+        return;
+    }
+
+    const MiLine* line = &s_received.m_Lines[entry->m_Line];
+    const char*   text = s_received.m_Text + line->m_Offset;
+    uint32_t      sz   = line->m_Sz;
+
+    if (IsResultRecord(text, sz)) {
+        const char* rest = SkipToken(text, &sz);
+        WriteAll(entry->m_Token, strlen(entry->m_Token));
+        WriteAll(rest, sz);
+    } else {
+        WriteAll(text, sz);
+    }
+    WriteAll("\n", 1);
+}
+
+// Writes every queued line that is due. Returns the ms until the next one
+// (-1 : nothing queued)
+static int
+FlushDue(void)
+{
+    uint64_t now = GetHighResTime();
+    while (s_queue_head < s_queue_count) {
+        const Scheduled* entry = &s_queue[s_queue_head];
+        if (entry->m_Due > now) {
+            return (int)((entry->m_Due - now) / 1000000) + 1;
+        }
+        WriteQueued(entry);
+        s_queue_head++;
+    }
+    s_queue_head  = 0;
+    s_queue_count = 0;
+    return -1;
+}
+
+int
+main(int argc, char* argv[])
+{
+    UNUSED_VAR(argc);
+    UNUSED_VAR(argv); // gdb's options
+
+    const char* fname = getenv("MIREPLAY_FILE");
+    const char* speed = getenv("MIREPLAY_SPEED");
+    if (fname == NULL) {
+        FailExit("MIREPLAY_FILE is not set", NULL);
+    }
+    s_max_speed = speed && strcmp(speed, "max") == 0;
+
+    LoadTranscript(fname);
+
+    // whatever gdb printed before the first command
+    uint64_t now = GetHighResTime();
+    while (s_next_line < s_received.m_LineCount &&
+           s_received.m_Lines[s_next_line].m_CmdCount == 0) {
+        QueueLine(s_next_line++, now, NULL);
+    }
+
+    char*  input     = malloc(0x1 << 16);
+    size_t input_sz  = 0;
+    size_t input_max = 0x1 << 16;
+
+    struct pollfd in_fd = { .fd = STDIN_FILENO, .events = POLLIN };
+    while (true) {
+        int wait_ms = FlushDue();
+        if (poll(&in_fd, 1, wait_ms) <= 0) {
+            continue;
+        }
+
+        if (input_sz == input_max) {
+            input = Grow(input, &input_max, 1);
+        }
+        ssize_t read_bytes =
+          read(STDIN_FILENO, input + input_sz, input_max - input_sz);
+        if (read_bytes == 0) {
+            break; // the frontend closed its end
+        }
+        if (read_bytes < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        input_sz += read_bytes;
+
+        size_t line_start = 0;
+        for (size_t i = 0; i < input_sz; i++) {
+            if (input[i] == '\n') {
+                ServeCommand(input + line_start, (uint32_t)(i - line_start));
+                line_start = i + 1;
+            }
+        }
+        memmove(input, input + line_start, input_sz - line_start);
+        input_sz -= line_start;
+    }
+
+    return 0;
+}
@@ -0,0 +1,245 @@
+// Colours the source viewer gives to a few lines, checked a column at a time,
+// & what's looked up on top of them. Run bin/SourceLexerTest after build.sh,
+// it prints what's off & exits w/ 1 when there's anything
+
+#include "Frontend/SourceLexer.h"
+#include "Frontend/SourceView.h"
+#include <stdio.h>
+#include <string.h>
+
+using PaletteIndex = TextEditor::PaletteIndex;
+
+struct ColorCheck
+{
+    uint32_t     m_Line; // 0 based
+    uint32_t     m_Column;
+    PaletteIndex m_Color;
+    bool         m_Preproc;
+};
+
+static const char s_c_text[] =
+  "int a;  // trailing comment\n"
+  "    // indented comment\n"
+  "int b; /* block */ int c;\n"
+  "  #define X 1\n"
+  "\t#include <stdio.h>\n"
+  "int d; \t/* open\n"
+  "   still open */ d++;\n"
+  "const char* s = \" // not a comment \";\n";
+
+static const ColorCheck s_c_checks[] = {
+    { 0, 0, PaletteIndex::Keyword, false },
+    { 0, 4, PaletteIndex::Identifier, false },
+    { 0, 8, PaletteIndex::Comment, false },
+    { 0, 11, PaletteIndex::Comment, false },
+    { 1, 4, PaletteIndex::Comment, false },
+    { 1, 10, PaletteIndex::Comment, false },
+    { 2, 7, PaletteIndex::MultiLineComment, false },
+    { 2, 10, PaletteIndex::MultiLineComment, false },
+    { 2, 19, PaletteIndex::Keyword, false },
+    { 2, 23, PaletteIndex::Identifier, false },
+    { 3, 2, PaletteIndex::Preprocessor, true },
+    { 3, 10, PaletteIndex::Identifier, true },
+    { 4, 1, PaletteIndex::Preprocessor, true },
+    { 5, 8, PaletteIndex::MultiLineComment, false },
+    { 6, 3, PaletteIndex::MultiLineComment, false },
+    { 6, 17, PaletteIndex::Identifier, false },
+    { 7, 17, PaletteIndex::String, false },
+    { 7, 20, PaletteIndex::String, false },
+};
+
+static const char s_asm_text[] =
+  "main:\n"
+  "    movl %eax, %ebx  # trailing comment\n"
+  "    # indented comment\n"
+  "    ret\n";
+
+static const ColorCheck s_asm_checks[] = {
+    { 1, 4, PaletteIndex::Identifier, false },
+    { 1, 9, PaletteIndex::KnownIdentifier, false },
+    { 1, 21, PaletteIndex::Comment, false },
+    { 1, 23, PaletteIndex::Comment, false },
+    { 2, 4, PaletteIndex::Comment, false },
+    { 3, 4, PaletteIndex::Identifier, false },
+};
+
+//------------------------------------------------------------------------------
+static uint32_t
+RunChecks(const char*                           name,
+          const TextEditor::LanguageDefinition& def,
+          const char*                           text,
+          const ColorCheck*                     checks,
+          size_t                                check_count)
+{
+    SourceDocument doc{}; // zeroed, SourceLoad unloads it first
+    const SourceLanguage* lang = GetSourceLanguage(def);
+    if (!SourceLoad(doc, text, strlen(text), lang, nullptr)) {
+        printf("%s : not loaded\n", name);
+        return 1;
+    }
+    SourceRequestLines(doc, 0, SourceLineCount(doc), 5000.0);
+
+    uint32_t failed = 0;
+    for (size_t i = 0; i < check_count; i++) {
+        const ColorCheck& check = checks[i];
+
+        uint32_t         nspans = 0;
+        const ColorSpan* spans  = SourceLineSpans(doc, check.m_Line, &nspans);
+        uint32_t         color  = (uint32_t)-1;
+        for (uint32_t j = 0; spans && j < nspans; j++) {
+            if (spans[j].m_Column <= check.m_Column)
+                color = spans[j].m_Color;
+        }
+
+        uint32_t want = (uint32_t)check.m_Color |
+                        (check.m_Preproc ? SPAN_PREPROC : 0);
+        if (color != want) {
+            printf("%s : line %u column %u is %d%s, expected %d%s\n",
+                   name,
+                   check.m_Line + 1,
+                   check.m_Column + 1,
+                   (int)(color & ~SPAN_PREPROC),
+                   color & SPAN_PREPROC ? " (preprocessor)" : "",
+                   (int)check.m_Color,
+                   check.m_Preproc ? " (preprocessor)" : "");
+            failed++;
+        }
+    }
+
+    SourceUnload(doc);
+    return failed;
+}
+
+//------------------------------------------------------------------------------
+static const char s_inline_text[] =
+  "int x = y + 1; // z in a comment\n"
+  "    /* z */ p->y = x;\n"
+  "s.x = \"z\";\n"
+  "#define W z\n";
+
+static const char* s_inline_expected[] = {
+    "  x = 1, y = 2",
+    "  x = 1",
+    "",
+    "",
+};
+
+static uint32_t
+RunInlineChecks(void)
+{
+    SourceDocument doc{};
+    SourceLoad(doc,
+               s_inline_text,
+               strlen(s_inline_text),
+               GetSourceLanguage(SourceLexerC()),
+               nullptr);
+    SourceRequestLines(doc, 0, SourceLineCount(doc), 5000.0);
+
+    SourceInlineValues values;
+    values.m_FirstLine   = 0;
+    values.m_LastLine    = SourceLineCount(doc);
+    values.m_Values["x"] = "1";
+    values.m_Values["y"] = "2";
+    values.m_Values["z"] = "3";
+
+    uint32_t failed = 0;
+    uint32_t count = sizeof(s_inline_expected) / sizeof(s_inline_expected[0]);
+    for (uint32_t line = 0; line < count; line++) {
+        std::string text = SourceInlineText(doc, values, line);
+        if (text != s_inline_expected[line]) {
+            printf("Inline values : line %u is \"%s\", expected \"%s\"\n",
+                   line + 1,
+                   text.c_str(),
+                   s_inline_expected[line]);
+            failed++;
+        }
+    }
+
+    SourceUnload(doc);
+    return failed;
+}
+
+//------------------------------------------------------------------------------
+static const char s_hover_text[] =
+  "int n = p->pos[0] + s.v; // n & p in a comment\n"
+  "    /* p */ n++;\n";
+
+struct HoverCheck
+{
+    uint32_t    m_Line; // 0 based
+    uint32_t    m_Column;
+    const char* m_Expr; // "" : none
+};
+
+static const HoverCheck s_hover_checks[] = {
+    { 0, 0, "" },           // int
+    { 0, 4, "n" },
+    { 0, 8, "p" },
+    { 0, 12, "p->pos" },
+    { 0, 13, "p->pos" },
+    { 0, 14, "" },          // [
+    { 0, 20, "s" },
+    { 0, 22, "s.v" },
+    { 0, 28, "" },          // n in the comment
+    { 0, 32, "" },          // p in the comment
+    { 1, 7, "" },           // p in the block comment
+    { 1, 12, "n" },
+};
+
+static uint32_t
+RunHoverChecks(void)
+{
+    SourceDocument doc{};
+    SourceLoad(doc,
+               s_hover_text,
+               strlen(s_hover_text),
+               GetSourceLanguage(SourceLexerC()),
+               nullptr);
+    SourceRequestLines(doc, 0, SourceLineCount(doc), 5000.0);
+
+    uint32_t failed = 0;
+    for (const HoverCheck& check : s_hover_checks) {
+        uint32_t    sz;
+        const char* text = SourceLine(doc, check.m_Line, &sz);
+
+        std::string expr;
+        uint32_t    first, last;
+        if (SourceExpressionAt(
+              doc, check.m_Line, check.m_Column, &first, &last))
+            expr.assign(text + first, text + last);
+
+        if (expr != check.m_Expr) {
+            printf("Hover : line %u column %u is \"%s\", expected \"%s\"\n",
+                   check.m_Line + 1,
+                   check.m_Column + 1,
+                   expr.c_str(),
+                   check.m_Expr);
+            failed++;
+        }
+    }
+
+    SourceUnload(doc);
+    return failed;
+}
+
+//------------------------------------------------------------------------------
+int
+main(void)
+{
+    uint32_t failed = 0;
+    failed += RunChecks("C",
+                        SourceLexerC(),
+                        s_c_text,
+                        s_c_checks,
+                        sizeof(s_c_checks) / sizeof(s_c_checks[0]));
+    failed += RunChecks("Asm",
+                        SourceLexerAsm(),
+                        s_asm_text,
+                        s_asm_checks,
+                        sizeof(s_asm_checks) / sizeof(s_asm_checks[0]));
+    failed += RunInlineChecks();
+    failed += RunHoverChecks();
+
+    printf("%s (%u failed)\n", failed ? "FAILED" : "OK", failed);
+    return failed ? 1 : 0;
+}
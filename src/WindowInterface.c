@@ -1,4 +1,5 @@
 #include "WindowInterface.h"
+#include "UtilityMacros.h"
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -514,3 +515,245 @@ AppRequestClipBoardData(AppWindowData* win)
 
     return win->m_ClipBoard;
 }
+
+//-----------------------------------------------------------------------------
+// Headless window : no X connection, input comes from a script instead
+//
+// One event per line, "<frame> <event> [args]", '#' starts a comment :
+//   12 move 300 140       mouse position
+//   12 down MOUSE_LEFT    key or button held from this frame on
+//   14 up MOUSE_LEFT
+//   20 press KEY_RETURN   down for one frame
+//   21 char x             typed character
+//   30 wheel -2           scroll (negative is down)
+//   40 size 1920 1080     resize
+//   99 quit
+// Key & button names are the KEY_TYPES/MOUSE_TYPES names in KeyTypes.inl
+
+typedef enum ScriptEventType
+{
+    SCRIPT_MOVE,
+    SCRIPT_DOWN,
+    SCRIPT_UP,
+    SCRIPT_PRESS,
+    SCRIPT_CHAR,
+    SCRIPT_WHEEL,
+    SCRIPT_SIZE,
+    SCRIPT_QUIT,
+} ScriptEventType;
+
+typedef struct ScriptEvent
+{
+    uint64_t        m_Frame;
+    uint32_t        m_Line;
+    ScriptEventType m_Type;
+    int64_t         m_X;
+    int64_t         m_Y;
+} ScriptEvent;
+
+static ScriptEvent* s_script;
+static uint32_t     s_script_count;
+static uint32_t     s_script_next;
+static uint64_t     s_script_frame;
+static uint32_t     s_release_idx[16]; // pressed last frame
+static uint32_t     s_release_count;
+
+static int
+FindKeyIdx(const char* name)
+{
+    for (int i = 0; i < MAX_KEYS; i++) {
+        if (s_keysym_data[i].key && strcmp(s_keysym_data[i].key, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int
+CompareScriptEvents(const void* lhs, const void* rhs)
+{
+    const ScriptEvent* a = (const ScriptEvent*)lhs;
+    const ScriptEvent* b = (const ScriptEvent*)rhs;
+    if (a->m_Frame != b->m_Frame) {
+        return a->m_Frame < b->m_Frame ? -1 : 1;
+    }
+    return a->m_Line < b->m_Line ? -1 : (a->m_Line > b->m_Line);
+}
+
+static bool
+ParseScriptLine(const char* line, uint32_t line_num, ScriptEvent* evt)
+{
+    unsigned long long frame   = 0;
+    char               verb[16] = { 0 };
+    char               arg[64]  = { 0 };
+    long long          x = 0, y = 0;
+
+    if (sscanf(line, "%llu %15s %63s", &frame, verb, arg) < 2) {
+        return false;
+    }
+    evt->m_Frame = frame;
+    evt->m_Line  = line_num;
+    evt->m_X     = 0;
+    evt->m_Y     = 0;
+
+    if (strcmp(verb, "move") == 0 || strcmp(verb, "size") == 0) {
+        if (sscanf(line, "%*u %*s %lld %lld", &x, &y) != 2) {
+            return false;
+        }
+        evt->m_Type = verb[0] == 'm' ? SCRIPT_MOVE : SCRIPT_SIZE;
+        evt->m_X    = x;
+        evt->m_Y    = y;
+    } else if (strcmp(verb, "down") == 0 || strcmp(verb, "up") == 0 ||
+               strcmp(verb, "press") == 0) {
+        int idx = FindKeyIdx(arg);
+        if (idx < 0) {
+            return false;
+        }
+        evt->m_Type = verb[0] == 'd'   ? SCRIPT_DOWN
+                      : verb[0] == 'u' ? SCRIPT_UP
+                                       : SCRIPT_PRESS;
+        evt->m_X = idx;
+    } else if (strcmp(verb, "char") == 0) {
+        if (arg[0] == '\0') {
+            return false;
+        }
+        evt->m_Type = SCRIPT_CHAR;
+        evt->m_X    = arg[0];
+    } else if (strcmp(verb, "wheel") == 0) {
+        evt->m_Type = SCRIPT_WHEEL;
+        evt->m_Y    = strtoll(arg, NULL, 10);
+    } else if (strcmp(verb, "quit") == 0) {
+        evt->m_Type = SCRIPT_QUIT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool
+LoadInputScript(const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Failed to open input script: %s\n", path);
+        return false;
+    }
+
+    uint32_t capacity = 0;
+    uint32_t line_num = 0;
+    char     line[256];
+    while (fgets(line, sizeof(line), file)) {
+        line_num++;
+
+        char* comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        if (strspn(line, " \t\r\n") == strlen(line)) {
+            continue;
+        }
+
+        if (s_script_count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            s_script =
+              (ScriptEvent*)realloc(s_script, capacity * sizeof(ScriptEvent));
+        }
+        if (ParseScriptLine(line, line_num, &s_script[s_script_count])) {
+            s_script_count++;
+        } else {
+            fprintf(stderr, "%s:%u: bad input event: %s", path, line_num, line);
+        }
+    }
+    fclose(file);
+
+    qsort(s_script, s_script_count, sizeof(ScriptEvent), CompareScriptEvents);
+    return true;
+}
+
+int32_t
+AppLoadHeadlessWindow(AppWindowData* win,
+                      uint32_t       width,
+                      uint32_t       height,
+                      const char*    input_script)
+{
+    win->m_ClientW = width;
+    win->m_ClientH = height;
+
+    if (input_script && LoadInputScript(input_script) == false) {
+        return -1;
+    }
+    return 0;
+}
+
+void
+AppProcessScriptedEvents(AppWindowData* win)
+{
+    s_keysym_data[g_KeyIds.WK_MOUSE_SCROLL_UP].triggered   = false;
+    s_keysym_data[g_KeyIds.WK_MOUSE_SCROLL_DOWN].triggered = false;
+    s_keysym_data[g_KeyIds.WK_MOUSE_DELTA].triggered       = false;
+    s_keysym_data[g_KeyIds.WK_MOUSE_DELTA].x               = 0;
+    s_keysym_data[g_KeyIds.WK_MOUSE_DELTA].y               = 0;
+
+    win->m_LastTypedC = '\0';
+
+    for (uint32_t i = 0; i < s_release_count; i++) {
+        s_keysym_data[s_release_idx[i]].triggered = false;
+    }
+    s_release_count = 0;
+
+    struct KeySymData* pos = &s_keysym_data[g_KeyIds.WK_MOUSE_POS];
+    for (; s_script_next < s_script_count &&
+           s_script[s_script_next].m_Frame <= s_script_frame;
+         s_script_next++) {
+        const ScriptEvent* evt = &s_script[s_script_next];
+        switch (evt->m_Type) {
+            case SCRIPT_MOVE: {
+                struct KeySymData* delta =
+                  &s_keysym_data[g_KeyIds.WK_MOUSE_DELTA];
+                delta->triggered = true;
+                delta->x         = evt->m_X - pos->x;
+                delta->y         = evt->m_Y - pos->y;
+
+                pos->triggered = true;
+                pos->x         = evt->m_X;
+                pos->y         = evt->m_Y;
+                break;
+            }
+            case SCRIPT_DOWN:
+            case SCRIPT_UP: {
+                s_keysym_data[evt->m_X].triggered = evt->m_Type == SCRIPT_DOWN;
+                break;
+            }
+            case SCRIPT_PRESS: {
+                s_keysym_data[evt->m_X].triggered = true;
+                if (s_release_count < STATIC_ARRAY_COUNT(s_release_idx)) {
+                    s_release_idx[s_release_count++] = (uint32_t)evt->m_X;
+                }
+                break;
+            }
+            case SCRIPT_CHAR: {
+                win->m_LastTypedC = (char)evt->m_X;
+                break;
+            }
+            case SCRIPT_WHEEL: {
+                if (evt->m_Y > 0) {
+                    s_keysym_data[g_KeyIds.WK_MOUSE_SCROLL_UP].triggered = true;
+                } else if (evt->m_Y < 0) {
+                    s_keysym_data[g_KeyIds.WK_MOUSE_SCROLL_DOWN].triggered =
+                      true;
+                }
+                break;
+            }
+            case SCRIPT_SIZE: {
+                win->m_ClientW = (uint32_t)evt->m_X;
+                win->m_ClientH = (uint32_t)evt->m_Y;
+                break;
+            }
+            case SCRIPT_QUIT: {
+                win->m_CloseWin = true;
+                break;
+            }
+        }
+    }
+    s_script_frame++;
+}
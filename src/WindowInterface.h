@@ -72,6 +72,15 @@ extern "C"
     void        AppProcessWindowEvents(AppWindowData* win);
     const char* AppRequestClipBoardData(AppWindowData* win);
 
+    // No X connection : the client size is fixed (or resized by the script)
+    // & input is replayed from input_script (may be NULL), see
+    // WindowInterface.c for the format
+    int32_t AppLoadHeadlessWindow(AppWindowData* win,
+                                  uint32_t       width,
+                                  uint32_t       height,
+                                  const char*    input_script);
+    void    AppProcessScriptedEvents(AppWindowData* win);
+
 #ifdef __cplusplus
 }
 #endif
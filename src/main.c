@@ -19,8 +19,6 @@
 
 extern const char _binary__tmp_imguisettings_ini_start;
 extern const char _binary__tmp_imguisettings_ini_end;
-extern const char _binary__tmp_prog_luac_start;
-extern const char _binary__tmp_prog_luac_end;
 
 static void
 PrintErr(const char* err_stdout)
@@ -52,6 +50,79 @@ CreateGdbProcess(const char* g_exe, int* f_to_g, int* g_to_f)
     return gdb_process;
 }
 
+typedef struct AppArgs
+{
+    bool        m_Headless;
+    bool        m_CountGeometry;
+    uint32_t    m_Width;
+    uint32_t    m_Height;
+    uint64_t    m_MaxFrames; // 0 : until the app is closed
+    const char* m_InputScript;
+    const char* m_BenchScript;
+    const char* m_BenchOut;
+    const char* m_GdbExe;
+    const char* m_RecordFile;
+} AppArgs;
+
+static void
+PrintUsage(const char* exe)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --headless          run without a window or gpu\n"
+            "  --size WxH          headless display size (default 1280x720)\n"
+            "  --input FILE        replay scripted input events\n"
+            "  --frames N          exit after N frames\n"
+            "  --count-geometry    report vertices & indices per frame\n"
+            "  --bench FILE        run a benchmark scenario (implies headless)\n"
+            "  --bench-out FILE    JSON report of --bench (default bench.json)\n"
+            "  --gdb PATH          gdb executable (default /usr/bin/gdb)\n"
+            "  --record FILE       write the MI session w/ timing to FILE\n",
+            exe);
+    _exit(2);
+}
+
+static void
+ParseArgs(const int argc, const char* argv[], AppArgs* args)
+{
+    for (int i = 1; i < argc; i++) {
+        const char* arg  = argv[i];
+        const char* next = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--headless") == 0) {
+            args->m_Headless = true;
+        } else if (strcmp(arg, "--count-geometry") == 0) {
+            args->m_CountGeometry = true;
+        } else if (strcmp(arg, "--size") == 0 && next) {
+            if (sscanf(next, "%ux%u", &args->m_Width, &args->m_Height) != 2) {
+                PrintUsage(argv[0]);
+            }
+            i++;
+        } else if (strcmp(arg, "--input") == 0 && next) {
+            args->m_InputScript = next;
+            i++;
+        } else if (strcmp(arg, "--bench") == 0 && next) {
+            args->m_BenchScript = next;
+            args->m_Headless    = true;
+            i++;
+        } else if (strcmp(arg, "--bench-out") == 0 && next) {
+            args->m_BenchOut = next;
+            i++;
+        } else if (strcmp(arg, "--gdb") == 0 && next) {
+            args->m_GdbExe = next;
+            i++;
+        } else if (strcmp(arg, "--record") == 0 && next) {
+            args->m_RecordFile = next;
+            i++;
+        } else if (strcmp(arg, "--frames") == 0 && next) {
+            args->m_MaxFrames = strtoull(next, NULL, 10);
+            i++;
+        } else {
+            PrintUsage(argv[0]);
+        }
+    }
+}
+
 static void
 CreateUserDir(void)
 {
@@ -73,21 +144,19 @@ CreateUserDir(void)
     memcpy(filename + home_len, dir_name, dir_len);
     mkdir(filename, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
 
-    const char* files_to_make[2] = {
+    // the lua program is loaded straight from the binary (see GdbFE.cpp)
+    const char* files_to_make[1] = {
         "/.gdbvkgui/imgui.ini",
-        "/.gdbvkgui/prog.luac",
     };
-    const char* data_to_dump[2] = {
+    const char* data_to_dump[1] = {
         &_binary__tmp_imguisettings_ini_start,
-        &_binary__tmp_prog_luac_start,
     };
-    int data_sz[2] = {
+    int data_sz[1] = {
         (int)(&_binary__tmp_imguisettings_ini_end -
               &_binary__tmp_imguisettings_ini_start),
-        (int)(&_binary__tmp_prog_luac_end - &_binary__tmp_prog_luac_start),
     };
 
-    for (int i = 0; i < 2; i++) {
+    for (int i = 0; i < 1; i++) {
         FileInfo f_info = { 0 };
         memset(filename, 0, sizeof(filename));
 
@@ -114,8 +183,16 @@ CreateUserDir(void)
 int
 main(const int argc, const char* argv[])
 {
+    AppArgs args = {
+        .m_Width    = 1280,
+        .m_Height   = 720,
+        .m_BenchOut = "bench.json",
+        .m_GdbExe   = "/usr/bin/gdb",
+    };
+    ParseArgs(argc, argv, &args);
+
     // Make sure gdb is an exe that exists
-    const char* gdb_exe = "/usr/bin/gdb";
+    const char* gdb_exe = args.m_GdbExe;
     if (access(gdb_exe, X_OK)) {
         PrintErr("Failed to find gdb exe: ");
     }
@@ -156,6 +233,10 @@ main(const int argc, const char* argv[])
     // fstate = fstate | O_NONBLOCK;
     // fcntl(fd_gdb_to_frontend[1], F_SETFL, fstate);
 
+    if (args.m_RecordFile && StartMiRecording(args.m_RecordFile) == false) {
+        PrintErr("Failed to open MI recording: ");
+    }
+
     pid_t gdb_process =
       CreateGdbProcess(gdb_exe, fd_frontend_to_gdb, fd_gdb_to_frontend);
 
@@ -177,15 +258,27 @@ main(const int argc, const char* argv[])
 
     // open app window and associated vulkan context
     AppWindowData app_win = { .m_CloseWin = false };
-    AppLoadWindow(&app_win);
-    VkStateBin* vk_ptr = LoadVulkanState(&app_win);
-    SetupGuiContext(vk_ptr, &app_win);
+    if (args.m_Headless) {
+        if (AppLoadHeadlessWindow(
+              &app_win, args.m_Width, args.m_Height, args.m_InputScript)) {
+            _exit(2);
+        }
+        SetupHeadlessGuiContext(&app_win, args.m_CountGeometry);
+    } else {
+        AppLoadWindow(&app_win);
+        VkStateBin* vk_ptr = LoadVulkanState(&app_win);
+        SetupGuiContext(vk_ptr, &app_win);
+    }
 
-    LoadSettings settings = { .m_MaxFileSz = (0x1 << 20) * 5 }; // 5 megabytes
+    LoadSettings settings = {
+        .m_BenchScript = args.m_BenchScript,
+        .m_BenchOut    = args.m_BenchOut,
+    };
     InitFrontend(&settings);
 
-    double frame_time = NanoToSec(GetHighResTime());
-    double fps        = 1.0 / 75.0;
+    double   frame_time  = NanoToSec(GetHighResTime());
+    double   fps         = 1.0 / 75.0;
+    uint64_t frame_count = 0;
     while (close_frontend == false && AppMustExit() == false) {
         // write(STDOUT_FILENO, "\nGdb input: ", 12);
         // char input[128];
@@ -197,25 +290,49 @@ main(const int argc, const char* argv[])
         // 	}
         // }
 
-        AppProcessWindowEvents(&app_win);
+        if (args.m_Headless) {
+            AppProcessScriptedEvents(&app_win);
+        } else {
+            AppProcessWindowEvents(&app_win);
+        }
         close_frontend = app_win.m_CloseWin;
 
         ProcessGuiFrame(&app_win, DrawFrontend);
 
+        frame_count++;
+        if (args.m_MaxFrames && frame_count >= args.m_MaxFrames) {
+            close_frontend = true;
+        }
+
         if (waitpid(gdb_process, &pid_status, WNOHANG) == gdb_process) {
             int wout = write(STDOUT_FILENO, "Gdb exitted.", 11);
             UNUSED_VAR(wout);
             close_frontend = true;
         }
 
-        // dont kill the machine
+        // dont kill the machine (headless runs as fast as it can)
         double slop_time = NanoToSec(GetHighResTime()) - frame_time;
-        if (slop_time < fps) {
+        if (args.m_Headless == false && slop_time < fps) {
             TimedWait(fps - slop_time);
         }
         frame_time = NanoToSec(GetHighResTime());
     }
     ShutdownGui(&app_win, CloseFrontend);
+    StopMiRecording();
+
+    if (args.m_CountGeometry) {
+        const GuiFrameStats* stats = GetGuiFrameStats();
+        uint64_t             div   = MAX(stats->m_Frames, 1);
+        printf("frames %" PRIu64 " vtx/frame %" PRIu64 " idx/frame %" PRIu64
+               " last frame vtx %u idx %u cmds %u\n",
+               stats->m_Frames,
+               stats->m_VtxTotal / div,
+               stats->m_IdxTotal / div,
+               stats->m_VtxCount,
+               stats->m_IdxCount,
+               stats->m_CmdCount);
+        fflush(stdout);
+    }
 
     close(fd_frontend_to_gdb[1]);
 